@@ -0,0 +1,155 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include "Arena.h"
+
+
+Arena *createArena(size_t slabSize)
+{
+  Arena 
+    *result = CALLOC(1, sizeof(Arena));
+  
+  result->slabSize = slabSize; 
+  result->used = slabSize;	/* no slab yet */
+
+  return result; 
+}
+
+
+static void addSlab(Arena *arena, size_t size)
+{
+  if(arena->numberOfSlabs == arena->slabsCapacity)
+    {
+      arena->slabsCapacity = arena->slabsCapacity ? 2 * arena->slabsCapacity : 16; 
+      arena->slabs = realloc(arena->slabs, arena->slabsCapacity * sizeof(char*));
+      arena->slabSizes = realloc(arena->slabSizes, arena->slabsCapacity * sizeof(size_t));
+      arena->spareSlabs = realloc(arena->spareSlabs, arena->slabsCapacity * sizeof(char*));
+      assert(arena->slabs && arena->slabSizes && arena->spareSlabs);
+    }
+
+  /* spare slabs have been zeroed by resetArena */
+  if(size == arena->slabSize && arena->numberOfSpareSlabs > 0)
+    arena->slabs[arena->numberOfSlabs] = arena->spareSlabs[--arena->numberOfSpareSlabs];
+  else 
+    arena->slabs[arena->numberOfSlabs] = CALLOC(size, sizeof(char));
+  arena->slabSizes[arena->numberOfSlabs] = size; 
+  if(NOT arena->slabs[arena->numberOfSlabs])
+    {
+      printf("ERROR: Unable to obtain sufficient memory\n");
+      exit(-1);
+    }
+  arena->numberOfSlabs++;
+}
+
+
+void *arenaAlloc(Arena *arena, size_t size)
+{
+  void 
+    *result; 
+
+  size = ((size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT) * ARENA_ALIGNMENT; 
+
+  /* large objects get a slab of their own, the current slab stays in use */
+  if(size > arena->slabSize)
+    {
+      char 
+	*tmp; 
+      size_t 
+	tmpSize; 
+
+      addSlab(arena, size);
+      if(arena->numberOfSlabs > 1)
+	{
+	  tmp = arena->slabs[arena->numberOfSlabs - 1];
+	  arena->slabs[arena->numberOfSlabs - 1] = arena->slabs[arena->numberOfSlabs - 2];
+	  arena->slabs[arena->numberOfSlabs - 2] = tmp; 
+	  tmpSize = arena->slabSizes[arena->numberOfSlabs - 1];
+	  arena->slabSizes[arena->numberOfSlabs - 1] = arena->slabSizes[arena->numberOfSlabs - 2];
+	  arena->slabSizes[arena->numberOfSlabs - 2] = tmpSize; 
+	  return tmp; 
+	}
+      arena->used = arena->slabSize; 
+      return arena->slabs[0];
+    }
+
+  if(arena->used + size > arena->slabSize)
+    {
+      addSlab(arena, arena->slabSize);
+      arena->used = 0; 
+    }
+
+  result = arena->slabs[arena->numberOfSlabs - 1] + arena->used; 
+  arena->used += size; 
+
+  return result; 
+}
+
+
+/* 
+   slabs of regular size are kept as spare slabs, large objects are
+   released. Only the used part of a slab is zeroed, thus resetting
+   an arena that is used for little is cheap.
+*/
+void resetArena(Arena *arena)
+{
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,arena->numberOfSlabs)
+    {
+      if(arena->slabSizes[i] == arena->slabSize)
+	{
+	  memset(arena->slabs[i], 0, i == arena->numberOfSlabs - 1 ? arena->used : arena->slabSize);
+	  arena->spareSlabs[arena->numberOfSpareSlabs++] = arena->slabs[i];
+	}
+      else 
+	free(arena->slabs[i]);
+    }
+
+  arena->numberOfSlabs = 0; 
+  arena->used = arena->slabSize; 
+}
+
+
+void freeArena(Arena *arena)
+{
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,arena->numberOfSlabs)
+    free(arena->slabs[i]);
+  FOR_0_LIMIT(i,arena->numberOfSpareSlabs)
+    free(arena->spareSlabs[i]);
+  free(arena->slabs);
+  free(arena->spareSlabs);
+  free(arena->slabSizes);
+  free(arena);
+}
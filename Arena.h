@@ -0,0 +1,66 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "common.h"
+
+/* 
+   Many small objects with the same lifetime (e.g., the vectors of all
+   bipartitions) are carved out of large slabs. Memory is zeroed and
+   only released at once with freeArena. resetArena releases all
+   objects, but keeps the slabs for reuse (e.g., for objects that only
+   live for one round).
+*/
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_SLAB_SIZE (1 << 20)
+
+typedef struct
+{
+  char **slabs; 
+  size_t *slabSizes; 
+  int numberOfSlabs; 
+  int slabsCapacity;
+  size_t slabSize; 
+  size_t used;			/* bytes used in the last slab */
+
+  char **spareSlabs;		/* regular slabs kept by resetArena */
+  int numberOfSpareSlabs; 
+} Arena; 
+
+Arena *createArena(size_t slabSize);
+void *arenaAlloc(Arena *arena, size_t size);
+void resetArena(Arena *arena);
+void freeArena(Arena *arena);
+
+#endif
@@ -30,28 +30,21 @@
 
 #include "BitVector.h"
 
-BitVector *mask32;
-
-void initializeMask()
-{
-  int i;
-  mask32 = CALLOC(MASK_LENGTH, sizeof(BitVector));
-  mask32[0] = 1; 
-  
-  for(i = 1; i < MASK_LENGTH; ++i)
-    mask32[i] = mask32[i-1] << 1; 
-}
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_POPCNT_DISPATCH
+#endif
 
+BitVector *mask32;
 
 void printBitVector(BitVector *bv, int length)
 {
   int i ;  
-  for(i = 0; i < length * 32; ++i)
+  for(i = 0; i < length * MASK_LENGTH; ++i)
     printf("%d", NTH_BIT_IS_SET(bv, i) ? 1 : 0);
 }
 
 
-void freeBitVectors(unsigned int **v, int n)
+void freeBitVectors(BitVector **v, int n)
 {
   int i;
 
@@ -73,50 +66,72 @@ boolean areSameBitVectors(BitVector *a, BitVector *b, int bitVectorLength)
 }
 
 
-BitVector genericBitCount(BitVector* bitVector, int bitVectorLength)
+static int portableBitCount(BitVector n)
+{
+  n = n - ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  n = (n + (n >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  
+  return (int)((n * 0x0101010101010101ULL) >> 56);
+}
+
+
+static int portableGenericBitCount(BitVector* bitVector, int bitVectorLength)
 {
-  BitVector 
+  int 
     i, 
     result = 0;
 
   for(i = 0; i < bitVectorLength; i++)
-    result += BIT_COUNT(bitVector[i]);
+    result += portableBitCount(bitVector[i]);
   
   return result; 
 }
 
 
-static int iterated_bitcount(BitVector n)
+#ifdef HAS_POPCNT_DISPATCH
+__attribute__((target("popcnt"))) static int hardwareBitCount(BitVector n)
 {
-    int 
-      count=0;    
-    
-    while(n)
-      {
-        count += n & 0x1u ;    
-        n >>= 1 ;
-      }
-    
-    return count;
+  return __builtin_popcountll(n);
 }
 
-void compute_bits_in_16bits(void)
+
+__attribute__((target("popcnt"))) static int hardwareGenericBitCount(BitVector* bitVector, int bitVectorLength)
 {
-    BitVector i;    
-    
-    for (i = 0; i < (0x1u<<16); i++)
-        bits_in_16bits[i] = iterated_bitcount(i);
-    
-    return ;
+  int 
+    i, 
+    result = 0;
+
+  for(i = 0; i < bitVectorLength; i++)
+    result += __builtin_popcountll(bitVector[i]);
+  
+  return result; 
 }
+#endif
+
+
+int (*bitCount)(BitVector n) = portableBitCount;
+int (*genericBitCount)(BitVector* bitVector, int bitVectorLength) = portableGenericBitCount; 
 
-BitVector precomputed16_bitcount (BitVector n)
+
+void initializeMask()
 {
-  /* works only for 32-bit int*/
-    return bits_in_16bits [n         & 0xffffu]
-        +  bits_in_16bits [(n >> 16) & 0xffffu] ;
-}
+  int i;
+  mask32 = CALLOC(MASK_LENGTH, sizeof(BitVector));
+  mask32[0] = 1; 
+  
+  for(i = 1; i < MASK_LENGTH; ++i)
+    mask32[i] = mask32[i-1] << 1; 
 
+#ifdef HAS_POPCNT_DISPATCH
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("popcnt"))
+    {
+      bitCount = hardwareBitCount; 
+      genericBitCount = hardwareGenericBitCount; 
+    }
+#endif
+}
 
 
 BitVector *copyBitVector(BitVector *bitVector, int bitVectorLength)
@@ -127,4 +142,28 @@ BitVector *copyBitVector(BitVector *bitVector, int bitVectorLength)
 }
 
 
+/* sets bit (i + offset) in target for every bit i set in source */
+void orShiftedBitVector(BitVector *target, int targetLength, BitVector *source, int sourceLength, int offset)
+{
+  int 
+    i,
+    base = offset / MASK_LENGTH,
+    shift = offset % MASK_LENGTH; 
+
+  FOR_0_LIMIT(i,sourceLength)
+    {
+      if(NOT source[i])
+	continue;
+
+      assert(base + i < targetLength);
+      target[base + i] |= source[i] << shift; 
+      if(shift && (source[i] >> (MASK_LENGTH - shift)))
+	{
+	  assert(base + i + 1 < targetLength);
+	  target[base + i + 1] |= source[i] >> (MASK_LENGTH - shift);
+	}
+    }
+}
+
+
 
@@ -35,30 +35,37 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "common.h"
 
-typedef unsigned int BitVector; 
+typedef uint64_t BitVector; 
 
-#define BIT_COUNT(x)  precomputed16_bitcount(x)
+#define BIT_COUNT(x)  bitCount(x)
 #define NUMBER_BITS_IN_COMPLEMENT(bipartition) (mxtips - dropRound - bipartition->numberOfBitsSet)
 #define GET_BITVECTOR_LENGTH(x) (((x) % MASK_LENGTH) ? ((x) / MASK_LENGTH + 1) : ((x) / MASK_LENGTH))
 #define FLIP_NTH_BIT(bitVector,n) (bitVector[(n) / MASK_LENGTH] |= mask32[ (n) % MASK_LENGTH ])
 #define UNFLIP_NTH_BIT(bitVector,n) (bitVector[(n) / MASK_LENGTH] &= ~mask32[ (n) % MASK_LENGTH ])
 #define NTH_BIT_IS_SET(bitVector,n) (bitVector[(n) / MASK_LENGTH] & mask32[(n) % MASK_LENGTH])
+/* for bit vectors shared by threads */
+#define ATOMIC_FLIP_NTH_BIT(bitVector,n) __atomic_fetch_or((bitVector) + (n) / MASK_LENGTH, mask32[(n) % MASK_LENGTH], __ATOMIC_RELAXED)
+#define ATOMIC_UNFLIP_NTH_BIT(bitVector,n) __atomic_fetch_and((bitVector) + (n) / MASK_LENGTH, ~mask32[(n) % MASK_LENGTH], __ATOMIC_RELAXED)
+#define ATOMIC_NTH_BIT_IS_SET(bitVector,n) (__atomic_load_n((bitVector) + (n) / MASK_LENGTH, __ATOMIC_RELAXED) & mask32[(n) % MASK_LENGTH])
 #define NTH_BIT_IS_SET_IN_INT(integer,n) (integer & mask32[n])
-#define MASK_LENGTH 32
+#define MASK_LENGTH 64
 
-char bits_in_16bits [0x1u << 16];
 extern BitVector *mask32;
 
+/* set by initializeMask to use the popcount instruction, if the cpu has one */
+extern int (*bitCount)(BitVector n);
+extern int (*genericBitCount)(BitVector* bitVector, int bitVectorLength);
+
 void initializeMask();
-BitVector genericBitCount(BitVector* bitVector, int bitVectorLength);
-BitVector precomputed16_bitcount (BitVector n);
-void compute_bits_in_16bits(void);
 void printBitVector(BitVector *bv, int length);
 void freeBitVectors(BitVector **v, int n);
 BitVector *copyBitVector(BitVector *bitVector, int bitVectorLength);
+boolean areSameBitVectors(BitVector *a, BitVector *b, int bitVectorLength);
+void orShiftedBitVector(BitVector *target, int targetLength, BitVector *source, int sourceLength, int offset);
 void printBitVector(BitVector *bv, int length);
 
 #endif
@@ -0,0 +1,462 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include "BitVectorKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+/* number of words after which differenceBitCount checks the limit */
+#define DIFFERENCE_CHUNK 16
+
+
+/********************************/
+/* scalar reference versions    */
+/********************************/
+
+static boolean scalarSplitsAreCompatible(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length)
+{
+  BitVector
+    both = 0, 
+    onlyA = 0, 
+    onlyB = 0; 
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,length)
+    {
+      BitVector
+	keep = ~(dropped[i] | padding[i]);
+
+      both |= a[i] & b[i] & keep; 
+      onlyA |= a[i] & ~b[i] & keep; 
+      onlyB |= ~a[i] & b[i] & keep; 
+      
+      if(both && onlyA && onlyB)
+	return FALSE; 
+    }
+
+  return TRUE; 
+}
+
+
+static boolean scalarSplitsAreEqual(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length)
+{
+  boolean 
+    normalEqual = TRUE,
+    complement = TRUE;
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,length)
+    {
+      normalEqual = normalEqual && (a[i] == b[i]);
+      complement = complement && (a[i] == ~(b[i] | dropped[i] | padding[i]));
+      
+      if(NOT (normalEqual || complement))
+	return FALSE; 
+    }
+
+  return TRUE; 
+}
+
+
+static int scalarUnionBitCount(BitVector *a, BitVector *b, int length)
+{
+  int 
+    i, 
+    result = 0; 
+
+  FOR_0_LIMIT(i,length)
+    result += BIT_COUNT(a[i] | b[i]);
+
+  return result; 
+}
+
+
+static int scalarDifferenceBitCount(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, boolean complement, int length, int limit)
+{
+  int 
+    i, 
+    result = 0; 
+
+  FOR_0_LIMIT(i,length)
+    {
+      if(complement)
+	result += BIT_COUNT(~((a[i] ^ b[i]) | dropped[i] | padding[i]));
+      else 
+	result += BIT_COUNT(a[i] ^ b[i]);
+
+      if(result > limit)
+	return result; 
+    }
+
+  return result; 
+}
+
+
+#ifdef HAS_SIMD_DISPATCH
+
+/********************************/
+/* AVX2                         */
+/********************************/
+
+/* bits per 64-bit lane, via a nibble lookup table */
+__attribute__((target("avx2"))) static inline __m256i popcount256(__m256i v)
+{
+  const __m256i 
+    lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4),
+    lowNibbles = _mm256_set1_epi8(0x0f);
+  __m256i
+    low = _mm256_and_si256(v, lowNibbles), 
+    high = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles), 
+    count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high)); 
+
+  return _mm256_sad_epu8(count, _mm256_setzero_si256());
+}
+
+
+__attribute__((target("avx2"))) static inline int horizontalSum256(__m256i v)
+{
+  __m128i
+    sum = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+
+  return (int)(_mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1));
+}
+
+
+__attribute__((target("avx2"))) static boolean avx2SplitsAreCompatible(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length)
+{
+  __m256i
+    both = _mm256_setzero_si256(), 
+    onlyA = _mm256_setzero_si256(), 
+    onlyB = _mm256_setzero_si256(); 
+  BitVector
+    bothRest = 0, 
+    onlyARest = 0, 
+    onlyBRest = 0; 
+  int 
+    i = 0; 
+
+  for(; i + 4 <= length; i += 4)
+    {
+      __m256i
+	va = _mm256_loadu_si256((__m256i*)(a + i)),
+	vb = _mm256_loadu_si256((__m256i*)(b + i)),
+	ignore = _mm256_or_si256(_mm256_loadu_si256((__m256i*)(dropped + i)), _mm256_loadu_si256((__m256i*)(padding + i)));
+
+      both = _mm256_or_si256(both, _mm256_andnot_si256(ignore, _mm256_and_si256(va, vb)));
+      onlyA = _mm256_or_si256(onlyA, _mm256_andnot_si256(ignore, _mm256_andnot_si256(vb, va)));
+      onlyB = _mm256_or_si256(onlyB, _mm256_andnot_si256(ignore, _mm256_andnot_si256(va, vb)));
+
+      if(NOT _mm256_testz_si256(both, both) && NOT _mm256_testz_si256(onlyA, onlyA) && NOT _mm256_testz_si256(onlyB, onlyB))
+	return FALSE; 
+    }
+
+  for(; i < length; ++i)
+    {
+      BitVector
+	keep = ~(dropped[i] | padding[i]);
+      bothRest |= a[i] & b[i] & keep; 
+      onlyARest |= a[i] & ~b[i] & keep; 
+      onlyBRest |= ~a[i] & b[i] & keep; 
+    }
+
+  return (_mm256_testz_si256(both, both) && NOT bothRest)
+    || (_mm256_testz_si256(onlyA, onlyA) && NOT onlyARest)
+    || (_mm256_testz_si256(onlyB, onlyB) && NOT onlyBRest); 
+}
+
+
+__attribute__((target("avx2"))) static boolean avx2SplitsAreEqual(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length)
+{
+  boolean 
+    normalEqual = TRUE,
+    complement = TRUE;
+  int 
+    i = 0; 
+
+  for(; i + 4 <= length; i += 4)
+    {
+      __m256i
+	va = _mm256_loadu_si256((__m256i*)(a + i)),
+	vb = _mm256_loadu_si256((__m256i*)(b + i)),
+	ignore = _mm256_or_si256(_mm256_loadu_si256((__m256i*)(dropped + i)), _mm256_loadu_si256((__m256i*)(padding + i))),
+	normalDiff = _mm256_xor_si256(va, vb),
+	complementDiff = _mm256_xor_si256(va, _mm256_xor_si256(_mm256_or_si256(vb, ignore), _mm256_set1_epi64x(-1)));
+
+      normalEqual = normalEqual && _mm256_testz_si256(normalDiff, normalDiff);
+      complement = complement && _mm256_testz_si256(complementDiff, complementDiff);
+      
+      if(NOT (normalEqual || complement))
+	return FALSE; 
+    }
+
+  for(; i < length; ++i)
+    {
+      normalEqual = normalEqual && (a[i] == b[i]);
+      complement = complement && (a[i] == ~(b[i] | dropped[i] | padding[i]));
+    }
+
+  return normalEqual || complement; 
+}
+
+
+__attribute__((target("avx2,popcnt"))) static int avx2UnionBitCount(BitVector *a, BitVector *b, int length)
+{
+  __m256i
+    count = _mm256_setzero_si256(); 
+  int 
+    i = 0, 
+    result; 
+
+  for(; i + 4 <= length; i += 4)
+    count = _mm256_add_epi64(count, popcount256(_mm256_or_si256(_mm256_loadu_si256((__m256i*)(a + i)), _mm256_loadu_si256((__m256i*)(b + i)))));
+
+  result = horizontalSum256(count);
+  for(; i < length; ++i)
+    result += __builtin_popcountll(a[i] | b[i]);
+  
+  return result; 
+}
+
+
+__attribute__((target("avx2,popcnt"))) static int avx2DifferenceBitCount(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, boolean complement, int length, int limit)
+{
+  const __m256i
+    allSet = _mm256_set1_epi64x(-1);
+  int 
+    i = 0, 
+    result = 0; 
+
+  while(i + 4 <= length)
+    {
+      __m256i
+	count = _mm256_setzero_si256(); 
+      int 
+	end = MIN(length, i + DIFFERENCE_CHUNK); 
+
+      for(; i + 4 <= end; i += 4)
+	{
+	  __m256i
+	    diff = _mm256_xor_si256(_mm256_loadu_si256((__m256i*)(a + i)), _mm256_loadu_si256((__m256i*)(b + i))); 
+	  
+	  if(complement)
+	    diff = _mm256_xor_si256(_mm256_or_si256(diff, _mm256_or_si256(_mm256_loadu_si256((__m256i*)(dropped + i)), _mm256_loadu_si256((__m256i*)(padding + i)))), allSet);
+
+	  count = _mm256_add_epi64(count, popcount256(diff));
+	}
+
+      result += horizontalSum256(count);
+      if(result > limit)
+	return result; 
+    }
+
+  for(; i < length; ++i)
+    {
+      if(complement)
+	result += __builtin_popcountll(~((a[i] ^ b[i]) | dropped[i] | padding[i]));
+      else 
+	result += __builtin_popcountll(a[i] ^ b[i]);
+    }
+  
+  return result; 
+}
+
+
+/********************************/
+/* AVX-512                      */
+/********************************/
+
+/* the tail of a vector is loaded with a mask, thus no scalar loops are needed */
+#define TAIL_MASK(i,length) ((__mmask8)(((length) - (i)) >= 8 ? 0xFF : ((1u << ((length) - (i))) - 1)))
+
+
+__attribute__((target("avx512f,avx512bw"))) static inline __m512i popcount512(__m512i v)
+{
+  const __m512i 
+    lookup = _mm512_set4_epi32(0x04030302, 0x03020201, 0x03020201, 0x02010100),
+    lowNibbles = _mm512_set1_epi8(0x0f);
+  __m512i
+    low = _mm512_and_si512(v, lowNibbles), 
+    high = _mm512_and_si512(_mm512_srli_epi16(v, 4), lowNibbles), 
+    count = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, low), _mm512_shuffle_epi8(lookup, high)); 
+
+  return _mm512_sad_epu8(count, _mm512_setzero_si512());
+}
+
+
+__attribute__((target("avx512f,avx512bw"))) static boolean avx512SplitsAreCompatible(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length)
+{
+  __m512i
+    both = _mm512_setzero_si512(), 
+    onlyA = _mm512_setzero_si512(), 
+    onlyB = _mm512_setzero_si512(); 
+  int 
+    i; 
+
+  for(i = 0; i < length; i += 8)
+    {
+      __mmask8
+	mask = TAIL_MASK(i, length); 
+      __m512i
+	va = _mm512_maskz_loadu_epi64(mask, a + i),
+	vb = _mm512_maskz_loadu_epi64(mask, b + i),
+	ignore = _mm512_or_si512(_mm512_maskz_loadu_epi64(mask, dropped + i), _mm512_maskz_loadu_epi64(mask, padding + i));
+
+      /* truth tables over (a, b, ignore): 0x40 is a & b & ~ignore, 0x10 is a & ~b & ~ignore, 0x04 is ~a & b & ~ignore */
+      both = _mm512_or_si512(both, _mm512_ternarylogic_epi64(va, vb, ignore, 0x40));
+      onlyA = _mm512_or_si512(onlyA, _mm512_ternarylogic_epi64(va, vb, ignore, 0x10));
+      onlyB = _mm512_or_si512(onlyB, _mm512_ternarylogic_epi64(va, vb, ignore, 0x04));
+
+      if(_mm512_test_epi64_mask(both, both) && _mm512_test_epi64_mask(onlyA, onlyA) && _mm512_test_epi64_mask(onlyB, onlyB))
+	return FALSE; 
+    }
+
+  return TRUE; 
+}
+
+
+__attribute__((target("avx512f,avx512bw"))) static boolean avx512SplitsAreEqual(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length)
+{
+  boolean 
+    normalEqual = TRUE,
+    complement = TRUE;
+  int 
+    i; 
+
+  for(i = 0; i < length; i += 8)
+    {
+      __mmask8
+	mask = TAIL_MASK(i, length); 
+      __m512i
+	va = _mm512_maskz_loadu_epi64(mask, a + i),
+	vb = _mm512_maskz_loadu_epi64(mask, b + i),
+	ignore = _mm512_or_si512(_mm512_maskz_loadu_epi64(mask, dropped + i), _mm512_maskz_loadu_epi64(mask, padding + i));
+
+      normalEqual = normalEqual && NOT _mm512_mask_cmpneq_epi64_mask(mask, va, vb);
+      /* ~(b | ignore) */
+      complement = complement && NOT _mm512_mask_cmpneq_epi64_mask(mask, va, _mm512_ternarylogic_epi64(vb, ignore, ignore, 0x01));
+      
+      if(NOT (normalEqual || complement))
+	return FALSE; 
+    }
+
+  return TRUE; 
+}
+
+
+__attribute__((target("avx512f,avx512bw"))) static int avx512UnionBitCount(BitVector *a, BitVector *b, int length)
+{
+  __m512i
+    count = _mm512_setzero_si512(); 
+  int 
+    i; 
+
+  for(i = 0; i < length; i += 8)
+    {
+      __mmask8
+	mask = TAIL_MASK(i, length); 
+      count = _mm512_add_epi64(count, popcount512(_mm512_or_si512(_mm512_maskz_loadu_epi64(mask, a + i), _mm512_maskz_loadu_epi64(mask, b + i))));
+    }
+
+  return (int)_mm512_reduce_add_epi64(count);
+}
+
+
+__attribute__((target("avx512f,avx512bw"))) static int avx512DifferenceBitCount(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, boolean complement, int length, int limit)
+{
+  int 
+    i = 0, 
+    result = 0; 
+
+  while(i < length)
+    {
+      __m512i
+	count = _mm512_setzero_si512(); 
+      int 
+	end = MIN(length, i + DIFFERENCE_CHUNK); 
+
+      for(; i < end; i += 8)
+	{
+	  __mmask8
+	    mask = TAIL_MASK(i, length); 
+	  __m512i
+	    diff = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, a + i), _mm512_maskz_loadu_epi64(mask, b + i)); 
+	  
+	  /* ~(diff | ignore), only within the vector */
+	  if(complement)
+	    diff = _mm512_maskz_ternarylogic_epi64(mask, diff, _mm512_maskz_loadu_epi64(mask, dropped + i), _mm512_maskz_loadu_epi64(mask, padding + i), 0x01);
+
+	  count = _mm512_add_epi64(count, popcount512(diff));
+	}
+
+      result += (int)_mm512_reduce_add_epi64(count);
+      if(result > limit)
+	return result; 
+    }
+  
+  return result; 
+}
+
+#endif
+
+
+boolean (*splitsAreCompatible)(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length) = scalarSplitsAreCompatible;
+boolean (*splitsAreEqual)(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length) = scalarSplitsAreEqual;
+int (*unionBitCount)(BitVector *a, BitVector *b, int length) = scalarUnionBitCount; 
+int (*differenceBitCount)(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, boolean complement, int length, int limit) = scalarDifferenceBitCount; 
+
+
+void initializeBitVectorKernels(void)
+{
+#ifdef HAS_SIMD_DISPATCH
+  __builtin_cpu_init();
+
+  if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+      splitsAreCompatible = avx512SplitsAreCompatible; 
+      splitsAreEqual = avx512SplitsAreEqual; 
+      unionBitCount = avx512UnionBitCount; 
+      differenceBitCount = avx512DifferenceBitCount; 
+    }
+  else if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    {
+      splitsAreCompatible = avx2SplitsAreCompatible; 
+      splitsAreEqual = avx2SplitsAreEqual; 
+      unionBitCount = avx2UnionBitCount; 
+      differenceBitCount = avx2DifferenceBitCount; 
+    }
+#endif
+}
+
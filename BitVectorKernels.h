@@ -0,0 +1,63 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef BITVECTOR_KERNELS_H
+#define BITVECTOR_KERNELS_H
+
+#include "common.h"
+#include "BitVector.h"
+
+/* 
+   The word loops of the rogue search. Bits set in dropped or padding
+   are ignored. Each kernel has a scalar reference version and
+   AVX2/AVX-512 versions that are selected by
+   initializeBitVectorKernels according to the cpu.
+*/
+
+/* TRUE, if the two splits do not conflict */
+extern boolean (*splitsAreCompatible)(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length);
+
+/* TRUE, if the splits are identical or complementary */
+extern boolean (*splitsAreEqual)(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, int length);
+
+/* number of bits set in a | b */
+extern int (*unionBitCount)(BitVector *a, BitVector *b, int length);
+
+/* 
+   number of bits set in a ^ b (in ~(a ^ b) ignoring dropped and
+   padding, if complement is set). The count may stop as soon as it
+   exceeds limit.
+*/
+extern int (*differenceBitCount)(BitVector *a, BitVector *b, BitVector *dropped, BitVector *padding, boolean complement, int length, int limit);
+
+void initializeBitVectorKernels(void);
+
+#endif
@@ -30,6 +30,7 @@
 
 
 #include "Dropset.h"
+#include "BitVectorKernels.h"
 
 unsigned int *randForTaxa = NULL;
 extern int mxtips,
@@ -49,17 +50,44 @@ void initializeRandForTaxa(int mxtips)
 }
 
 
+MergingEvent *pushMergingEvent(EventVector *vector)
+{
+  if(vector->length == vector->capacity)
+    {
+      vector->capacity = vector->capacity ? 2 * vector->capacity : 4; 
+      vector->events = realloc(vector->events, vector->capacity * sizeof(MergingEvent));
+      assert(vector->events);
+    }
+
+  memset(vector->events + vector->length, 0, sizeof(MergingEvent));
+  return vector->events + vector->length++; 
+}
+
+
+void pushMergingEventRef(EventRefVector *vector, MergingEvent *mergingEvent)
+{
+  if(vector->length == vector->capacity)
+    {
+      vector->capacity = vector->capacity ? 2 * vector->capacity : 4; 
+      vector->events = realloc(vector->events, vector->capacity * sizeof(MergingEvent*));
+      assert(vector->events);
+    }
+
+  vector->events[vector->length++] = mergingEvent; 
+}
+
+
 /* is ONLY done for adding OWN elements */
 void addEventToDropsetPrime(Dropset *dropset, int a, int b)
 {
-  List
-    *lIter; 
+  int 
+    i; 
+  MergingEvent
+    *result; 
 
-  lIter = dropset->ownPrimeE;
-  while(lIter)
+  FOR_0_LIMIT(i,dropset->ownPrimeE.length)
     {
-      List *next = lIter->next; 
-      MergingEvent *me = lIter->value; 
+      MergingEvent *me = dropset->ownPrimeE.events + i; 
 
       assert(NOT me->isComplex);
 
@@ -75,173 +103,23 @@ void addEventToDropsetPrime(Dropset *dropset, int a, int b)
 	  	  == 2);
 	  return;
 	}
-      lIter = next; 
     }
   
-  MergingEvent
-    *result = CALLOC(1,sizeof(MergingEvent));
+  result = pushMergingEvent(&dropset->ownPrimeE);
   result->mergingBipartitions.pair[0] = b; 
   result->mergingBipartitions.pair[1] = a; 
-  
-  APPEND(result, dropset->ownPrimeE);
-}
-
-
-List *addEventToDropsetCombining(List *complexEvents, MergingBipartitions primeEvent)
-{
-  int 
-    a = primeEvent.pair[0],
-    b = primeEvent.pair[1];
-
-  List
-    *firstElem = NULL, 
-    *secondElem = NULL; 
-  
-  /* find list elems that already contain merging events  */
-  List *iter ; 
-  
-  iter = complexEvents; 
-  FOR_LIST(iter)
-  {
-    int res = isInIndexListSpecial(a,b,((MergingEvent*)iter->value)->mergingBipartitions.many);
-    if(res)
-      {
-	if(NOT firstElem)
-	  firstElem = iter; 
-	else if(NOT secondElem)
-	  secondElem = iter; 
-	else break; 
-      }
-  }
-
-
-  if(firstElem && secondElem)
-    {
-      /* merge bips into first elem */ 
-      IndexList
-	*il = ((MergingEvent*)secondElem->value)->mergingBipartitions.many, 
-	*persistentIndexList = ((MergingEvent*)firstElem->value)->mergingBipartitions.many; 
-      FOR_LIST(il)
-	persistentIndexList = appendToIndexListIfNotThere(il->index, persistentIndexList); 
-      ((MergingEvent*)firstElem->value)->mergingBipartitions.many = persistentIndexList;
-      freeIndexList(((MergingEvent*)secondElem->value)->mergingBipartitions.many); 
-      free((MergingEvent*)secondElem->value); 
-
-      /* remove second element */
-      if(complexEvents == secondElem)
-	complexEvents = secondElem->next; 
-      else 
-	{
-	  iter = complexEvents; 
-	  FOR_LIST(iter)
-	  {
-	    if(iter->next == secondElem)
-	      {
-		iter->next = iter->next->next; 
-		break; 
-	      }
-	  }
-	}
-      free(secondElem);
-    }
-  else if(firstElem)
-    {      
-      assert( NOT secondElem);
-      MergingEvent *me = firstElem->value; 
-      me->mergingBipartitions.many = appendToIndexListIfNotThere(a,me->mergingBipartitions.many);
-      me->mergingBipartitions.many = appendToIndexListIfNotThere(b,me->mergingBipartitions.many);
-    }
-  else
-    {      
-      MergingEvent
-	*me = CALLOC(1,sizeof(MergingEvent));
-      me->isComplex = TRUE;
-      
-      me->mergingBipartitions.many = NULL;
-      APPEND_INT(a,me->mergingBipartitions.many);
-      APPEND_INT(b,me->mergingBipartitions.many);
-      APPEND(me, complexEvents);
-    }
-
-  return complexEvents;
 }
 
 
-void freeDropsetDeepInHash(void *value)
-{
-  freeDropsetDeep(value, TRUE);
-}
-
-
-void freeDropsetDeep(void *value, boolean extended)
+/* complex events are allocated in the arena of the round */
+void freeDropsetDeep(void *value)
 {
   Dropset
     *dropset = (Dropset*) value;
-  List
-    *iter = NULL; 
-
-  if(dropset->taxaToDrop)
-    freeIndexList(dropset->taxaToDrop);
-  
-  /* free combined events */
-  if(extended && dropset->complexEvents)
-    {
-      iter = dropset->complexEvents;
-      while(iter)
-	{
-	  List *next = iter->next;
-	  MergingEvent *me = iter->value;
-	  freeIndexList(me->mergingBipartitions.many);
-	  free(me);
-	  iter = next;
-	}
-      freeListFlat(dropset->complexEvents);
-    }
-  
-  if(extended && dropset->acquiredPrimeE)
-    freeListFlat(dropset->acquiredPrimeE);
-
-  /* ownPrimeE */
-  iter = dropset->ownPrimeE;
-  while(iter)
-    {
-      List *next = iter->next; 
-      free((MergingEvent*)iter->value);  
-      iter = next;
-    }
-  freeListFlat(dropset->ownPrimeE);
-
-  free(dropset);
-}
-
-
-void freeDropsetDeepInEnd(void *value)
-{
-  Dropset
-    *dropset = (Dropset*) value;
-  List
-    *iter = NULL; 
-
-  if(dropset->taxaToDrop)
-    freeIndexList(dropset->taxaToDrop);
-  
-  /* free combined events */
-  if(dropset->complexEvents)
-    freeListFlat(dropset->complexEvents);
-  
-  if( dropset->acquiredPrimeE) 
-    freeListFlat(dropset->acquiredPrimeE);
-
-  /* ownPrimeE */
-  iter = dropset->ownPrimeE;
-  while(iter)
-    {
-      List *next = iter->next; 
-      free((MergingEvent*)iter->value);  
-      iter = next;
-    }
-  freeListFlat(dropset->ownPrimeE);
 
+  free(dropset->ownPrimeE.events);
+  free(dropset->acquiredPrimeE.events);
+  free(dropset->complexEvents.events);
   free(dropset);
 }
 
@@ -279,14 +157,15 @@ unsigned int dropsetHashValue(HashTable *hashTable, void *value)
 {
   unsigned int
     result = 0;
+  int 
+    i; 
 
   Dropset *dropset = (Dropset*)value;
-  IndexList *iter = dropset->taxaToDrop;
 
-  FOR_LIST(iter)  
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
   {
-    assert(iter->index < mxtips);
-    result ^= randForTaxa[ iter->index ];
+    assert(dropset->taxa[i] < mxtips);
+    result ^= randForTaxa[ dropset->taxa[i] ];
   }
  
   return result; 
@@ -295,10 +174,65 @@ unsigned int dropsetHashValue(HashTable *hashTable, void *value)
 
 boolean dropsetEqual(HashTable *hashtable, void *entryA, void *entryB)
 {
-  IndexList *aList = ((Dropset*)entryA)->taxaToDrop,
-    *bList = ((Dropset*)entryB)->taxaToDrop;
+  Dropset 
+    *a = (Dropset*)entryA,
+    *b = (Dropset*)entryB;
+
+  return a->numberOfTaxa == b->numberOfTaxa 
+    && NOT memcmp(a->taxa, b->taxa, a->numberOfTaxa * sizeof(int));
+}
+
+
+boolean dropsetContainsTaxon(Dropset *dropset, int taxon)
+{
+  int i; 
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
+    if(dropset->taxa[i] == taxon)
+      return TRUE; 
+  return FALSE; 
+}
+
+
+boolean isSubDropset(Dropset *subset, Dropset *set)
+{
+  int i; 
+  FOR_0_LIMIT(i,subset->numberOfTaxa)
+    if(NOT dropsetContainsTaxon(set, subset->taxa[i]))
+      return FALSE; 
+  return TRUE; 
+}
+
+
+boolean dropsetsIntersect(Dropset *dropsetA, Dropset *dropsetB)
+{
+  int i; 
+  FOR_0_LIMIT(i,dropsetA->numberOfTaxa)
+    if(dropsetContainsTaxon(dropsetB, dropsetA->taxa[i]))
+      return TRUE; 
+  return FALSE; 
+}
+
+
+void removeTaxaOfDropset(Dropset *dropset, Dropset *subtract)
+{
+  int 
+    i,
+    numberOfTaxa = 0; 
+  
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
+    if(NOT dropsetContainsTaxon(subtract, dropset->taxa[i]))
+      dropset->taxa[numberOfTaxa++] = dropset->taxa[i];
   
-  return indexListEqual(aList, bList);
+  dropset->numberOfTaxa = numberOfTaxa; 
+}
+
+
+/* highest taxon first */
+void printDropsetTaxaToFile(FILE *file, Dropset *dropset)
+{
+  int i; 
+  for(i = dropset->numberOfTaxa - 1; i >= 0; --i)
+    fprintf(file, i == dropset->numberOfTaxa - 1 ? "%d" : ",%d", dropset->taxa[i]);
 }
 
 
@@ -323,19 +257,26 @@ boolean elementsEqual(ProfileElem *elemA,ProfileElem *elemB, int a, int b)
 }
 
 
-IndexList *getDropset(ProfileElem *elemA, ProfileElem *elemB, boolean complement, BitVector *neglectThose) 
+/* 
+   fills in result, if elemA (or its complement) and elemB only differ
+   in at most maxDropsetSize taxa that may be dropped
+*/
+boolean getDropset(ProfileElem *elemA, ProfileElem *elemB, boolean complement, BitVector *neglectThose, Dropset *result) 
 {  
   int i,j,
     numBit = 0,
-    localBitCount, 
+    localBitCount;
+  BitVector
     differenceByte;   
 
-  IndexList
-    *result = NULL;
-
   if(elemA == elemB)
-    return NULL; 
+    return FALSE; 
+
+  numBit = differenceBitCount(elemA->bitVector, elemB->bitVector, droppedTaxa, paddingBits, complement, bitVectorLength, maxDropsetSize);
+  if(numBit > maxDropsetSize)
+    return FALSE; 
 
+  result->numberOfTaxa = 0; 
   FOR_0_LIMIT(i,bitVectorLength)
     {
       if( complement)
@@ -345,12 +286,6 @@ IndexList *getDropset(ProfileElem *elemA, ProfileElem *elemB, boolean complement
       
       localBitCount = BIT_COUNT(differenceByte);
 
-      if( (numBit += localBitCount) > maxDropsetSize)
-	{
-	  freeIndexList(result);
-	  return NULL; 
-	}
-
       if( NOT localBitCount)
 	continue;
    
@@ -361,20 +296,17 @@ IndexList *getDropset(ProfileElem *elemA, ProfileElem *elemB, boolean complement
 	  
 	  if(NTH_BIT_IS_SET_IN_INT(differenceByte,j))	    
 	    {
-	      APPEND_INT((( i * MASK_LENGTH) + j),result);
-	      localBitCount--;
-	      
 	      if(NOT NTH_BIT_IS_SET(neglectThose, (i*MASK_LENGTH + j)))
-		{
-		  freeIndexList(result);
-		  return NULL;
-		}
+		return FALSE;
+
+	      result->taxa[result->numberOfTaxa++] = i * MASK_LENGTH + j; 
+	      localBitCount--;
 	    }
 	}
     }
 
   assert(numBit);
 
-  return result; 
+  return TRUE; 
 }
 
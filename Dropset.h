@@ -37,6 +37,10 @@
 #include "ProfileElem.h"
 #include "HashTable.h"
 
+/* the taxa of a dropset are stored inline and its subsets are
+   enumerated, when combining events */
+#define MAX_DROPSET_SIZE 8
+
 typedef union _mergeBips
 {
   int pair[2];
@@ -53,14 +57,45 @@ typedef struct _mergingEvent
 }  MergingEvent;
 
 
+/* 
+   growable arrays of merging events. As with the lists used before, the
+   most recently added event is visited first by GET_EVENT.
+*/
+typedef struct
+{
+  MergingEvent *events;		/* stored inline */
+  int length; 
+  int capacity; 
+} EventVector; 
+
+typedef struct
+{
+  MergingEvent **events; 
+  int length; 
+  int capacity; 
+} EventRefVector; 
+
+#define GET_EVENT(vector,i) ((vector).events + (vector).length - 1 - (i))
+#define GET_EVENT_REF(vector,i) ((vector).events[(vector).length - 1 - (i)])
+
+
 typedef struct dropset
 {
-  IndexList *taxaToDrop;
+  int taxa[MAX_DROPSET_SIZE];	/* sorted */
+  int numberOfTaxa; 
   int improvement;
   
-  List *ownPrimeE; 
-  List *acquiredPrimeE; 
-  List *complexEvents; 
+  EventVector ownPrimeE; 
+  EventRefVector acquiredPrimeE; /* point to own events of sub-dropsets */
+  EventRefVector complexEvents;	 /* live in the arena of the round */
+
+  int position;			/* in the array of all dropsets of the round */
+
+  /* for the incremental evaluation */
+  int modifiedInRound;		/* own events last changed */
+  int numberOfSubsets;		/* dropsets in the hash that are subsets */
+  boolean subsetModified;	/* any of them changed this round */
+  boolean upToDate;		/* the improvement is exact */
 } Dropset;
 
 
@@ -70,11 +105,14 @@ void removeMergingEvent(Dropset *dropset, List *toBeRemoved);
 List *freeMergingEventReturnNext(List *elem); 
 void removeDropsetAndRelated(HashTable *mergingHash, Dropset *dropset);
 void addEventToDropsetPrime(Dropset *dropset, int a, int b);
-List *addEventToDropsetCombining(List *complexEvents, MergingBipartitions primeEvent);
-void freeDropsetDeepInHash(void *value);
-void freeDropsetDeepInEnd(void *value);
-void addEventToDropsetForCombining(Dropset *dropset, IndexList *mergingBips);
+MergingEvent *pushMergingEvent(EventVector *vector);
+void pushMergingEventRef(EventRefVector *vector, MergingEvent *mergingEvent);
 void initializeRandForTaxa(int mxtips);
-void freeDropsetDeep(void *values, boolean freeCombinedM);
-IndexList *getDropset(ProfileElem *elemA, ProfileElem *elemB, boolean complement, BitVector *neglectThose);
+void freeDropsetDeep(void *value);
+boolean getDropset(ProfileElem *elemA, ProfileElem *elemB, boolean complement, BitVector *neglectThose, Dropset *result);
+boolean dropsetContainsTaxon(Dropset *dropset, int taxon);
+boolean isSubDropset(Dropset *subset, Dropset *set);
+boolean dropsetsIntersect(Dropset *dropsetA, Dropset *dropsetB);
+void removeTaxaOfDropset(Dropset *dropset, Dropset *subtract);
+void printDropsetTaxaToFile(FILE *file, Dropset *dropset);
 #endif
@@ -0,0 +1,214 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include "EventLog.h"
+
+
+EventLogSet *createEventLogs(int numberOfThreads)
+{
+  int 
+    i; 
+  EventLogSet
+    *logSet = CALLOC(1, sizeof(EventLogSet)); 
+
+  logSet->numberOfLogs = numberOfThreads; 
+  logSet->numberOfPartitions = numberOfThreads; 
+  logSet->logs = CALLOC(numberOfThreads, sizeof(EventLog));
+  FOR_0_LIMIT(i,numberOfThreads)
+    {
+      EventLog 
+	*log = logSet->logs + i; 
+      log->events = CALLOC(logSet->numberOfPartitions, sizeof(LoggedEvent*));
+      log->length = CALLOC(logSet->numberOfPartitions, sizeof(int));
+      log->capacity = CALLOC(logSet->numberOfPartitions, sizeof(int));
+    }
+
+  return logSet; 
+}
+
+
+/* keeps the memory for the next round */
+void clearEventLogs(EventLogSet *logSet)
+{
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,logSet->numberOfLogs)
+    {
+      EventLog 
+	*log = logSet->logs + i; 
+      memset(log->length, 0, logSet->numberOfPartitions * sizeof(int));
+      log->numberOfSegments = 0; 
+    }
+
+  free(logSet->segments);
+  logSet->segments = NULL; 
+  logSet->numberOfSegments = 0; 
+}
+
+
+static void closeLogSegment(EventLog *log, int numberOfPartitions)
+{
+  if(log->numberOfSegments > 0)
+    memcpy(log->bounds + (2 * (log->numberOfSegments - 1) + 1) * numberOfPartitions, 
+	   log->length, numberOfPartitions * sizeof(int));
+}
+
+
+/* all events logged until the next call stem from jobs starting with firstJob */
+void startLogSegment(EventLogSet *logSet, int tid, int firstJob)
+{
+  EventLog
+    *log = logSet->logs + tid; 
+  int 
+    numberOfPartitions = logSet->numberOfPartitions; 
+
+  closeLogSegment(log, numberOfPartitions);
+
+  if(log->numberOfSegments == log->segmentCapacity)
+    {
+      log->segmentCapacity = log->segmentCapacity ? 2 * log->segmentCapacity : 16; 
+      log->bounds = realloc(log->bounds, 2 * log->segmentCapacity * numberOfPartitions * sizeof(int));
+      log->firstJobs = realloc(log->firstJobs, log->segmentCapacity * sizeof(int));
+      assert(log->bounds && log->firstJobs);
+    }
+
+  memcpy(log->bounds + 2 * log->numberOfSegments * numberOfPartitions, 
+	 log->length, numberOfPartitions * sizeof(int));
+  log->firstJobs[log->numberOfSegments] = firstJob; 
+  log->numberOfSegments++; 
+}
+
+
+void logMergingEvent(EventLogSet *logSet, int tid, Dropset *key, unsigned int hashValue, unsigned int tableSize, int bipA, int bipB)
+{
+  EventLog
+    *log = logSet->logs + tid; 
+  int 
+    partition = (hashValue % tableSize) % logSet->numberOfPartitions; 
+  LoggedEvent
+    *event; 
+
+  assert(log->numberOfSegments > 0);
+
+  if(log->length[partition] == log->capacity[partition])
+    {
+      log->capacity[partition] = log->capacity[partition] ? 2 * log->capacity[partition] : 64; 
+      log->events[partition] = realloc(log->events[partition], log->capacity[partition] * sizeof(LoggedEvent));
+      assert(log->events[partition]);
+    }
+
+  event = log->events[partition] + log->length[partition]++; 
+  memcpy(event->taxa, key->taxa, key->numberOfTaxa * sizeof(int));
+  event->numberOfTaxa = key->numberOfTaxa; 
+  event->hashValue = hashValue; 
+  event->bipA = bipA; 
+  event->bipB = bipB; 
+}
+
+
+static int sortSegmentsByJob(const void *a, const void *b)
+{
+  return ((LogSegment*)a)->firstJob - ((LogSegment*)b)->firstJob; 
+}
+
+
+/* called by the master, when all events are logged */
+void orderLogSegments(EventLogSet *logSet)
+{
+  int 
+    i, 
+    j, 
+    numberOfPartitions = logSet->numberOfPartitions; 
+
+  logSet->numberOfSegments = 0; 
+  FOR_0_LIMIT(i,logSet->numberOfLogs)
+    logSet->numberOfSegments += logSet->logs[i].numberOfSegments; 
+
+  free(logSet->segments);
+  logSet->segments = CALLOC(MAX(1,logSet->numberOfSegments), sizeof(LogSegment));
+
+  logSet->numberOfSegments = 0; 
+  FOR_0_LIMIT(i,logSet->numberOfLogs)
+    {
+      EventLog 
+	*log = logSet->logs + i; 
+
+      closeLogSegment(log, numberOfPartitions);
+      FOR_0_LIMIT(j,log->numberOfSegments)
+	{
+	  LogSegment
+	    *segment = logSet->segments + logSet->numberOfSegments++; 
+	  segment->firstJob = log->firstJobs[j]; 
+	  segment->log = i; 
+	  segment->start = log->bounds + 2 * j * numberOfPartitions; 
+	  segment->end = segment->start + numberOfPartitions; 
+	}
+    }
+
+  qsort(logSet->segments, logSet->numberOfSegments, sizeof(LogSegment), sortSegmentsByJob);
+}
+
+
+/* the events of a segment (in the order of orderLogSegments) that fall into partition */
+int getLoggedEvents(EventLogSet *logSet, int segment, int partition, LoggedEvent **events)
+{
+  LogSegment
+    *theSegment = logSet->segments + segment; 
+
+  *events = logSet->logs[theSegment->log].events[partition] + theSegment->start[partition]; 
+  return theSegment->end[partition] - theSegment->start[partition]; 
+}
+
+
+void freeEventLogs(EventLogSet *logSet)
+{
+  int 
+    i, 
+    j; 
+
+  FOR_0_LIMIT(i,logSet->numberOfLogs)
+    {
+      EventLog 
+	*log = logSet->logs + i; 
+      FOR_0_LIMIT(j,logSet->numberOfPartitions)
+	free(log->events[j]);
+      free(log->events);
+      free(log->length);
+      free(log->capacity);
+      free(log->bounds);
+      free(log->firstJobs);
+    }
+
+  free(logSet->logs);
+  free(logSet->segments);
+  free(logSet);
+}
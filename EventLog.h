@@ -0,0 +1,93 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "common.h"
+#include "Dropset.h"
+
+/* 
+   When computing events in parallel, the threads do not insert into
+   the merging hash. Instead, every thread logs its events, bucketed by
+   the partition of hash slots they fall into. Afterwards, thread p
+   replays all events of partition p, thus no two threads touch the
+   same slot. Since the log remembers which job produced an event, the
+   events are replayed in the same order as in the sequential version.
+*/
+
+typedef struct
+{
+  int taxa[MAX_DROPSET_SIZE]; 
+  int numberOfTaxa; 
+  unsigned int hashValue; 
+  int bipA; 
+  int bipB; 
+} LoggedEvent; 
+
+typedef struct
+{
+  int firstJob; 
+  int log; 
+  int *start; 			/* per partition */
+  int *end; 
+} LogSegment; 
+
+typedef struct
+{
+  LoggedEvent **events; 	/* per partition */
+  int *length; 
+  int *capacity; 
+
+  int *bounds; 			/* start and end per partition of each segment */
+  int *firstJobs; 
+  int numberOfSegments;
+  int segmentCapacity; 
+} EventLog; 
+
+typedef struct
+{
+  EventLog *logs; 		/* one per thread */
+  int numberOfLogs; 
+  int numberOfPartitions; 
+  LogSegment *segments; 	/* of all logs, ordered by job */
+  int numberOfSegments; 
+} EventLogSet; 
+
+EventLogSet *createEventLogs(int numberOfThreads);
+void clearEventLogs(EventLogSet *logSet);
+void startLogSegment(EventLogSet *logSet, int tid, int firstJob); 
+void logMergingEvent(EventLogSet *logSet, int tid, Dropset *key, unsigned int hashValue, unsigned int tableSize, int bipA, int bipB);
+void orderLogSegments(EventLogSet *logSet);
+int getLoggedEvents(EventLogSet *logSet, int segment, int partition, LoggedEvent **events);
+void freeEventLogs(EventLogSet *logSet);
+
+#endif
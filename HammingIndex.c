@@ -0,0 +1,355 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include "HammingIndex.h"
+
+
+static uint64_t mixHash(uint64_t x)
+{
+  x ^= x >> 30; 
+  x *= 0xBF58476D1CE4E5B9ULL; 
+  x ^= x >> 27; 
+  x *= 0x94D049BB133111EBULL; 
+  x ^= x >> 31; 
+  return x; 
+}
+
+
+/* 
+   hash of the taxa of a segment that are set in bitVector (or of those
+   neither set nor ignored, if complement is set)
+*/
+static uint64_t getSegmentHash(HammingIndex *index, int segment, BitVector *bitVector, BitVector *dropped, BitVector *padding, boolean complement)
+{
+  int 
+    start = index->segmentStart[segment], 
+    end = index->segmentStart[segment + 1], 
+    i; 
+  uint64_t 
+    result = 0; 
+
+  for(i = start / MASK_LENGTH; i * MASK_LENGTH < end; ++i)
+    {
+      BitVector
+	word = complement ? ~(bitVector[i] | dropped[i] | padding[i]) : bitVector[i],
+	mask = ~((BitVector)0); 
+
+      if(i * MASK_LENGTH < start)
+	mask &= ~((BitVector)0) << (start - i * MASK_LENGTH);
+      if((i + 1) * MASK_LENGTH > end)
+	mask &= ~((BitVector)0) >> ((i + 1) * MASK_LENGTH - end);
+
+      result = mixHash(result ^ (word & mask));
+    }
+
+  return result; 
+}
+
+
+static uint64_t getKey(uint64_t segmentHash, int numberOfBitsSet)
+{
+  return mixHash(segmentHash + (uint64_t)numberOfBitsSet * 0x9E3779B97F4A7C15ULL); 
+}
+
+
+static void insertEntry(HammingIndex *index, int id, int segment)
+{
+  int 
+    entry = id * index->numberOfSegments + segment, 
+    *head = index->heads + (size_t)segment * index->tableSize + (index->keys[entry] & (index->tableSize - 1));
+
+  index->previous[entry] = -1; 
+  index->next[entry] = *head; 
+  if(*head != -1)
+    index->previous[*head] = entry; 
+  *head = entry; 
+  index->chainLengths[head - index->heads]++;
+}
+
+
+static void removeEntry(HammingIndex *index, int id, int segment)
+{
+  int 
+    entry = id * index->numberOfSegments + segment;
+  size_t 
+    chain = (size_t)segment * index->tableSize + (index->keys[entry] & (index->tableSize - 1)); 
+
+  if(index->previous[entry] != -1)
+    index->next[index->previous[entry]] = index->next[entry];
+  else 
+    index->heads[chain] = index->next[entry];
+  index->chainLengths[chain]--; 
+  
+  if(index->next[entry] != -1)
+    index->previous[index->next[entry]] = index->previous[entry];
+}
+
+
+HammingIndex *createHammingIndex(Array *bipartitionsById, int mxtips, int maxDifference)
+{
+  HammingIndex 
+    *index = CALLOC(1, sizeof(HammingIndex));
+  int 
+    i,
+    numberOfEntries; 
+
+  assert(maxDifference <= MAX_DROPSET_SIZE);
+  index->numberOfSegments = MIN(HAMMING_SEGMENTS_PER_DIFFERENCE * (maxDifference + 1), mxtips); 
+  index->segmentStart = CALLOC(index->numberOfSegments + 1, sizeof(int));
+  FOR_0_LIMIT(i, index->numberOfSegments + 1)
+    index->segmentStart[i] = (int)(((long)mxtips * i) / index->numberOfSegments);
+  index->bitVectorLength = GET_BITVECTOR_LENGTH(mxtips);
+  index->maxDifference = maxDifference; 
+
+  index->numberOfElems = bipartitionsById->length; 
+  index->tableSize = 64; 
+  while(index->tableSize < 2 * (unsigned int)index->numberOfElems)
+    index->tableSize *= 2; 
+
+  numberOfEntries = index->numberOfElems * index->numberOfSegments; 
+  index->heads = malloc((size_t)index->numberOfSegments * index->tableSize * sizeof(int));
+  memset(index->heads, -1, (size_t)index->numberOfSegments * index->tableSize * sizeof(int));
+  index->chainLengths = CALLOC((size_t)index->numberOfSegments * index->tableSize, sizeof(int));
+  index->keys = CALLOC(numberOfEntries, sizeof(uint64_t));
+  index->next = CALLOC(numberOfEntries, sizeof(int));
+  index->previous = CALLOC(numberOfEntries, sizeof(int));
+  index->isIndexed = CALLOC(index->numberOfElems, sizeof(boolean));
+  index->positions = CALLOC(index->numberOfElems, sizeof(int));
+
+  FOR_0_LIMIT(i,bipartitionsById->length)
+    if(GET_PROFILE_ELEM(bipartitionsById,i))
+      updateHammingIndex(index, GET_PROFILE_ELEM(bipartitionsById,i));
+
+  return index; 
+}
+
+
+void freeHammingIndex(HammingIndex *index)
+{
+  free(index->segmentStart);
+  free(index->heads);
+  free(index->chainLengths);
+  free(index->keys);
+  free(index->next);
+  free(index->previous);
+  free(index->isIndexed);
+  free(index->positions);
+  free(index);
+}
+
+
+/* (re-)enters elem with its current bit vector */
+void updateHammingIndex(HammingIndex *index, ProfileElem *elem)
+{
+  int 
+    segment; 
+
+  assert(elem->id < index->numberOfElems);
+
+  FOR_0_LIMIT(segment, index->numberOfSegments)
+    {
+      uint64_t 
+	key = getKey(getSegmentHash(index, segment, elem->bitVector, NULL, NULL, FALSE), elem->numberOfBitsSet); 
+      int 
+	entry = elem->id * index->numberOfSegments + segment; 
+
+      if(index->isIndexed[elem->id])
+	{
+	  if(index->keys[entry] == key)
+	    continue; 
+	  removeEntry(index, elem->id, segment);
+	}
+
+      index->keys[entry] = key; 
+      insertEntry(index, elem->id, segment);
+    }
+
+  index->isIndexed[elem->id] = TRUE; 
+}
+
+
+void removeFromHammingIndex(HammingIndex *index, ProfileElem *elem)
+{
+  int 
+    segment; 
+
+  if(NOT index->isIndexed[elem->id])
+    return; 
+
+  FOR_0_LIMIT(segment, index->numberOfSegments)
+    removeEntry(index, elem->id, segment);
+
+  index->isIndexed[elem->id] = FALSE; 
+}
+
+
+void setHammingIndexPositions(HammingIndex *index, Array *bipartitionProfile)
+{
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,bipartitionProfile->length)
+    {
+      ProfileElem
+	*elem = GET_PROFILE_ELEM(bipartitionProfile,i);
+      
+      if(elem)
+	index->positions[elem->id] = i; 
+    }
+}
+
+
+/* 
+   computes the keys of the query for bipartitions with bits bits set
+   and selects the maxDifference + 1 segments with the shortest
+   chains. Returns the number of entries in these chains.
+*/
+static int selectSegments(HammingIndex *index, uint64_t *segmentHashes, int bits, uint64_t *keys, int *selected)
+{
+  int 
+    numberToSelect = MIN(index->maxDifference + 1, index->numberOfSegments), 
+    result = 0,
+    i,j, 
+    lengths[MAX_HAMMING_SEGMENTS];
+
+  FOR_0_LIMIT(i, index->numberOfSegments)
+    {
+      keys[i] = getKey(segmentHashes[i], bits);
+      lengths[i] = index->chainLengths[(size_t)i * index->tableSize + (keys[i] & (index->tableSize - 1))];
+    }
+
+  FOR_0_LIMIT(i, numberToSelect)
+    {
+      int 
+	best = -1; 
+      FOR_0_LIMIT(j, index->numberOfSegments)
+	if(lengths[j] >= 0 && (best == -1 || lengths[j] < lengths[best]))
+	  best = j; 
+      selected[i] = best; 
+      result += lengths[best];
+      lengths[best] = -1; 
+    }
+
+  return result; 
+}
+
+
+static void getSegmentHashes(HammingIndex *index, ProfileElem *elem, BitVector *dropped, BitVector *padding, boolean complement, uint64_t *result)
+{
+  int 
+    segment; 
+
+  FOR_0_LIMIT(segment, index->numberOfSegments)
+    result[segment] = getSegmentHash(index, segment, elem->bitVector, dropped, padding, complement);
+}
+
+
+/* number of entries a call to getHammingCandidates would visit */
+int getHammingCost(HammingIndex *index, ProfileElem *elem, BitVector *dropped, BitVector *padding, boolean complement, int minBits, int maxBits)
+{
+  int 
+    result = 0,
+    bits,
+    selected[MAX_HAMMING_SEGMENTS];
+  uint64_t 
+    segmentHashes[MAX_HAMMING_SEGMENTS],
+    keys[MAX_HAMMING_SEGMENTS];
+
+  getSegmentHashes(index, elem, dropped, padding, complement, segmentHashes);
+
+  for(bits = MAX(minBits, 0); bits <= maxBits; ++bits)
+    result += selectSegments(index, segmentHashes, bits, keys, selected);
+
+  return result; 
+}
+
+
+/* 
+   collects the ids of all bipartitions with minBits to maxBits bits
+   set that may differ from elem in at most maxDifference taxa (or
+   from its complement with the ignored taxa removed). Each id occurs
+   once. The candidates are appended to the buffer that is grown as
+   needed.
+*/
+void getHammingCandidates(HammingIndex *index, ProfileElem *elem, BitVector *dropped, BitVector *padding, boolean complement, int minBits, int maxBits, int **candidates, int *numberOfCandidates, int *capacity)
+{
+  int 
+    numberToSelect = MIN(index->maxDifference + 1, index->numberOfSegments), 
+    bits, 
+    i,j,
+    selected[MAX_HAMMING_SEGMENTS];
+  uint64_t 
+    segmentHashes[MAX_HAMMING_SEGMENTS],
+    keys[MAX_HAMMING_SEGMENTS];
+
+  getSegmentHashes(index, elem, dropped, padding, complement, segmentHashes);
+
+  for(bits = MAX(minBits, 0); bits <= maxBits; ++bits)
+    {
+      selectSegments(index, segmentHashes, bits, keys, selected);
+
+      FOR_0_LIMIT(i, numberToSelect)
+	{
+	  int 
+	    segment = selected[i],
+	    entry = index->heads[(size_t)segment * index->tableSize + (keys[segment] & (index->tableSize - 1))];
+
+	  for(; entry != -1; entry = index->next[entry])
+	    {
+	      int 
+		id = entry / index->numberOfSegments; 
+
+	      if(index->keys[entry] != keys[segment])
+		continue; 
+
+	      /* reported already for an earlier segment */
+	      FOR_0_LIMIT(j, i)
+		if(index->keys[id * index->numberOfSegments + selected[j]] == keys[selected[j]])
+		  break; 
+	      
+	      if(j < i)
+		continue; 
+
+	      if(*numberOfCandidates == *capacity)
+		{
+		  *capacity = MAX(2 * *capacity, 16); 
+		  *candidates = realloc(*candidates, *capacity * sizeof(int));
+		  if( NOT *candidates)
+		    {
+		      printf("ERROR: could not grow the merge candidates to %d entries.\n", *capacity);
+		      exit(-1);
+		    }
+		}
+	      (*candidates)[(*numberOfCandidates)++] = id; 
+	    }
+	}
+    }
+}
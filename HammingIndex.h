@@ -0,0 +1,92 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef HAMMING_INDEX_H
+#define HAMMING_INDEX_H
+
+#include <stdint.h>
+
+#include "common.h"
+#include "Array.h"
+#include "BitVector.h"
+#include "ProfileElem.h"
+#include "Dropset.h"
+
+/* 
+   Multi-index hashing of the bipartitions for the search of merge
+   candidates: the taxa are split into segments and each bipartition is
+   entered into one exact-match table per segment (keyed by the content
+   of the segment and the number of bits set). If two bipartitions
+   differ in at most maxDifference taxa, they agree in at least one out
+   of any maxDifference + 1 segments. Thus, a query only has to visit
+   the buckets of the maxDifference + 1 segments with the shortest
+   chains (for sparse bipartitions, most segments are empty and their
+   buckets are crowded).
+
+   The index has to be updated, whenever the bit vector (or the number
+   of bits set) of a bipartition changes. getHammingCost tells the
+   caller how many entries a lookup would visit, s.t. it can fall back
+   to a plain scan.
+*/
+
+#define HAMMING_SEGMENTS_PER_DIFFERENCE 2
+
+/* bipartitions merge by dropping at most MAX_DROPSET_SIZE taxa */
+#define MAX_HAMMING_SEGMENTS (HAMMING_SEGMENTS_PER_DIFFERENCE * (MAX_DROPSET_SIZE + 1))
+
+typedef struct
+{
+  int numberOfSegments; 
+  int *segmentStart;		/* first taxon of each segment, numberOfSegments + 1 entries */
+  int bitVectorLength; 
+  int maxDifference; 
+  
+  int numberOfElems;		/* ids are in [0,numberOfElems) */
+  unsigned int tableSize; 
+  int *heads;			/* numberOfSegments tables of tableSize chains */
+  int *chainLengths; 
+  uint64_t *keys;		/* per id and segment */
+  int *next; 
+  int *previous; 
+  boolean *isIndexed; 
+  
+  int *positions;		/* position of each id in the (sorted) profile */
+} HammingIndex; 
+
+HammingIndex *createHammingIndex(Array *bipartitionsById, int mxtips, int maxDifference);
+void freeHammingIndex(HammingIndex *index);
+void updateHammingIndex(HammingIndex *index, ProfileElem *elem);
+void removeFromHammingIndex(HammingIndex *index, ProfileElem *elem);
+void setHammingIndexPositions(HammingIndex *index, Array *bipartitionProfile);
+int getHammingCost(HammingIndex *index, ProfileElem *elem, BitVector *dropped, BitVector *padding, boolean complement, int minBits, int maxBits);
+void getHammingCandidates(HammingIndex *index, ProfileElem *elem, BitVector *dropped, BitVector *padding, boolean complement, int minBits, int maxBits, int **candidates, int *numberOfCandidates, int *capacity);
+
+#endif
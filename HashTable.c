@@ -29,9 +29,6 @@
  */
 
 #include "HashTable.h"
-#ifdef PARALLEL
-#include <pthread.h>
-#endif
 
 HashTable *createHashTable(unsigned int size, 
 			   void *commonAttr, 
@@ -69,18 +66,6 @@ HashTable *createHashTable(unsigned int size,
 
   tableSize = initTable[i];
 
-#ifdef PARALLEL
-  hashTable->cntLock = CALLOC(1,sizeof(pthread_mutex_t));
-  pthread_mutex_init(hashTable->cntLock, (pthread_mutexattr_t *)NULL);
-  
-  hashTable->lockPerSlot = (pthread_mutex_t**)CALLOC(tableSize,sizeof(pthread_mutex_t*));  
-  FOR_0_LIMIT(i, tableSize)
-    {
-      hashTable->lockPerSlot[i] = (pthread_mutex_t*) CALLOC(1,sizeof(pthread_mutex_t));
-      pthread_mutex_init(hashTable->lockPerSlot[i], (pthread_mutexattr_t *)NULL);
-    }
-#endif
-
   hashTable->table = CALLOC(tableSize, sizeof(HashElem*));
   hashTable->tableSize = tableSize;  
   hashTable->entryCount = 0;  
@@ -183,9 +168,8 @@ void insertIntoHashTable(HashTable *hashTable, void *value, unsigned int index)
   hashElem->next = hashTable->table[index];  
   hashTable->table[index] = hashElem;
 #ifdef PARALLEL
-  pthread_mutex_lock(hashTable->cntLock);
-  hashTable->entryCount++;
-  pthread_mutex_unlock(hashTable->cntLock);
+  /* threads may insert into disjoint slots concurrently */
+  __atomic_add_fetch(&(hashTable->entryCount), 1, __ATOMIC_RELAXED);
 #else
   hashTable->entryCount++;
 #endif
@@ -215,18 +199,6 @@ void destroyHashTable(HashTable *hashTable, void (*freeValue)(void *value))
 	}
     }
 
-#ifdef PARALLEL
-  pthread_mutex_destroy(hashTable->cntLock);
-  free(hashTable->cntLock);
-  
-  FOR_0_LIMIT(i,hashTable->tableSize)
-    {
-      pthread_mutex_destroy(hashTable->lockPerSlot[i]);
-      free(hashTable->lockPerSlot[i]);
-    }
-  free(hashTable->lockPerSlot);
-#endif
-
   free(hashTable->commonAttributes);  
   free(hashTable->table);
   free(hashTable);
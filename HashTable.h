@@ -53,10 +53,6 @@ typedef struct hash_table
   unsigned int (*hashFunction)(struct hash_table *h, void *value);
   boolean (*equalFunction)(struct hash_table *hashtable, void *entrA, void *entryB);
   HashElem **table;
-#ifdef PARALLEL
-  pthread_mutex_t **lockPerSlot;
-  pthread_mutex_t *cntLock; 
-#endif
 } HashTable;
 
 typedef struct 
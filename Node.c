@@ -31,47 +31,89 @@
 #include "Node.h"
 
 
-IndexList *findAnIndependentComponent(HashTable *allNodes, Node *thisNode)
+static IndexList *prependIndex(int index, IndexList *list, Arena *arena)
 {
-  if(thisNode->visited)
-    return NULL; 
+  IndexList
+    *result = arenaAlloc(arena, sizeof(IndexList));
+  result->index = index; 
+  result->next = list; 
+  return result; 
+}
 
-  IndexList *iter  = thisNode->edges;   
-  thisNode->visited = TRUE;
-  IndexList *result = NULL; 
-  APPEND_INT(thisNode->id, result);
 
-  FOR_LIST(iter)
-  {
-    Node *found = searchHashTableWithInt(allNodes, iter->index);    
-    
-    if(  NOT found->visited)
-      {
-	IndexList *list = findAnIndependentComponent(allNodes, found);
-	result = concatenateIndexList(list, result);
-      }
-  }
-  
+NodeTable *createNodeTable(int numberOfEdges, Arena *arena)
+{
+  NodeTable 
+    *result = arenaAlloc(arena, sizeof(NodeTable));
+
+  result->tableSize = 64; 
+  while(result->tableSize < 4 * (unsigned int)numberOfEdges)
+    result->tableSize *= 2; 
+  result->slots = arenaAlloc(arena, result->tableSize * sizeof(Node*));
+
   return result; 
 }
 
 
-void freeNode(void *value)
+static Node **getSlot(NodeTable *table, int id)
 {
-  Node *node = value; 
-  freeIndexList(node->edges);
-  free(node);
+  unsigned int 
+    position = ((unsigned int)id * 2654435761U) & (table->tableSize - 1);
+
+  while(table->slots[position] && table->slots[position]->id != id)
+    position = (position + 1) & (table->tableSize - 1);
+
+  return table->slots + position; 
 }
 
 
+Node *findNode(NodeTable *table, int id)
+{
+  return *getSlot(table, id);
+}
+
 
-boolean nodeEqual(HashTable *hashTable, void *entryA, void *entryB)
+static void addDirectedEdge(NodeTable *table, int a, int b, Arena *arena)
 {
-  return ((Node*)entryA)->id  == ((Node*)entryB)->id;  
+  Node 
+    **slot = getSlot(table, a);
+
+  if( NOT *slot)
+    {
+      *slot = arenaAlloc(arena, sizeof(Node));
+      (*slot)->id = a; 
+    }
+
+  (*slot)->edges = prependIndex(b, (*slot)->edges, arena);
+}
+
+
+void addEdge(NodeTable *table, int a, int b, Arena *arena)
+{
+  addDirectedEdge(table, a, b, arena);
+  addDirectedEdge(table, b, a, arena);
 }
 
 
-unsigned int nodeHashValue(HashTable *hashTable, void *value)
+IndexList *findAnIndependentComponent(NodeTable *allNodes, Node *thisNode, Arena *arena)
 {
-  return ((Node*)value)->id; 
+  if(thisNode->visited)
+    return NULL; 
+
+  IndexList *iter  = thisNode->edges;   
+  thisNode->visited = TRUE;
+  IndexList *result = prependIndex(thisNode->id, NULL, arena);
+
+  FOR_LIST(iter)
+  {
+    Node *found = findNode(allNodes, iter->index);    
+    
+    if(  NOT found->visited)
+      {
+	IndexList *list = findAnIndependentComponent(allNodes, found, arena);
+	result = concatenateIndexList(list, result);
+      }
+  }
+  
+  return result; 
 }
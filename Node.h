@@ -33,7 +33,7 @@
 
 #include "common.h"
 #include "List.h"
-#include "HashTable.h"
+#include "Arena.h"
 
 typedef struct _node
 {
@@ -42,10 +42,17 @@ typedef struct _node
   IndexList *edges;
 } Node; 
 
-boolean nodeEqual(HashTable *hashTable, void *entryA, void *entryB);
-unsigned int nodeHashValue(HashTable *hashTable, void *value);
-void freeNode(void *value);
-IndexList *findAnIndependentComponent(HashTable *allNodes, Node *thisNode);
+/* open addressing by bipartition id, everything lives in an arena */
+typedef struct
+{
+  Node **slots; 
+  unsigned int tableSize; 
+} NodeTable; 
+
+NodeTable *createNodeTable(int numberOfEdges, Arena *arena);
+Node *findNode(NodeTable *table, int id);
+void addEdge(NodeTable *table, int a, int b, Arena *arena);
+IndexList *findAnIndependentComponent(NodeTable *allNodes, Node *thisNode, Arena *arena);
 
 
 #endif
@@ -0,0 +1,455 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "ProfileCache.h"
+#include "Tree.h"
+
+
+static uint64_t alignOffset(uint64_t offset)
+{
+  return ((offset + PROFILE_CACHE_ALIGNMENT - 1) / PROFILE_CACHE_ALIGNMENT) * PROFILE_CACHE_ALIGNMENT; 
+}
+
+
+static void writeSection(FILE *file, uint64_t *position, uint64_t offset, void *data, size_t size)
+{
+  static const char 
+    padding[PROFILE_CACHE_ALIGNMENT] = {0}; 
+
+  assert(offset >= *position && offset - *position <= PROFILE_CACHE_ALIGNMENT);
+  
+  if(fwrite(padding, 1, offset - *position, file) != offset - *position
+     || (size && fwrite(data, 1, size, file) != size))
+    {
+      printf("ERROR: could not write the bipartition profile.\n");
+      exit(-1);
+    }
+
+  *position = offset + size; 
+}
+
+
+/* fingerprint of a bipartition, as computed while reading the trees */
+static uint64_t getFingerprint(All *tr, BitVector *bitVector)
+{
+  uint64_t
+    hash = 0; 
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,tr->mxtips)
+    if(NTH_BIT_IS_SET(bitVector, i))
+      hash ^= tr->nodep[i + 1]->hash; 
+
+  return hash; 
+}
+
+
+boolean isProfileCache(char *fileName)
+{
+  char 
+    magic[sizeof(PROFILE_CACHE_MAGIC)]; 
+  struct stat 
+    fileInfo; 
+  int 
+    fd = open(fileName, O_RDONLY); 
+  boolean 
+    result = FALSE; 
+
+  if(fd == -1)
+    return FALSE; 
+
+  /* do not consume anything from pipes */
+  if(fstat(fd, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode)
+     && read(fd, magic, sizeof(magic)) == sizeof(magic))
+    result = NOT memcmp(magic, PROFILE_CACHE_MAGIC, sizeof(magic)); 
+  
+  close(fd);
+  return result; 
+}
+
+
+ProfileCache *openProfileCache(char *fileName)
+{
+  ProfileCache 
+    *result = CALLOC(1, sizeof(ProfileCache));
+  ProfileCacheHeader 
+    *header; 
+  struct stat 
+    fileInfo; 
+  int 
+    fd = open(fileName, O_RDONLY);
+
+  if(fd == -1 || fstat(fd, &fileInfo) != 0)
+    {
+      printf("The file %s you want to open for reading does not exist, exiting ...\n", fileName);
+      exit(-1);
+    }
+
+  result->fileName = fileName; 
+  result->length = fileInfo.st_size; 
+
+  if(result->length < sizeof(ProfileCacheHeader))
+    {
+      printf("ERROR: %s is not a complete bipartition profile.\n", fileName);
+      exit(-1);
+    }
+
+#ifndef WIN32
+  /* private and writable, since the vectors are modified in place */
+  result->buffer = mmap(NULL, result->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(result->buffer != MAP_FAILED)
+    result->isMapped = TRUE; 
+  else
+#endif
+    {
+      size_t 
+	numRead = 0; 
+
+      result->buffer = CALLOC(result->length, sizeof(char));
+      while(numRead < result->length)
+	{
+	  ssize_t 
+	    n = read(fd, result->buffer + numRead, result->length - numRead);
+	  if(n <= 0)
+	    {
+	      printf("ERROR: could not read bipartition profile %s.\n", fileName);
+	      exit(-1);
+	    }
+	  numRead += n; 
+	}
+    }
+  close(fd);
+
+  header = result->header = (ProfileCacheHeader*)result->buffer; 
+
+  if(memcmp(header->magic, PROFILE_CACHE_MAGIC, sizeof(header->magic)))
+    {
+      printf("ERROR: %s is not a bipartition profile.\n", fileName);
+      exit(-1);
+    }
+
+  if(header->version != PROFILE_CACHE_VERSION 
+     || header->byteOrder != PROFILE_CACHE_BYTE_ORDER
+     || header->bitVectorSize != sizeof(BitVector))
+    {
+      printf("ERROR: the bipartition profile %s has been created by a different version of RogueNaRok\n\
+or on a different architecture. Please create it again from the bootstrap trees.\n", fileName);
+      exit(-1);
+    }
+
+  if(header->fileLength != result->length)
+    {
+      printf("ERROR: the bipartition profile %s is truncated.\n", fileName);
+      exit(-1);
+    }
+
+  return result; 
+}
+
+
+void closeProfileCache(ProfileCache *cache)
+{
+#ifndef WIN32
+  if(cache->isMapped)
+    munmap(cache->buffer, cache->length);
+  else
+#endif
+    free(cache->buffer);
+
+  free(cache);
+}
+
+
+void setupTreeFromProfileCache(All *tr, ProfileCache *cache)
+{
+  ProfileCacheHeader
+    *header = cache->header; 
+  char 
+    **names = CALLOC(header->mxtips, sizeof(char*)),
+    *iter = cache->buffer + header->namesOffset; 
+  unsigned int
+    i; 
+
+  FOR_0_LIMIT(i,header->mxtips)
+    {
+      names[i] = iter; 
+      iter += strlen(iter) + 1; 
+    }
+  
+  printf("Found a profile of %u bipartitions on %u taxa from %u trees in %s\n\n", header->numberOfBipartitions, header->mxtips, header->numberOfTrees, cache->fileName);
+
+  if(NOT setupTreeFromNames(tr, names, (uint64_t*)(cache->buffer + header->tipHashesOffset), header->mxtips))
+    {
+      printf("Something went wrong during tree initialisation. Sorry.\n");
+      exit(-1);
+    }
+
+  free(names);
+}
+
+
+/* 
+   adds the bipartitions of the best tree to the profile (elems) and
+   orders it in the same way as getOriginalBipArray does
+*/
+static void addBestTreeToProfile(All *tr, ProfileCache *cache, ProfileElem **elems, int numberOfElems, TreeReader *bestTree, Array *result)
+{
+  ProfileCacheHeader
+    *header = cache->header; 
+  ProfileElemAttr
+    *attr = result->commonAttributes; 
+  SplitHash
+    *splits; 
+  BitVector
+    **setBitVectors; 
+  unsigned int 
+    vectorLength = 0,
+    *positions,
+    tableSize = getHashTableSize(tr->mxtips * FC_INIT * 10);
+  boolean 
+    *isInProfile; 
+  int 
+    i,
+    index,
+    bCount = 0; 
+
+  setBitVectors = initBitVector(tr, &vectorLength);
+  assert(vectorLength == header->bitVectorLength); 
+
+  splits = createSplitHash(vectorLength, 1, tr->mxtips);
+  rewindTreeReader(bestTree);
+  readBestTree(tr, bestTree);
+  bitVectorInitravSplits(setBitVectors, tr->nodep[header->commonStartNumber]->back, tr->mxtips, vectorLength, splits, 0, &bCount);
+  assert(bCount == tr->mxtips - 3);
+
+  result->arrayTable = CALLOC(numberOfElems + splits->numberOfSplits, sizeof(ProfileElem*));
+  positions = CALLOC(numberOfElems + splits->numberOfSplits, sizeof(unsigned int));
+  isInProfile = CALLOC(splits->numberOfSplits, sizeof(boolean));
+
+  /* the elements of the tree set come first in reverse order, as they have been in the hash table */
+  FOR_0_LIMIT(i,numberOfElems)
+    {
+      ProfileElem
+	*elem = elems[numberOfElems - 1 - i];
+      uint64_t 
+	fingerprint = getFingerprint(tr, elem->bitVector);
+      
+      index = findSplit(splits, elem->bitVector, fingerprint);
+      if(index != -1)
+	{
+	  elem->isInMLTree = TRUE; 
+	  isInProfile[index] = TRUE; 
+	}
+
+      ((ProfileElem**)result->arrayTable)[result->length] = elem; 
+      positions[result->length++] = fingerprint % tableSize; 
+    }
+
+  /* only occur in the best tree */
+  FOR_0_LIMIT(index,splits->numberOfSplits)
+    if(NOT isInProfile[index])
+      {
+	ProfileElem
+	  *elem = arenaAlloc(attr->arena, sizeof(ProfileElem));
+	
+	elem->bitVector = arenaAlloc(attr->arena, vectorLength * sizeof(BitVector));
+	memcpy(elem->bitVector, splits->splits[index]->bitVector, vectorLength * sizeof(BitVector));
+	elem->treeVector = arenaAlloc(attr->arena, header->treeVectorLength * sizeof(BitVector));
+	elem->isInMLTree = TRUE; 
+
+	((ProfileElem**)result->arrayTable)[result->length] = elem; 
+	positions[result->length++] = splits->fingerprints[index] % tableSize; 
+      }
+
+  sortLikeChainedTable((ProfileElem**)result->arrayTable, positions, result->length);
+
+  freeSplitHash(splits);
+  freeBitVectors(setBitVectors, 2 * tr->mxtips);
+  free(setBitVectors);
+  free(positions);
+  free(isInProfile);
+}
+
+
+/* the counterpart of getOriginalBipArray, sets tr->numberOfTrees */
+Array *getBipArrayFromProfileCache(All *tr, ProfileCache *cache, TreeReader *bestTree)
+{
+  ProfileCacheHeader
+    *header = cache->header; 
+  Array 
+    *result = CALLOC(1, sizeof(Array));
+  ProfileElemAttr
+    *attr = CALLOC(1,sizeof(ProfileElemAttr));
+  ProfileElem 
+    **elems = CALLOC(header->numberOfBipartitions, sizeof(ProfileElem*));
+  BitVector 
+    *bitVectors = (BitVector*)(cache->buffer + header->bitVectorsOffset),
+    *treeVectors = (BitVector*)(cache->buffer + header->treeVectorsOffset),
+    lastByte = 0; 
+  int32_t
+    *support = (int32_t*)(cache->buffer + header->supportOffset);
+  unsigned char 
+    *mlFlags = (unsigned char*)(cache->buffer + header->mlFlagsOffset);
+  unsigned int 
+    i,
+    numberOfElems = 0; 
+
+  assert(header->mxtips == (unsigned int)tr->mxtips);
+
+  for(i = tr->mxtips; i < MASK_LENGTH * header->bitVectorLength; ++i)
+    lastByte |= mask32[i % MASK_LENGTH];
+
+  /* draw the same random numbers as getOriginalBipArray, such that all later ones are the same */
+  FOR_0_LIMIT(i,header->mxtips)
+    rand();
+
+  tr->numberOfTrees = header->numberOfTrees; 
+
+  attr->bitVectorLength = header->bitVectorLength; 
+  attr->treeVectorLength = header->treeVectorLength; 
+  attr->lastByte = lastByte; 
+  attr->commonStartNumber = header->commonStartNumber; 
+  attr->arena = createArena(ARENA_SLAB_SIZE);
+  result->commonAttributes = attr; 
+
+  /* the vectors are used in place */
+  FOR_0_LIMIT(i,header->numberOfBipartitions)
+    {
+      ProfileElem
+	*elem; 
+
+      /* bipartitions that only occur in the best tree of the run that created the profile */
+      if(mlFlags[i] && support[i] == 0)
+	continue; 
+
+      elem = elems[numberOfElems++] = arenaAlloc(attr->arena, sizeof(ProfileElem)); 
+      elem->bitVector = bitVectors + (size_t)i * header->bitVectorLength; 
+      elem->treeVector = treeVectors + (size_t)i * header->treeVectorLength; 
+      elem->treeVectorSupport = support[i]; 
+    }
+
+  if(bestTree)
+    {
+      addBestTreeToProfile(tr, cache, elems, numberOfElems, bestTree, result);
+      free(elems);
+    }
+  else
+    {
+      result->length = numberOfElems; 
+      result->arrayTable = elems; 
+    }
+
+  FOR_0_LIMIT(i,result->length)
+    ((ProfileElem**)result->arrayTable)[i]->id = i; 
+
+  return result; 
+}
+
+
+/* stores the profile as returned by getOriginalBipArray */
+void writeProfileCache(char *fileName, All *tr, Array *bipartitionProfile)
+{
+  ProfileElemAttr
+    *attr = bipartitionProfile->commonAttributes; 
+  ProfileCacheHeader 
+    header; 
+  FILE 
+    *file = myfopen(fileName, "wb");
+  uint64_t
+    position = 0,
+    namesLength = 0; 
+  int 
+    i; 
+
+  FOR_N_LIMIT(i,1,tr->mxtips + 1)
+    namesLength += strlen(tr->nameList[i]) + 1; 
+
+  memset(&header, 0, sizeof(ProfileCacheHeader));
+  memcpy(header.magic, PROFILE_CACHE_MAGIC, sizeof(header.magic));
+  header.version = PROFILE_CACHE_VERSION; 
+  header.byteOrder = PROFILE_CACHE_BYTE_ORDER; 
+  header.bitVectorSize = sizeof(BitVector); 
+  header.mxtips = tr->mxtips; 
+  header.numberOfTrees = tr->numberOfTrees; 
+  header.numberOfBipartitions = bipartitionProfile->length; 
+  header.bitVectorLength = attr->bitVectorLength; 
+  header.treeVectorLength = attr->treeVectorLength; 
+  header.commonStartNumber = attr->commonStartNumber;   
+  FOR_0_LIMIT(i,bipartitionProfile->length)
+    if(GET_PROFILE_ELEM(bipartitionProfile,i)->isInMLTree)
+      header.hasMLTree = TRUE; 
+
+  header.namesOffset = alignOffset(sizeof(ProfileCacheHeader));
+  header.tipHashesOffset = alignOffset(header.namesOffset + namesLength);
+  header.bitVectorsOffset = alignOffset(header.tipHashesOffset + tr->mxtips * sizeof(uint64_t));
+  header.treeVectorsOffset = alignOffset(header.bitVectorsOffset + (uint64_t)header.numberOfBipartitions * header.bitVectorLength * sizeof(BitVector));
+  header.supportOffset = alignOffset(header.treeVectorsOffset + (uint64_t)header.numberOfBipartitions * header.treeVectorLength * sizeof(BitVector));
+  header.mlFlagsOffset = alignOffset(header.supportOffset + (uint64_t)header.numberOfBipartitions * sizeof(int32_t));
+  header.fileLength = header.mlFlagsOffset + header.numberOfBipartitions; 
+
+  writeSection(file, &position, 0, &header, sizeof(ProfileCacheHeader));
+
+  FOR_N_LIMIT(i,1,tr->mxtips + 1)
+    writeSection(file, &position, i == 1 ? header.namesOffset : position, tr->nameList[i], strlen(tr->nameList[i]) + 1);
+
+  FOR_N_LIMIT(i,1,tr->mxtips + 1)
+    writeSection(file, &position, i == 1 ? header.tipHashesOffset : position, &(tr->nodep[i]->hash), sizeof(uint64_t));
+
+  FOR_0_LIMIT(i,bipartitionProfile->length)
+    writeSection(file, &position, i == 0 ? header.bitVectorsOffset : position, GET_PROFILE_ELEM(bipartitionProfile,i)->bitVector, header.bitVectorLength * sizeof(BitVector));
+
+  FOR_0_LIMIT(i,bipartitionProfile->length)
+    writeSection(file, &position, i == 0 ? header.treeVectorsOffset : position, GET_PROFILE_ELEM(bipartitionProfile,i)->treeVector, header.treeVectorLength * sizeof(BitVector));
+
+  FOR_0_LIMIT(i,bipartitionProfile->length)
+    {
+      int32_t 
+	support = GET_PROFILE_ELEM(bipartitionProfile,i)->treeVectorSupport;
+      writeSection(file, &position, i == 0 ? header.supportOffset : position, &support, sizeof(int32_t));
+    }
+
+  FOR_0_LIMIT(i,bipartitionProfile->length)
+    {
+      unsigned char 
+	isInMLTree = GET_PROFILE_ELEM(bipartitionProfile,i)->isInMLTree; 
+      writeSection(file, &position, i == 0 ? header.mlFlagsOffset : position, &isInMLTree, sizeof(unsigned char));
+    }
+
+  /* empty profile, the last offset has not been reached */
+  writeSection(file, &position, header.fileLength, NULL, 0);
+  assert(position == header.fileLength);
+
+  fclose(file);
+}
@@ -0,0 +1,97 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef PROFILE_CACHE_H
+#define PROFILE_CACHE_H
+
+#include <stdint.h>
+
+#include "common.h"
+#include "legacy.h"
+#include "TreeReader.h"
+#include "ProfileElem.h"
+
+/* 
+   The bipartition profile of a tree set can be stored in a binary
+   file, such that further runs on the same trees do not have to parse
+   them again. The file is mapped into memory and the vectors of the
+   profile are used in place.
+
+   Layout: header, taxon names (null-terminated, taxon 1 first), hash
+   values of the tips, bit vectors, tree vectors, support and ML-tree
+   flag of each bipartition. Sections start at multiples of
+   PROFILE_CACHE_ALIGNMENT.
+*/
+
+#define PROFILE_CACHE_MAGIC "RNRPROF"
+#define PROFILE_CACHE_VERSION 2
+#define PROFILE_CACHE_BYTE_ORDER 0x01020304
+#define PROFILE_CACHE_ALIGNMENT 64
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version; 
+  uint32_t byteOrder; 
+  uint32_t bitVectorSize; 
+  uint32_t mxtips; 
+  uint32_t numberOfTrees; 
+  uint32_t numberOfBipartitions; 
+  uint32_t bitVectorLength; 
+  uint32_t treeVectorLength; 
+  uint32_t commonStartNumber; 
+  uint32_t hasMLTree; 
+  uint64_t namesOffset; 
+  uint64_t tipHashesOffset; 
+  uint64_t bitVectorsOffset; 
+  uint64_t treeVectorsOffset; 
+  uint64_t supportOffset; 
+  uint64_t mlFlagsOffset; 
+  uint64_t fileLength; 
+} ProfileCacheHeader; 
+
+typedef struct
+{
+  char *fileName; 
+  char *buffer; 
+  size_t length; 
+  boolean isMapped; 
+  ProfileCacheHeader *header; 
+} ProfileCache; 
+
+boolean isProfileCache(char *fileName);
+ProfileCache *openProfileCache(char *fileName);
+void closeProfileCache(ProfileCache *cache);
+void setupTreeFromProfileCache(All *tr, ProfileCache *cache);
+Array *getBipArrayFromProfileCache(All *tr, ProfileCache *cache, TreeReader *bestTree);
+void writeProfileCache(char *fileName, All *tr, Array *bipartitionProfile);
+
+#endif
@@ -41,11 +41,19 @@ void addElemToArray(ProfileElem *elem, Array *array)
 }
 
 
-void freeProfileElem(ProfileElem *elem)
+/* elements and vectors of a profile are owned by the arenas in its attributes */
+void freeProfile(Array *profile)
 {
-  free(elem->treeVector);
-  free(elem->bitVector);  
-  free(elem);
+  ProfileElemAttr
+    *attr = profile->commonAttributes; 
+
+  if(attr->arena)
+    freeArena(attr->arena);
+  if(attr->treeVectorArena)
+    freeArena(attr->treeVectorArena);
+
+  free(attr);
+  freeArray(profile);
 }
 
 Array* profileToArray(HashTable *profile, boolean updateFrequencyCount, boolean assignIds)
@@ -142,13 +150,48 @@ int sortBySupport(const void *a, const void *b)
 }
 
 
+/* 
+   stable counting sort by the number of bits set, empty slots go
+   last. This is the order a stable sort with sortBipProfile yields, but
+   in linear time.
+*/
+void sortProfileByBits(Array *bipartitionProfile, int mxtips)
+{
+  int
+    i, 
+    length = bipartitionProfile->length, 
+    *offsets = CALLOC(mxtips + 3, sizeof(int));
+  ProfileElem
+    **sorted = CALLOC(length + 1, sizeof(ProfileElem*));
+
+#define BUCKET_OF(elem) ((elem) ? (elem)->numberOfBitsSet : mxtips + 1)
+
+  FOR_0_LIMIT(i,length)
+    offsets[BUCKET_OF(GET_PROFILE_ELEM(bipartitionProfile, i)) + 1]++; 
+  for(i = 1; i < mxtips + 3; ++i)
+    offsets[i] += offsets[i-1]; 
+
+  FOR_0_LIMIT(i,length)
+    {
+      ProfileElem
+	*elem = GET_PROFILE_ELEM(bipartitionProfile, i); 
+      sorted[offsets[BUCKET_OF(elem)]++] = elem; 
+    }
+#undef BUCKET_OF
+
+  memcpy(bipartitionProfile->arrayTable, sorted, length * sizeof(ProfileElem*));
+  free(sorted);
+  free(offsets);
+}
+
+
 /* what is the index in the (ordered) profile of the first element to
    have at least i bits set?  */
 int *createNumBitIndex(Array *bipartitionProfile, int mxtips)
 {
   int *result  = CALLOC(mxtips, sizeof(int));   
   memset(result, -1, mxtips * sizeof(int));
-  qsort(bipartitionProfile->arrayTable, bipartitionProfile->length, sizeof(ProfileElem**), sortBipProfile); 
+  sortProfileByBits(bipartitionProfile, mxtips);
   
   int
     i,    
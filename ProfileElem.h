@@ -38,14 +38,18 @@
 #include "HashTable.h"
 #include "common.h"
 #include "BitVector.h"
+#include "Arena.h"
 
 
 typedef struct 
 {
   BitVector bitVectorLength; 
   BitVector treeVectorLength;  
-  BitVector *randForTaxa;	/* random numbers to hash the vectors */
+  unsigned int *randForTaxa;	/* random numbers to hash the vectors */
   BitVector lastByte;		/* the padding bits */
+  int commonStartNumber;	/* the tip from which all trees have been traversed */
+  Arena *arena;			/* holds the elements and their bit vectors */
+  Arena *treeVectorArena; 
 } ProfileElemAttr;
 
 
@@ -55,7 +59,7 @@ typedef struct profile_elem
   BitVector *treeVector;
   int treeVectorSupport;
   boolean isInMLTree;
-  BitVector id;
+  int id;
   int numberOfBitsSet;
 } ProfileElem;
 
@@ -63,10 +67,11 @@ typedef struct profile_elem
 #define GET_DROPSET_ELEM(array,index) (((Dropset**)array->arrayTable)[(index)])
 
 int *createNumBitIndex(Array *bipartitionProfile, int mxtips);
+void sortProfileByBits(Array *bipartitionProfile, int mxtips);
 int sortById(const void *a, const void *b);
 int sortBySupport(const void *a, const void *b);
 int sortBipProfile(const void *a, const void *b);
 Array *cloneProfileArrayFlat(const Array *array);
 void addElemToArray(ProfileElem *elem, Array *array);
-void freeProfileElem(ProfileElem *elem);
+void freeProfile(Array *profile);
 #endif
@@ -40,10 +40,15 @@
 #include "Dropset.h"
 #include "legacy.h"
 #include "newFunctions.h"
+#include "ProfileCache.h"
 #include "Node.h"
+#include "BitVectorKernels.h"
+#include "HammingIndex.h"
+#include "EventLog.h"
 
 #ifdef PARALLEL
 #include "parallel.h"
+#include "Scheduler.h"
 #include <pthread.h> 
 #endif
 
@@ -85,12 +90,18 @@ int bitVectorLength,
   mxtips; 
 
 Dropset **dropsetPerRound; 
+HammingIndex *hammingIndex = NULL; 
+Arena **roundArenas = NULL; 
+Arena **scratchArenas = NULL; 	/* reset after every dropset */
+int numberOfRoundArenas = 0; 
+EventLogSet *eventLogs = NULL; 	/* only when computing events in parallel */
 
 boolean computeSupport = TRUE;
 
 BitVector *droppedTaxa,
   *neglectThose, 
-  *paddingBits; 
+  *paddingBits,
+  *touchedTaxa;			/* taxa of splits (with few bits) that changed since the last evaluation */
 
 double labelPenalty = 0., 
   timeInc; 
@@ -114,12 +125,12 @@ void debug_dropsetConsistencyCheck(HashTable *mergingHash)
 	  if(ds == ds2)
 	    continue;
 
-	  if(indexListEqual(ds->taxaToDrop, ds2->taxaToDrop))
+	  if(dropsetEqual(mergingHash, ds, ds2))
 	    {
 	      PR("duplicate dropset: ");
-	      printIndexList(ds->taxaToDrop);
+	      printDropsetTaxaToFile(stdout, ds);
 	      PR(" and ");
-	      printIndexList(ds2->taxaToDrop);
+	      printDropsetTaxaToFile(stdout, ds2);
 	      PR("\n");
 	      exit(-1);
 	    }
@@ -133,34 +144,7 @@ void debug_dropsetConsistencyCheck(HashTable *mergingHash)
 
 boolean isCompatible(ProfileElem* elemA, ProfileElem* elemB, BitVector *droppedTaxa)
 {
-  unsigned int i;
-  
-  unsigned int 
-    *A = elemA->bitVector,
-    *C = elemB->bitVector;
-  
-  FOR_0_LIMIT(i,bitVectorLength)
-    if(A[i] & C[i]  & ~ (droppedTaxa[i] | paddingBits[i]) )
-      break;
-          
-  if(i == bitVectorLength)
-    return TRUE;
-  
-  FOR_0_LIMIT(i,bitVectorLength)
-    if( ( A[i] & ~C[i]  ) & ~ (droppedTaxa[i] | paddingBits[i]) )
-      break;
-   
-  if(i == bitVectorLength)  
-    return TRUE;  
-  
-  FOR_0_LIMIT(i,bitVectorLength)
-    if( ( ~A[i] & C[i] )  & ~ (droppedTaxa[i] | paddingBits[i]) )
-      break;
-  
-  if(i == bitVectorLength)
-    return TRUE;  
-  else
-    return FALSE;
+  return splitsAreCompatible(elemA->bitVector, elemB->bitVector, droppedTaxa, paddingBits, bitVectorLength);
 }
 
 
@@ -211,22 +195,6 @@ void debug_mergingHashSanityCheck(HashTable *mergingHash, int totalNumberOfBips)
 #endif
 
 
-boolean myBitVectorEqual(ProfileElem *elemA, ProfileElem *elemB)
-{
-  boolean normalEqual = TRUE,
-    complement = TRUE;
-
-  int i ;
-  FOR_0_LIMIT(i,bitVectorLength)
-    {
-      normalEqual = normalEqual && (  elemA->bitVector[i] == elemB->bitVector[i]);
-      complement  =  complement && (elemA->bitVector[i] == ~(elemB->bitVector[i] | droppedTaxa[i] | paddingBits[i]));
-    }
-
-  return normalEqual || complement;
-}
-
-
 boolean canMergeWithComplement(ProfileElem *elem)
 {
   return mxtips - taxaDropped - 2 * elem->numberOfBitsSet <= 2 * maxDropsetSize;
@@ -235,86 +203,73 @@ boolean canMergeWithComplement(ProfileElem *elem)
 
 boolean bitVectorEqual(ProfileElem *elemA, ProfileElem *elemB)
 {
-  boolean normalEqual = TRUE,
-    complement = TRUE;
-
-  int i ; 
-  FOR_0_LIMIT(i,bitVectorLength)
-    {
-      normalEqual = normalEqual && (  elemA->bitVector[i] == elemB->bitVector[i]);
-      complement  =  complement && (elemA->bitVector[i] == ~(elemB->bitVector[i] | droppedTaxa[i] | paddingBits[i]));
-    }
-
-  return normalEqual || complement;
+  return splitsAreEqual(elemA->bitVector, elemB->bitVector, droppedTaxa, paddingBits, bitVectorLength);
 }
 
 
-boolean mergedBipVanishes(MergingEvent *me, Array *bipartitionsById, IndexList *taxaToDrop)
+boolean mergedBipVanishes(MergingEvent *me, Array *bipartitionsById, Dropset *dropset)
 {
-  int vanBits = 0; 
+  int 
+    i,
+    vanBits = 0; 
 
-  IndexList
-    *iter = taxaToDrop;  
-  
   ProfileElem
     *elem = me->isComplex ? GET_PROFILE_ELEM(bipartitionsById, (me->mergingBipartitions).many->index)  : GET_PROFILE_ELEM(bipartitionsById, (me->mergingBipartitions).pair[0]);     
   
-  FOR_LIST(iter)
-    if(NTH_BIT_IS_SET(elem->bitVector,iter->index))
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
+    if(NTH_BIT_IS_SET(elem->bitVector,dropset->taxa[i]))
       vanBits++;
   
   return elem->numberOfBitsSet - vanBits < 2; 
 }
 
 
-/* insert dropset. If it is a multi-taxa dropset, gather all merging
-   events of sub-dropsets */
-Dropset *insertOrFindDropset(HashTable *hashtable, Dropset *dropset, unsigned int hashValue) 
+/* 
+   the dropset is only allocated, if it is not in the hash yet. In the
+   parallel version, only the thread owning the partition of the slot
+   may call this.
+*/
+Dropset *insertOrFindDropset(HashTable *hashtable, Dropset *key, unsigned int hashValue) 
 {
-  void
-    *result = searchHashTable(hashtable, dropset, hashValue);
+  Dropset
+    *result = searchHashTable(hashtable, key, hashValue);
 
-  if(result)
-    {
-      freeDropsetDeep(dropset, TRUE);
-      return result;
-    }
-  else
+  if( NOT result)
     {
-      insertIntoHashTable(hashtable, dropset, hashValue);      
-      return dropset;
+      result = CALLOC(1,sizeof(Dropset));
+      memcpy(result->taxa, key->taxa, key->numberOfTaxa * sizeof(int));
+      result->numberOfTaxa = key->numberOfTaxa; 
+      insertIntoHashTable(hashtable, result, hashValue);      
     }
+
+  return result;
 }
 
-boolean checkForMergerAndAddEvent(boolean complement, ProfileElem *elemA, ProfileElem *elemB, HashTable *mergingHash)
+static void addEventToHash(HashTable *mergingHash, Dropset *key, unsigned int hashValue, int bipA, int bipB)
 {
-  IndexList
-    *dropsetTaxa = getDropset(elemA,elemB,complement, neglectThose);
+  Dropset
+    *dropset = insertOrFindDropset(mergingHash, key, hashValue);
+
+  addEventToDropsetPrime(dropset, bipA, bipB);
+  dropset->modifiedInRound = dropRound; 
+}
+
+
+/* threads only log their events, see insertLoggedEvents */
+boolean checkForMergerAndAddEvent(boolean complement, ProfileElem *elemA, ProfileElem *elemB, HashTable *mergingHash, int tid)
+{
+  Dropset
+    key; 
   
-  if(dropsetTaxa)
+  if(getDropset(elemA,elemB,complement, neglectThose, &key))
     {
-      Dropset
-	*dropset,
-	*tmp = CALLOC(1,sizeof(Dropset));
-      tmp->taxaToDrop = dropsetTaxa;      
-      
-      unsigned int hashValue = 0; 
-      IndexList *iter =  dropsetTaxa; 
-      FOR_LIST(iter)  
-      {
-	assert(iter->index < mxtips);
-	hashValue ^= randForTaxa[ iter->index ];
-      }
+      unsigned int 
+	hashValue = dropsetHashValue(mergingHash, &key); 
       
-#ifdef PARALLEL
-      int position  = hashValue % mergingHash->tableSize;      
-      pthread_mutex_lock(mergingHash->lockPerSlot[position]);
-#endif
-      dropset = insertOrFindDropset(mergingHash, tmp, hashValue);
-      addEventToDropsetPrime(dropset, elemA->id, elemB->id);
-#ifdef PARALLEL
-      pthread_mutex_unlock(mergingHash->lockPerSlot[position]);
-#endif
+      if(eventLogs)
+	logMergingEvent(eventLogs, tid, &key, hashValue, mergingHash->tableSize, elemA->id, elemB->id);
+      else 
+	addEventToHash(mergingHash, &key, hashValue, elemA->id, elemB->id);
       return TRUE;
     } 
   else 
@@ -322,6 +277,37 @@ boolean checkForMergerAndAddEvent(boolean complement, ProfileElem *elemA, Profil
 }
 
 
+/* 
+   replays the logged events of the slots in partition in the order of
+   the jobs that created them
+*/
+void insertLoggedEvents(HashTable *mergingHash, int partition)
+{
+  int 
+    segment, 
+    i; 
+  Dropset
+    key; 
+
+  FOR_0_LIMIT(segment,eventLogs->numberOfSegments)
+    {
+      LoggedEvent
+	*events; 
+      int 
+	numberOfEvents = getLoggedEvents(eventLogs, segment, partition, &events);
+
+      FOR_0_LIMIT(i,numberOfEvents)
+	{
+	  LoggedEvent
+	    *event = events + i; 
+	  memcpy(key.taxa, event->taxa, event->numberOfTaxa * sizeof(int));
+	  key.numberOfTaxa = event->numberOfTaxa; 
+	  addEventToHash(mergingHash, &key, event->hashValue, event->bipA, event->bipB);
+	}
+    }
+}
+
+
 /* can i trust you tiny function? (practical relevant -> 0) */
 /* boolean bothDropsetsRelevant(ProfileElem *elemA) */
 boolean bothDropsetsRelevant(int numBits)
@@ -355,9 +341,6 @@ int cleanup_applyOneMergerEvent(MergingEvent *mergingEvent, Array *bipartitionsB
 	  FOR_0_LIMIT(j,treeVectorLength)
 	    resultBip->treeVector[j] |= elem->treeVector[j]; 
 	}
-	
-	freeIndexList(mergingEvent->mergingBipartitions.many);
-	free(mergingEvent);
     }
   else
     {      
@@ -383,12 +366,8 @@ int getSupportOfMRETreeHelper(Array *bipartitionProfile, Dropset *dropset)
     *taxaDroppedHere = copyBitVector(droppedTaxa, bitVectorLength); 
 
   if(dropset)
-    {
-      IndexList
-	*iter = dropset->taxaToDrop;
-      FOR_LIST(iter)	
-	FLIP_NTH_BIT(taxaDroppedHere, iter->index);  
-    }
+    FOR_0_LIMIT(j,dropset->numberOfTaxa)
+      FLIP_NTH_BIT(taxaDroppedHere, dropset->taxa[j]);
 
   qsort(bipartitionProfile->arrayTable, bipartitionProfile->length, sizeof(ProfileElem**), sortBySupport);
 
@@ -449,6 +428,7 @@ void getSupportGainedThreshold(MergingEvent *me, Array *bipartitionsById)
   BitVector
     *tmp;
   boolean isInMLTree = FALSE; 
+  int newSup; 
 
   if(me->isComplex)
     {
@@ -481,6 +461,8 @@ void getSupportGainedThreshold(MergingEvent *me, Array *bipartitionsById)
 	FOR_0_LIMIT(i, treeVectorLength)
 	  tmp[i] |= elem->treeVector[i];
       }
+      newSup = genericBitCount(tmp, treeVectorLength);
+      free(tmp);
     }
   else
     {
@@ -495,12 +477,9 @@ void getSupportGainedThreshold(MergingEvent *me, Array *bipartitionsById)
       if(rogueMode == ML_TREE_OPT && NOT isInMLTree)
 	return; 
       
-      tmp = CALLOC(treeVectorLength, sizeof(BitVector));      
-      FOR_0_LIMIT(i,treeVectorLength)
-	tmp[i] = elemA->treeVector[i] | elemB->treeVector[i];
+      newSup = unionBitCount(elemA->treeVector, elemB->treeVector, treeVectorLength);
     }
 
-  int newSup = genericBitCount(tmp, treeVectorLength);
   switch (rogueMode)
     {
     case MRE_CONSENSUS_OPT:
@@ -523,31 +502,268 @@ void getSupportGainedThreshold(MergingEvent *me, Array *bipartitionsById)
     default : 
       assert(0);
     }
-  
-  free(tmp);
 }
 
 
-int getSupportOfMRETree(Array *bipartitionsById,  Dropset *dropset)
+/* 
+   the events that take place, if the dropset is pruned (in the order
+   of the former event lists)
+*/
+MergingEvent **getEventsOfDropset(Dropset *dropset, int *numberOfEvents)
 {
-  List
-    *mergingEvents = NULL; 
-  if(dropset)
+  MergingEvent
+    **result; 
+  int 
+    i; 
+
+  *numberOfEvents = 0; 
+  if(maxDropsetSize == 1)
     {
-      if(maxDropsetSize == 1)
-	mergingEvents =  dropset->ownPrimeE; 
-      else
+      result = CALLOC(dropset->ownPrimeE.length + 1, sizeof(MergingEvent*));
+      FOR_0_LIMIT(i,dropset->ownPrimeE.length)
+	result[(*numberOfEvents)++] = GET_EVENT(dropset->ownPrimeE, i);
+    }
+  else
+    {
+      result = CALLOC(dropset->acquiredPrimeE.length + dropset->complexEvents.length + 1, sizeof(MergingEvent*));
+      FOR_0_LIMIT(i,dropset->complexEvents.length)
+	result[(*numberOfEvents)++] = dropset->complexEvents.events[i];
+      FOR_0_LIMIT(i,dropset->acquiredPrimeE.length)
+	result[(*numberOfEvents)++] = dropset->acquiredPrimeE.events[i];
+    }
+
+  return result; 
+}
+
+
+boolean bipartitionVanishesP(ProfileElem *elem, Dropset *dropset)
+{
+  int i,
+    result = elem->numberOfBitsSet;
+
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
+    if(NTH_BIT_IS_SET(elem->bitVector, dropset->taxa[i]))
+      result--;  
+
+  return result < 2; 
+}
+
+
+/* 
+   The greedy MRE consensus of the current splits (sorted by support,
+   ties in the order of the ids, as the stable qsort does). For every
+   position, the state of the greedy before it is known, such that the
+   consensus of a dropset can be resumed at the first split the dropset
+   affects.
+*/
+typedef struct 
+{
+  int length; 
+  ProfileElem **order;		/* by support */
+  int *positionOfId; 
+  int *acceptedBefore;		/* number of accepted splits before a position */
+  int *supportBefore;		/* and their support */
+  ProfileElem **acceptedSplits; 
+  int *firstConflict;		/* index into acceptedSplits for rejected splits, -1 else */
+  int *firstRejectedBy;		/* first position whose first conflict is this accepted split */
+  int *minimalQuadrant;		/* size of the smallest quadrant of this conflict */
+  int *weakRejected;		/* rejected, but a dropset may resolve the conflict */
+  int numberOfWeakRejected; 
+  int *smallSplits;		/* splits that may vanish */
+  int numberOfSmallSplits; 
+  int stop;			/* the greedy did not look at splits from here on */
+} IncrementalMRE; 
+
+IncrementalMRE *incrementalMRE = NULL; 
+
+
+/* number of taxa that have to be dropped at least to make the splits compatible */
+static int getMinimalQuadrant(ProfileElem *elemA, ProfileElem *elemB)
+{
+  int 
+    i,
+    both = 0, 
+    onlyA = 0, 
+    onlyB = 0; 
+
+  FOR_0_LIMIT(i,bitVectorLength)
+    {
+      BitVector
+	keep = ~(droppedTaxa[i] | paddingBits[i]);
+      both += BIT_COUNT(elemA->bitVector[i] & elemB->bitVector[i] & keep);
+      onlyA += BIT_COUNT(elemA->bitVector[i] & ~elemB->bitVector[i] & keep);
+      onlyB += BIT_COUNT(~elemA->bitVector[i] & elemB->bitVector[i] & keep);
+    }
+
+  return MIN(both, MIN(onlyA, onlyB)); 
+}
+
+
+static int getMRESupport(int support, int numberOfSplits)
+{
+  return computeSupport ? support : numberOfSplits; 
+}
+
+
+void prepareIncrementalMRE(Array *bipartitionsById)
+{
+  IncrementalMRE
+    *mre = CALLOC(1,sizeof(IncrementalMRE)); 
+  int
+    i,j,
+    numberAccepted = 0, 
+    support = 0; 
+
+  mre->order = CALLOC(bipartitionsById->length + 1, sizeof(ProfileElem*));
+  mre->positionOfId = CALLOC(bipartitionsById->length, sizeof(int));
+  FOR_0_LIMIT(i,bipartitionsById->length)
+    {
+      mre->positionOfId[i] = -1; 
+      if(GET_PROFILE_ELEM(bipartitionsById,i))
+	mre->order[mre->length++] = GET_PROFILE_ELEM(bipartitionsById,i);
+    }
+  qsort(mre->order, mre->length, sizeof(ProfileElem*), sortBySupport);
+  FOR_0_LIMIT(i,mre->length)
+    mre->positionOfId[mre->order[i]->id] = i; 
+
+  mre->acceptedBefore = CALLOC(mre->length + 1, sizeof(int));
+  mre->supportBefore = CALLOC(mre->length + 1, sizeof(int));
+  mre->acceptedSplits = CALLOC(mre->length + 1, sizeof(ProfileElem*));
+  mre->firstConflict = CALLOC(mre->length + 1, sizeof(int));
+  mre->firstRejectedBy = CALLOC(mre->length + 1, sizeof(int));
+  mre->minimalQuadrant = CALLOC(mre->length + 1, sizeof(int));
+  mre->weakRejected = CALLOC(mre->length + 1, sizeof(int));
+  mre->smallSplits = CALLOC(mre->length + 1, sizeof(int));
+
+  /* the same greedy as getSupportOfMRETreeHelper */
+  for(i = 0; i < mre->length && mre->order[i]->treeVectorSupport > thresh; ++i)
+    {
+      mre->acceptedBefore[i] = numberAccepted; 
+      mre->supportBefore[i] = support; 
+      mre->firstConflict[i] = -1; 
+      mre->acceptedSplits[numberAccepted++] = mre->order[i];
+      support += mre->order[i]->treeVectorSupport; 
+    }
+
+  for(; i < mre->length && numberAccepted < mxtips-3; ++i)
+    {
+      ProfileElem
+	*elemA = mre->order[i];
+
+      mre->acceptedBefore[i] = numberAccepted; 
+      mre->supportBefore[i] = support; 
+      mre->firstConflict[i] = -1; 
+
+      FOR_0_LIMIT(j,numberAccepted)
+	if(NOT isCompatible(elemA, mre->acceptedSplits[j], droppedTaxa))
+	  {
+	    mre->firstConflict[i] = j; 
+	    mre->minimalQuadrant[i] = getMinimalQuadrant(elemA, mre->acceptedSplits[j]);
+	    if(mre->minimalQuadrant[i] <= maxDropsetSize)
+	      mre->weakRejected[mre->numberOfWeakRejected++] = i; 
+	    break; 
+	  }
+
+      if(mre->firstConflict[i] == -1)
 	{
-	  List *iter = dropset->acquiredPrimeE ; 
-	  FOR_LIST(iter)
-	    APPEND(iter->value, mergingEvents);
-	  iter = dropset->complexEvents; 
-	  FOR_LIST(iter)
-	    APPEND(iter->value, mergingEvents);
+	  mre->acceptedSplits[numberAccepted++] = elemA;
+	  support += elemA->treeVectorSupport; 
 	}
     }
-  int
-    i;
+
+  mre->stop = i; 
+  FOR_0_LIMIT(j,numberAccepted)
+    mre->firstRejectedBy[j] = mre->length; 
+  for(j = mre->stop - 1; j >= 0; --j)
+    if(mre->firstConflict[j] != -1)
+      mre->firstRejectedBy[mre->firstConflict[j]] = j; 
+  for(; i <= mre->length; ++i)
+    {
+      mre->acceptedBefore[i] = numberAccepted; 
+      mre->supportBefore[i] = support; 
+      mre->firstConflict[i] = -1; 
+    }
+
+  FOR_0_LIMIT(i,mre->length)
+    if(mre->order[i]->numberOfBitsSet <= maxDropsetSize + 1)
+      mre->smallSplits[mre->numberOfSmallSplits++] = i; 
+
+  incrementalMRE = mre; 
+}
+
+
+void freeIncrementalMRE(void)
+{
+  IncrementalMRE
+    *mre = incrementalMRE; 
+
+  free(mre->order);
+  free(mre->positionOfId);
+  free(mre->acceptedBefore);
+  free(mre->supportBefore);
+  free(mre->acceptedSplits);
+  free(mre->firstConflict);
+  free(mre->firstRejectedBy);
+  free(mre->minimalQuadrant);
+  free(mre->weakRejected);
+  free(mre->smallSplits);
+  free(mre);
+  incrementalMRE = NULL; 
+}
+
+
+/* emerged splits are placed behind all splits with the same support */
+static int sortEmergedBySupport(const void *a, const void *b)
+{
+  ProfileElem
+    *elemA = (ProfileElem*)a,
+    *elemB = (ProfileElem*)b; 
+
+  if(elemA->treeVectorSupport != elemB->treeVectorSupport)
+    return elemA->treeVectorSupport > elemB->treeVectorSupport ? -1 : 1; 
+  return elemA->id - elemB->id; 
+}
+
+
+/* first position of a split with less support */
+static int getInsertPosition(IncrementalMRE *mre, int support)
+{
+  int 
+    low = 0, 
+    high = mre->length; 
+
+  while(low < high)
+    {
+      int mid = (low + high) / 2; 
+      if((int)mre->order[mid]->treeVectorSupport < support)
+	high = mid; 
+      else 
+	low = mid + 1; 
+    }
+
+  return low; 
+}
+
+
+static int intcmp(const void *a, const void *b); 
+
+
+/* 
+   support of the MRE consensus, if the dropset is pruned. Splits that
+   merge or vanish are removed, emerged splits are inserted and the
+   greedy is resumed at the first position that differs.
+*/
+int getSupportOfMRETree(Array *bipartitionsById,  Dropset *dropset)
+{
+  IncrementalMRE
+    *mre = incrementalMRE; 
+  MergingEvent
+    **mergingEvents; 
+  int 
+    i,j,
+    numberOfEvents = 0,
+    numberRemoved = 0,
+    numberOfEmerged = 0; 
 
   /* initial case  */
   if( NOT dropset)
@@ -557,96 +773,205 @@ int getSupportOfMRETree(Array *bipartitionsById,  Dropset *dropset)
       return tmp; 
     }
 
-  Array
-    *emergedBips = CALLOC(1,sizeof(Array)),
-    *finalArray  = CALLOC(1,sizeof(Array)),
-    *tmpArray = cloneProfileArrayFlat(bipartitionsById);
-  emergedBips->arrayTable = CALLOC(lengthOfList(mergingEvents), sizeof(ProfileElem*));
-  emergedBips->length = 0; 
-
-  finalArray->arrayTable = CALLOC(tmpArray->length, sizeof(ProfileElem*));
-  finalArray->length = 0;
-
-  /* kill merging bips from array */
-  List *meIter = mergingEvents ; 
-  FOR_LIST(meIter)
-  {
-    MergingEvent *me = meIter->value; 
-    if(me->isComplex)
-      {
-	IndexList *iter = me->mergingBipartitions.many; 
-	FOR_LIST(iter)	  
-	  GET_PROFILE_ELEM(tmpArray, iter->index) = NULL; 
-	
-	/* create emerged bips in other array */
-	ProfileElem *elem = CALLOC(1,sizeof(ProfileElem)); 
-	getSupportGainedThreshold(me,bipartitionsById);
-	elem->treeVectorSupport = me->supportGained; 
-	elem->bitVector = GET_PROFILE_ELEM(bipartitionsById, me->mergingBipartitions.many->index)->bitVector;
-	GET_PROFILE_ELEM(emergedBips, emergedBips->length) = elem;
-	emergedBips->length++;
-      }
-    else
+  assert(mre); 
+  mergingEvents = getEventsOfDropset(dropset, &numberOfEvents);
+
+  BitVector
+    *taxaDroppedHere = copyBitVector(droppedTaxa, bitVectorLength); 
+  FOR_0_LIMIT(j,dropset->numberOfTaxa)
+    FLIP_NTH_BIT(taxaDroppedHere, dropset->taxa[j]);
+
+  int 
+    maxRemoved = mre->numberOfSmallSplits + 1,
+    *removed; 
+  ProfileElem
+    *emerged = CALLOC(numberOfEvents + 1, sizeof(ProfileElem)); 
+
+  /* merging splits and emerged splits */
+  FOR_0_LIMIT(i,numberOfEvents)
+    {
+      MergingEvent *me = mergingEvents[i]; 
+      maxRemoved += me->isComplex ? lengthIndexList(me->mergingBipartitions.many) : 2; 
+    }
+  removed = CALLOC(maxRemoved, sizeof(int));
+
+  FOR_0_LIMIT(i,numberOfEvents)
+    {
+      MergingEvent *me = mergingEvents[i]; 
+      int representative; 
+      if(me->isComplex)
+	{
+	  IndexList *iter = me->mergingBipartitions.many; 
+	  FOR_LIST(iter)	  
+	    removed[numberRemoved++] = mre->positionOfId[iter->index];
+	  representative = me->mergingBipartitions.many->index; 
+	}
+      else
+	{
+	  removed[numberRemoved++] = mre->positionOfId[me->mergingBipartitions.pair[0]];
+	  removed[numberRemoved++] = mre->positionOfId[me->mergingBipartitions.pair[1]];
+	  representative = me->mergingBipartitions.pair[0]; 
+	}
+
+      getSupportGainedThreshold(me,bipartitionsById);
+      emerged[numberOfEmerged].treeVectorSupport = me->supportGained; 
+      emerged[numberOfEmerged].bitVector = GET_PROFILE_ELEM(bipartitionsById, representative)->bitVector;
+      emerged[numberOfEmerged].id = numberOfEmerged; /* order of the events */
+      numberOfEmerged++; 
+    }
+  free(mergingEvents);
+
+  /* vanishing splits */
+  FOR_0_LIMIT(i,mre->numberOfSmallSplits)
+    {
+      ProfileElem
+	*elem = mre->order[mre->smallSplits[i]];
+      if(bipartitionVanishesP(elem, dropset))
+	removed[numberRemoved++] = mre->smallSplits[i]; 
+    }
+
+  FOR_0_LIMIT(i,numberRemoved)
+    assert(removed[i] >= 0);
+  qsort(removed, numberRemoved, sizeof(int), intcmp);
+  qsort(emerged, numberOfEmerged, sizeof(ProfileElem), sortEmergedBySupport);
+  removed[numberRemoved] = mre->length; /* sentinel */
+
+  /* 
+     removed splits that were accepted relax the constraints and keep
+     the greedy from stopping early
+  */
+  int 
+    numberRemovedAccepted = 0,
+    *removedAccepted = CALLOC(numberRemoved + 1, sizeof(int)),
+    start = mre->length; 
+  FOR_0_LIMIT(i,numberRemoved)
+    if(removed[i] < mre->stop 
+       && mre->firstConflict[removed[i]] == -1
+       && (NOT numberRemovedAccepted || removedAccepted[numberRemovedAccepted-1] != mre->acceptedBefore[removed[i]]))
       {
-	int a = me->mergingBipartitions.pair[0],
-	  b = me->mergingBipartitions.pair[1];
-	GET_PROFILE_ELEM(tmpArray, a) = NULL; 
-	GET_PROFILE_ELEM(tmpArray, b) = NULL; 
-
-	/* create emerged bips in other array */
-	ProfileElem *elem = CALLOC(1,sizeof(ProfileElem)); 
-	getSupportGainedThreshold(me,bipartitionsById);
-	elem->treeVectorSupport = me->supportGained; 
-	elem->bitVector = GET_PROFILE_ELEM(bipartitionsById, a)->bitVector;
-	GET_PROFILE_ELEM(emergedBips, emergedBips->length) = elem;
-	emergedBips->length++;
+	removedAccepted[numberRemovedAccepted++] = mre->acceptedBefore[removed[i]];
+	start = MIN(start, mre->firstRejectedBy[mre->acceptedBefore[removed[i]]]);
       }
-  }
+  if(numberRemovedAccepted || numberOfEmerged)
+    start = MIN(start, mre->stop);
+
+  /* the first position, where the decision of the greedy may differ */
+  if(numberOfEmerged)
+    start = MIN(start, getInsertPosition(mre, emerged[0].treeVectorSupport));
+  FOR_0_LIMIT(i,mre->numberOfWeakRejected)
+    {
+      int 
+	position = mre->weakRejected[i]; 
+      if(position >= start)
+	break; 
+      if(mre->minimalQuadrant[position] <= dropset->numberOfTaxa
+	 && isCompatible(mre->order[position], mre->acceptedSplits[mre->firstConflict[position]], taxaDroppedHere))
+	start = position; 
+    }
+
+  /* the state before it */
+  ProfileElem
+    **mreSplits = CALLOC(mre->length + numberOfEmerged + 1, sizeof(ProfileElem*)); 
+  int 
+    numberAccepted = 0,
+    support = 0, 
+    position = start, 
+    nextRemoved = 0,
+    nextEmerged = 0; 
+  boolean
+    phaseOne = TRUE, 
+    *stillAccepted = CALLOC(mre->acceptedBefore[mre->length] + 1, sizeof(boolean)); /* splits accepted before, that are accepted here */
 
-  /* kill vanishing bips from array */
-  FOR_0_LIMIT(i, tmpArray->length)
+  j = 0; 
+  FOR_0_LIMIT(i,mre->acceptedBefore[start])
     {
-      if( GET_PROFILE_ELEM(tmpArray,i) ) 
+      if(j < numberRemovedAccepted && removedAccepted[j] == i)
 	{
-	  ProfileElem *elem = GET_PROFILE_ELEM(tmpArray,i);
-	  int remainingBits = elem->numberOfBitsSet; 
-	  IndexList *iter = dropset->taxaToDrop; 
-	  FOR_LIST(iter)
-	    if(NTH_BIT_IS_SET(elem->bitVector,  iter->index))
-	      remainingBits--;	  
-	  if(remainingBits > 1) 
-	    addElemToArray(elem, finalArray); 
+	  j++; 
+	  continue; 
 	}
+      stillAccepted[i] = TRUE; 
+      mreSplits[numberAccepted++] = mre->acceptedSplits[i];
+      support += mre->acceptedSplits[i]->treeVectorSupport; 
     }
 
-  FOR_0_LIMIT(i, emergedBips->length)
-    addElemToArray(GET_PROFILE_ELEM(emergedBips, i), finalArray);
+  while(nextRemoved < numberRemoved && removed[nextRemoved] < start)
+    nextRemoved++;
+
+  /* resume the greedy */
+  while(TRUE)
+    {
+      ProfileElem 
+	*elem = NULL; 
+      boolean
+	isBaseSplit = FALSE; 
+
+      while(position < mre->length && removed[nextRemoved] == position)
+	{
+	  position++; 
+	  while(removed[nextRemoved] < position)
+	    nextRemoved++; 
+	}
 
-  free(tmpArray->arrayTable);  free(tmpArray);
+      if(nextEmerged < numberOfEmerged 
+	 && (position == mre->length || (int)emerged[nextEmerged].treeVectorSupport > (int)mre->order[position]->treeVectorSupport))
+	elem = emerged + nextEmerged++; 
+      else if(position < mre->length)
+	{
+	  elem = mre->order[position++];
+	  isBaseSplit = TRUE; 
+	}
+      else 
+	break; 
 
-  int result = getSupportOfMRETreeHelper(finalArray, dropset);
+      if(isBaseSplit && position - 1 < mre->stop && mre->firstConflict[position-1] == -1)
+	stillAccepted[mre->acceptedBefore[position-1]] = TRUE; /* undone, if rejected */
 
-  if(maxDropsetSize > 1 )
-    freeListFlat(mergingEvents);    
+      if(phaseOne && elem->treeVectorSupport > thresh)
+	{
+	  mreSplits[numberAccepted++] = elem; 
+	  support += elem->treeVectorSupport; 
+	  continue; 
+	}
+      phaseOne = FALSE; 
 
-  FOR_0_LIMIT(i,emergedBips->length)
-    free(GET_PROFILE_ELEM(emergedBips,i));
-  free(emergedBips->arrayTable);  free(emergedBips);
-  
-  return result; 
-}
+      if(numberAccepted >= mxtips-3)
+	break; 
 
+      /* still conflicts with a split that was accepted */
+      if(isBaseSplit 
+	 && mre->firstConflict[position-1] != -1 
+	 && stillAccepted[mre->firstConflict[position-1]]
+	 && (mre->minimalQuadrant[position-1] > dropset->numberOfTaxa
+	     || NOT isCompatible(elem, mre->acceptedSplits[mre->firstConflict[position-1]], taxaDroppedHere)))
+	continue; 
+
+      boolean 
+	compatibleP = TRUE; 
+      FOR_0_LIMIT(j,numberAccepted)
+	if(NOT isCompatible(elem, mreSplits[j], taxaDroppedHere))
+	  {
+	    compatibleP = FALSE; 
+	    break; 
+	  }
 
-boolean bipartitionVanishesP(ProfileElem *elem, Dropset *dropset)
-{
-  IndexList *iter = dropset->taxaToDrop;
-  int result = elem->numberOfBitsSet;
+      if(compatibleP)
+	{
+	  mreSplits[numberAccepted++] = elem; 
+	  support += elem->treeVectorSupport; 
+	}
+      else if(isBaseSplit && position - 1 < mre->stop && mre->firstConflict[position-1] == -1)
+	stillAccepted[mre->acceptedBefore[position-1]] = FALSE; 
+    }
 
-  FOR_LIST(iter)
-    if(NTH_BIT_IS_SET(elem->bitVector, iter->index))
-      result--;  
+  free(mreSplits);
+  free(stillAccepted);
+  free(removedAccepted);
+  free(removed);
+  free(emerged);
+  free(taxaDroppedHere);
 
-  return result < 2; 
+  return getMRESupport(support, numberAccepted); 
 }
 
 
@@ -667,7 +992,6 @@ void removeMergedBipartitions(Array *bipartitionsById, Array *bipartitionProfile
 	{
 	  GET_PROFILE_ELEM(bipartitionProfile, i) = NULL;
 	  GET_PROFILE_ELEM(bipartitionsById, elem->id) = NULL;
-	  freeProfileElem(elem);
 #ifdef PRINT_VERY_VERBOSE
 	  PR("CLEAN UP: removing %d from bip profile because of merger\n", elem->id);
 #endif
@@ -692,33 +1016,13 @@ boolean eventMustBeRecomputed(MergingEvent *meIter, BitVector *mergingBipartitio
 }
 
 
-boolean checkValidityOfEvent(BitVector *obsoleteBips, List *elem)
+boolean checkValidityOfEvent(BitVector *obsoleteBips, MergingEvent *me)
 {
-  MergingEvent
-    *me = elem->value; 
-  boolean
-    killP = FALSE;
+  /* only prime events survive a round */
+  assert(NOT me->isComplex);
 
-  if(me->isComplex)
-    {      
-      IndexList
-	*iter  = me->mergingBipartitions.many;      
-      FOR_LIST(iter)
-	killP |= NTH_BIT_IS_SET(obsoleteBips, iter->index);       
-      if(killP)
-      	freeIndexList(me->mergingBipartitions.many);
-    }
-  else
-    killP = NTH_BIT_IS_SET(obsoleteBips, me->mergingBipartitions.pair[0]) || NTH_BIT_IS_SET(obsoleteBips, me->mergingBipartitions.pair[1]) ;   
-
-  if(killP)
-    {
-      free(me);
-      return FALSE;
-    }
-  else
-    return TRUE; 
-}
+  return NOT (NTH_BIT_IS_SET(obsoleteBips, me->mergingBipartitions.pair[0]) || NTH_BIT_IS_SET(obsoleteBips, me->mergingBipartitions.pair[1])) ;   
+}
 
 
 #ifdef LATER
@@ -840,65 +1144,76 @@ void debug_assureCleanStructure(HashTable *hashtable, BitVector *mergingBipartit
 
 
 
+/* removes the events that became invalid */
+void cleanup_eventsOfDropset(Dropset *dropset, BitVector *mergingBipartitions)
+{
+  EventVector
+    *events = &(dropset->ownPrimeE);
+  int 
+    i,
+    numberValid = 0; 
+
+  /* always remove combined events (they live in the arena of the round) and acquired elems */
+  dropset->complexEvents.length = 0; 
+  dropset->acquiredPrimeE.length = 0; 
+
+  /* prime events */
+  FOR_0_LIMIT(i,events->length)
+    if( checkValidityOfEvent(mergingBipartitions, events->events + i) ) 
+      events->events[numberValid++] = events->events[i];
+  if(numberValid != events->length)
+    dropset->modifiedInRound = dropRound + 1; 
+  events->length = numberValid; 
+
+  /* as with the former lists, the order is reversed */
+  FOR_0_LIMIT(i,numberValid / 2)
+    {
+      MergingEvent tmp = events->events[i];
+      events->events[i] = events->events[numberValid - 1 - i];
+      events->events[numberValid - 1 - i] = tmp; 
+    }
+}
+
+
 void cleanup_mergingEvents(HashTable *mergingHash, BitVector *mergingBipartitions, BitVector *candidateBips, int length)
 {
   HashTableIterator
     *htIter;
+  Array
+    *allDropsets; 
+  int
+    i, 
+    cnt = 0;
 
-  int i; 
   FOR_0_LIMIT(i,GET_BITVECTOR_LENGTH(length))
     mergingBipartitions[i] |= candidateBips[i];
 
   if( NOT mergingHash->entryCount)
-    return;
-
-  FOR_HASH(htIter, mergingHash)
     {
-      Dropset
-	*dropset = getCurrentValueFromHashTableIterator(htIter);
-    
-      /* always remove combined events */
-      List *iter = dropset->complexEvents;
-      FOR_LIST(iter)
-      {
-	MergingEvent *me = iter->value; 
-	assert(me);
-	if(me && me->isComplex)
-	  {
-	    freeIndexList(me->mergingBipartitions.many);
-	    free(me);
-	  }	
-      }
-      freeListFlat(dropset->complexEvents);
-      
-      /* always remove acquired elems */
-      freeListFlat(dropset->acquiredPrimeE);
+      free(mergingBipartitions);  
+      return;
     }
-  free(htIter);
 
-  /* reduce own elements */
-  FOR_HASH_2(htIter, mergingHash)
-    {
-      Dropset
-	*dropset = getCurrentValueFromHashTableIterator(htIter);
+  allDropsets = CALLOC(1,sizeof(Array));
+  allDropsets->arrayTable = CALLOC(mergingHash->entryCount, sizeof(Dropset*));
+  FOR_HASH(htIter, mergingHash)
+    GET_DROPSET_ELEM(allDropsets, cnt++) = getCurrentValueFromHashTableIterator(htIter);
+  free(htIter);
+  assert(cnt == mergingHash->entryCount);
+  allDropsets->length = cnt; 
 
-      assert(dropset);
+#ifdef PARALLEL
+  globalPArgs->allDropsets = allDropsets; 
+  globalPArgs->mergingBipartitions = mergingBipartitions; 
+  distributeJobs(allDropsets->length);
+  masterBarrier(THREAD_CLEANUP_EVENTS, globalPArgs);
+#else
+  FOR_0_LIMIT(i,allDropsets->length)
+    cleanup_eventsOfDropset(GET_DROPSET_ELEM(allDropsets, i), mergingBipartitions);
+#endif
 
-      /* prime events */
-      List 
-	*iter = dropset->ownPrimeE, 
-	*start = NULL; 
-      while(iter)
-	{
-	  List *next = iter->next;
-	  if( checkValidityOfEvent(mergingBipartitions, iter) ) 
-	    APPEND(iter->value, start); 
-	  free(iter);
-	  iter = next; 
-	}
-      dropset->ownPrimeE = start; 
-    }
-  free(htIter);  
+  free(allDropsets->arrayTable);
+  free(allDropsets);
   
 #ifdef MYDEBUG
   debug_assureCleanStructure(mergingHash, mergingBipartitions);
@@ -908,42 +1223,95 @@ void cleanup_mergingEvents(HashTable *mergingHash, BitVector *mergingBipartition
 }
 
 
+/* 
+   a split with at most maxDropsetSize + 1 bits may vanish with a
+   dropset. If it changes, all dropsets that intersect it have to be
+   evaluated again.
+*/
+static void touchTaxaOfSplit(ProfileElem *elem)
+{
+  int 
+    i; 
+
+  if(elem->numberOfBitsSet > maxDropsetSize + 1)
+    return; 
+
+  FOR_0_LIMIT(i,bitVectorLength)
+#ifdef PARALLEL
+    __atomic_fetch_or(touchedTaxa + i, elem->bitVector[i], __ATOMIC_RELAXED);
+#else
+    touchedTaxa[i] |= elem->bitVector[i]; 
+#endif
+}
+
+
 /* 
    • inverses the bit vector, if more than half of the remaining taxa
    bits is set. This is better anyway, is the bit vector do not get
    that physically heavy (assuming that a 1 weighs more than a 0)
    • assuming, we already know the numbers of bits set 
    • assuming, bits are unflipped, if the taxon was dropped  
+   Returns TRUE, if the split was inverted.
 */
+boolean unifyOneBipartition(ProfileElem *elem, int remainingTaxa)
+{
+  int
+    j,
+    bvLen = GET_BITVECTOR_LENGTH(mxtips);
+
+  if( NOT elem
+      || elem->numberOfBitsSet <= remainingTaxa / 2)	
+    return FALSE; 
+
+  touchTaxaOfSplit(elem);
+  FOR_0_LIMIT(j,bvLen)
+    elem->bitVector[j] = ~(elem->bitVector[j] | paddingBits[j] |  droppedTaxa[j]);
+  elem->numberOfBitsSet = remainingTaxa - elem->numberOfBitsSet;
+  touchTaxaOfSplit(elem);
+
+  return TRUE; 
+}
+
+
 void unifyBipartitionRepresentation(Array *bipartitionArray,  BitVector *droppedTaxa)
 {
   int
-    i,j,
+    i,
     bvLen = GET_BITVECTOR_LENGTH(mxtips),
     remainingTaxa = mxtips - genericBitCount(droppedTaxa, bvLen);
+  char
+    *inverted = CALLOC(bipartitionArray->length + 1, sizeof(char));
 
 #ifdef PRINT_VERY_VERBOSE
   PR("remaining taxa: %d\n", remainingTaxa);
   PR("inverting bit vectors: ");
 #endif
 
+#ifdef PARALLEL
+  globalPArgs->bipartitionProfile = bipartitionArray; 
+  globalPArgs->remainingTaxa = remainingTaxa; 
+  globalPArgs->splitFlags = inverted; 
+  distributeJobs(bipartitionArray->length);
+  masterBarrier(THREAD_UNIFY, globalPArgs);
+#else
   FOR_0_LIMIT(i,bipartitionArray->length)
-    {
-      ProfileElem
-	*elem = GET_PROFILE_ELEM(bipartitionArray,i);
-
-      if( elem
-	  && elem->numberOfBitsSet > remainingTaxa / 2)	
-	{
+    inverted[i] = unifyOneBipartition(GET_PROFILE_ELEM(bipartitionArray,i), remainingTaxa);
+#endif
 
+  /* the hamming index is updated by the master only */
+  FOR_0_LIMIT(i,bipartitionArray->length)
+    if(inverted[i])
+      {
+	ProfileElem
+	  *elem = GET_PROFILE_ELEM(bipartitionArray,i);
 #ifdef PRINT_VERY_VERBOSE
-	  PR("%d (%d bits set), ", elem->id, elem->numberOfBitsSet);
+	PR("%d (%d bits set), ", elem->id, elem->numberOfBitsSet);
 #endif
-	  FOR_0_LIMIT(j,bvLen)
-	    elem->bitVector[j] = ~(elem->bitVector[j] | paddingBits[j] |  droppedTaxa[j]);
-	  elem->numberOfBitsSet = remainingTaxa - elem->numberOfBitsSet;
-	}
-    }
+	if(hammingIndex)
+	  updateHammingIndex(hammingIndex, elem);
+      }
+  free(inverted);
+
 #ifdef PRINT_VERY_VERBOSE
   PR("\n");
 #endif
@@ -1018,30 +1386,25 @@ int getInitScore(Array *bipartitionProfile)
 }
 
 
+void fprintRogueNames(All *tr, FILE *file, Dropset *dropset)
+{
+  int i; 
+
+  for(i = dropset->numberOfTaxa - 1; i >= 0; --i)
+    fprintf(file, i == dropset->numberOfTaxa - 1 ? "%s" : ",%s", tr->nameList[dropset->taxa[i]+1]);
+}
+
+
 void printDropsetImprovement(Dropset *dropset, All *tr, int cumScore)
 {  
 #ifndef PRINT_DROPSETS
   return ; 
 #endif
   
-  IndexList
-    *iter = dropset->taxaToDrop;
-  boolean isFirst = TRUE;
-
-  FOR_LIST(iter)
-  {
-    PR( isFirst ? ">%d" : ",%d", iter->index);
-    isFirst = FALSE;    
-  }
-
-  isFirst = TRUE;
+  PR(">");
+  printDropsetTaxaToFile(stdout, dropset);
   PR("\t");
-  iter = dropset->taxaToDrop; 
-  FOR_LIST(iter)
-  {
-    PR(isFirst ? "%s" : ",%s" , tr->nameList[iter->index+1]);
-    isFirst = FALSE;
-  }
+  fprintRogueNames(tr, stdout, dropset);
 
   PR("\t");
   PR("%f\t%f\n",
@@ -1050,23 +1413,6 @@ void printDropsetImprovement(Dropset *dropset, All *tr, int cumScore)
 }
 
 
-void fprintRogueNames(All *tr, FILE *file, IndexList *list)
-{
-  boolean isFirst = TRUE; 
-
-  FOR_LIST(list)
-  {
-    if(isFirst)
-      {
-	fprintf(file, "%s", tr->nameList[list->index+1]);
-	isFirst = FALSE;
-      }
-    else
-      fprintf(file, ",%s", tr->nameList[list->index+1]); 
-  }
-}
-
-
 void printRogueInformationToFile( All *tr, FILE *rogueOutput, int bestCumEver, int *cumScores, Dropset **dropsetInRound)
 {
   int
@@ -1076,9 +1422,9 @@ void printRogueInformationToFile( All *tr, FILE *rogueOutput, int bestCumEver, i
   while ( NOT reached)
     {
       fprintf(rogueOutput, "%d\t", i);       
-      printIndexListToFile(rogueOutput, dropsetInRound[i]->taxaToDrop); 
+      printDropsetTaxaToFile(rogueOutput, dropsetInRound[i]); 
       fprintf(rogueOutput, "\t");
-      fprintRogueNames(tr, rogueOutput, dropsetInRound[i]->taxaToDrop);
+      fprintRogueNames(tr, rogueOutput, dropsetInRound[i]);
       fprintf(rogueOutput, "\t%f\t%f\n", 
 	      (double)(cumScores[i]  - cumScores[i-1] )/ (double)(computeSupport ? tr->numberOfTrees : 1.0),
 	      (double)cumScores[i] / (double)((computeSupport ? numberOfTrees : 1 ) * (mxtips-3)) ); 
@@ -1095,11 +1441,42 @@ void printRogueInformationToFile( All *tr, FILE *rogueOutput, int bestCumEver, i
 }
 
 
-void findCandidatesForBip(HashTable *mergingHash, ProfileElem *elemA, boolean firstMerge, Array *bipartitionsById, Array *bipartitionProfile, int* indexByNumberBits)
+static int intcmp(const void *a, const void *b)
+{
+  return *(int*)a - *(int*)b; 
+}
+
+
+static void checkCandidateForBip(HashTable *mergingHash, ProfileElem *elemA, ProfileElem *elemB, boolean compMerge, int tid)
+{
+  if(
+     maxDropsetSize == 1 && 
+     NOT compMerge && 
+     elemA->numberOfBitsSet == elemB->numberOfBitsSet)
+    return;
+
+  boolean foundOne = FALSE;
+  if(compMerge)
+    foundOne = checkForMergerAndAddEvent(TRUE,elemA, elemB, mergingHash, tid); 
+      
+  if(NOT foundOne || bothDropsetsRelevant(elemA->numberOfBitsSet))
+    checkForMergerAndAddEvent(FALSE, elemA, elemB, mergingHash, tid);	    
+}
+
+
+void findCandidatesForBip(HashTable *mergingHash, ProfileElem *elemA, boolean firstMerge, Array *bipartitionsById, Array *bipartitionProfile, int* indexByNumberBits, int tid)
 {
   ProfileElem 
     *elemB;
-  int indexInBitSortedArray; 
+  int 
+    indexInBitSortedArray, 
+    endOfRange,
+    i,
+    numberOfCandidates = 0,
+    capacity = 0,
+    *candidates = NULL,
+    complementBits = mxtips - taxaDropped - elemA->numberOfBitsSet, 
+    cost; 
 
   boolean
     compMerge = canMergeWithComplement(elemA);
@@ -1116,26 +1493,62 @@ void findCandidatesForBip(HashTable *mergingHash, ProfileElem *elemA, boolean fi
       elemA->numberOfBitsSet - maxDropsetSize < 0 ?
       indexByNumberBits[0]
       : indexByNumberBits[elemA->numberOfBitsSet-maxDropsetSize];
+
+  /* 
+     only bipartitions that differ from elemA (or its complement) in at
+     most maxDropsetSize taxa can yield a dropset. If the index promises
+     to be cheaper than scanning the range of the profile, we only visit
+     those (in the order of the profile).
+  */
+  endOfRange = elemA->numberOfBitsSet + maxDropsetSize + 1 < mxtips 
+    ? indexByNumberBits[elemA->numberOfBitsSet + maxDropsetSize + 1]
+    : bipartitionProfile->length; 
+  if(endOfRange <= indexInBitSortedArray)
+    endOfRange = bipartitionProfile->length; 
+
+  cost = getHammingCost(hammingIndex, elemA, droppedTaxa, paddingBits, FALSE, 
+			elemA->numberOfBitsSet - maxDropsetSize, elemA->numberOfBitsSet + maxDropsetSize);
+  if(compMerge)
+    cost += getHammingCost(hammingIndex, elemA, droppedTaxa, paddingBits, TRUE,
+			   complementBits - maxDropsetSize, MIN(complementBits, elemA->numberOfBitsSet) + maxDropsetSize);
+
+  if(cost >= endOfRange - indexInBitSortedArray)
+    {
+      for( ;
+	   indexInBitSortedArray < bipartitionProfile->length
+	     && (elemB = GET_PROFILE_ELEM(bipartitionProfile,indexInBitSortedArray))
+	     && elemB->numberOfBitsSet - elemA->numberOfBitsSet <= maxDropsetSize ;
+	   indexInBitSortedArray++)
+	checkCandidateForBip(mergingHash, elemA, elemB, compMerge, tid);
+      return; 
+    }
+
+  getHammingCandidates(hammingIndex, elemA, droppedTaxa, paddingBits, FALSE,
+		       elemA->numberOfBitsSet - maxDropsetSize, elemA->numberOfBitsSet + maxDropsetSize, 
+		       &candidates, &numberOfCandidates, &capacity);
+  if(compMerge)
+    getHammingCandidates(hammingIndex, elemA, droppedTaxa, paddingBits, TRUE,
+			 complementBits - maxDropsetSize, MIN(complementBits, elemA->numberOfBitsSet) + maxDropsetSize, 
+			 &candidates, &numberOfCandidates, &capacity);
+
+  FOR_0_LIMIT(i,numberOfCandidates)
+    candidates[i] = hammingIndex->positions[candidates[i]];
+  qsort(candidates, numberOfCandidates, sizeof(int), intcmp);
 	
-  for( ;
-       indexInBitSortedArray < bipartitionProfile->length
-	 && (elemB = GET_PROFILE_ELEM(bipartitionProfile,indexInBitSortedArray))
-	 && elemB->numberOfBitsSet - elemA->numberOfBitsSet <= maxDropsetSize ;
-       indexInBitSortedArray++)
+  FOR_0_LIMIT(i,numberOfCandidates)
     { 
-      if(
-	 maxDropsetSize == 1 && 
-	 NOT compMerge && 
-	 elemA->numberOfBitsSet == elemB->numberOfBitsSet)
+      if((i > 0 && candidates[i] == candidates[i-1])
+	 || candidates[i] < indexInBitSortedArray)
 	continue;
 
-      boolean foundOne = FALSE;
-      if(compMerge)
-	foundOne = checkForMergerAndAddEvent(TRUE,elemA, elemB, mergingHash); 
-      
-      if(NOT foundOne || bothDropsetsRelevant(elemA->numberOfBitsSet))
-	checkForMergerAndAddEvent(FALSE, elemA, elemB, mergingHash);	    
+      elemB = GET_PROFILE_ELEM(bipartitionProfile,candidates[i]);
+      assert(elemB);
+
+      if(elemB->numberOfBitsSet - elemA->numberOfBitsSet <= maxDropsetSize)
+	checkCandidateForBip(mergingHash, elemA, elemB, compMerge, tid);
     }
+
+  free(candidates);
 }
 
 
@@ -1145,109 +1558,135 @@ void createOrUpdateMergingHash(All *tr, HashTable *mergingHash, Array *bipartiti
   int  i; 
   FOR_0_LIMIT(i,bipartitionProfile->length)
     if(NTH_BIT_IS_SET(candidateBips, i))
-      findCandidatesForBip(mergingHash, GET_PROFILE_ELEM(bipartitionsById, i),  firstMerge, bipartitionsById, bipartitionProfile, indexByNumberBits);  
+      findCandidatesForBip(mergingHash, GET_PROFILE_ELEM(bipartitionsById, i),  firstMerge, bipartitionsById, bipartitionProfile, indexByNumberBits, 0);  
   
   free(candidateBips);
 }
 
 
-void combineEventsForOneDropset(Array *allDropsets, Dropset *refDropset, Array *bipartitionsById)
+static int sortDropsetsByPosition(const void *a, const void *b)
 {
-  List *allEventsUncombined = NULL;
-  refDropset->acquiredPrimeE = NULL; 
-  refDropset->complexEvents = NULL;
-  int eventCntr = 0; 
+  return (*(Dropset**)a)->position - (*(Dropset**)b)->position; 
+}
 
-  if(NOT refDropset->taxaToDrop->next)
-    {
-      List *iter =  refDropset->ownPrimeE;
-      FOR_LIST(iter)
-       APPEND(iter->value, refDropset->acquiredPrimeE);
-      return; 
-    }
 
-  /* gather all events */
-  int i; 
-  FOR_0_LIMIT(i,allDropsets->length)
-    {      
-      Dropset *currentDropset = GET_DROPSET_ELEM(allDropsets, i);
-      if( isSubsetOf(currentDropset->taxaToDrop, refDropset->taxaToDrop) )
-	{
-	  List
-	    *iter = currentDropset->ownPrimeE; 
-	  FOR_LIST(iter)
+/* 
+   a dropset has at most maxDropsetSize (sorted) taxa, so we rather
+   enumerate all of its subsets and look them up, than checking all
+   dropsets, whether they are a subset. The subsets are returned in the order of
+   the array of all dropsets.
+*/
+static int gatherSubsetDropsets(HashTable *mergingHash, Dropset *refDropset, Dropset **result)
+{
+  int 
+    numberFound = 0,
+    subset,
+    i; 
+
+  for(subset = 1; subset < (1 << refDropset->numberOfTaxa); ++subset)
+    {
+      Dropset 
+	key, 
+	*found; 
+      unsigned int
+	hashValue = 0; 
+
+      key.numberOfTaxa = 0; 
+      FOR_0_LIMIT(i,refDropset->numberOfTaxa)
+	if(subset & (1 << i))
 	  {
-	    APPEND(iter->value, allEventsUncombined);
-	    eventCntr++;
+	    key.taxa[key.numberOfTaxa++] = refDropset->taxa[i];
+	    hashValue ^= randForTaxa[refDropset->taxa[i]];
 	  }
-	}
+
+      if( (found = searchHashTable(mergingHash, &key, hashValue)) )
+	result[numberFound++] = found; 
     }
 
-  /* transform the edges into nodes */
-  HashTable *allNodes = createHashTable(eventCntr * 10, NULL, nodeHashValue, nodeEqual);
-  Node *found;
-  List *iter = allEventsUncombined; 
-  FOR_LIST(iter)
-  {
-    MergingEvent *me = (MergingEvent*)iter->value;
-    int a = me->mergingBipartitions.pair[0]; 
-    int b = me->mergingBipartitions.pair[1]; 
+  qsort(result, numberFound, sizeof(Dropset*), sortDropsetsByPosition);
 
+  return numberFound; 
+}
 
-    if( ( found = searchHashTableWithInt(allNodes, a) ) )
-      APPEND_INT(b,found->edges); 
-    else
-      {
-	Node *node = CALLOC(1,sizeof(Node));
-	node->id = a; 
-	APPEND_INT(b,node->edges);
-	insertIntoHashTable(allNodes, node, a);
-      }
 
-    if( ( found = searchHashTableWithInt(allNodes, b) ) )
-      APPEND_INT(a,found->edges); 
-    else
-      {
-	Node *node = CALLOC(1,sizeof(Node));
-	node->id = b; 
-	APPEND_INT(a,node->edges);
-	insertIntoHashTable(allNodes, node, b);
-      }
-  }
+/* 
+   only the complex events and their components outlive the call (in
+   arena), the graph of events is built in scratch
+*/
+void combineEventsForOneDropset(HashTable *mergingHash, Dropset *refDropset, Array *bipartitionsById, Arena *arena, Arena *scratch)
+{
+  int 
+    i,j, 
+    eventCntr = 0; 
 
-  iter = allEventsUncombined;
-  FOR_LIST(iter)
+  refDropset->acquiredPrimeE.length = 0; 
+  refDropset->complexEvents.length = 0;
+
+  if(refDropset->numberOfTaxa == 1)
+    {
+      refDropset->subsetModified = refDropset->modifiedInRound == dropRound || refDropset->numberOfSubsets != 1; 
+      refDropset->numberOfSubsets = 1; 
+      FOR_0_LIMIT(i,refDropset->ownPrimeE.length)
+	pushMergingEventRef(&refDropset->acquiredPrimeE, GET_EVENT(refDropset->ownPrimeE, i));
+      return; 
+    }
+
+  /* gather all events (the last one gathered is visited first) */
+  Dropset 
+    *subsetDropsets[1 << MAX_DROPSET_SIZE];
+  int 
+    numberOfSubsets = gatherSubsetDropsets(mergingHash, refDropset, subsetDropsets); 
+  refDropset->subsetModified = refDropset->numberOfSubsets != numberOfSubsets; 
+  refDropset->numberOfSubsets = numberOfSubsets; 
+  FOR_0_LIMIT(i,numberOfSubsets)
+    {
+      eventCntr += subsetDropsets[i]->ownPrimeE.length;
+      refDropset->subsetModified |= subsetDropsets[i]->modifiedInRound == dropRound; 
+    }
+  
+  MergingEvent
+    **allEventsUncombined = arenaAlloc(scratch, eventCntr * sizeof(MergingEvent*));
+  eventCntr = 0; 
+  FOR_0_LIMIT(i,numberOfSubsets)
+    FOR_0_LIMIT(j,subsetDropsets[i]->ownPrimeE.length)
+      allEventsUncombined[eventCntr++] = GET_EVENT(subsetDropsets[i]->ownPrimeE, j);
+
+  /* transform the edges into nodes */
+  NodeTable *allNodes = createNodeTable(eventCntr, scratch);
+  for(i = eventCntr - 1; i >= 0; --i)
+    addEdge(allNodes, allEventsUncombined[i]->mergingBipartitions.pair[0], allEventsUncombined[i]->mergingBipartitions.pair[1], scratch);
+
+  for(i = eventCntr - 1; i >= 0; --i)
   {
-    MergingEvent *me = (MergingEvent*)iter->value;
+    MergingEvent *me = allEventsUncombined[i];
     int a = me->mergingBipartitions.pair[0],
       b = me->mergingBipartitions.pair[1]; 
     
-    Node *foundA = searchHashTableWithInt(allNodes,a),
-      *foundB = searchHashTableWithInt(allNodes,b);
+    Node *foundA = findNode(allNodes,a),
+      *foundB = findNode(allNodes,b);
 
     if(NOT foundA->edges->next
        && NOT foundB->edges->next) 
       {
 	assert(foundA->edges->index == foundB->id ); 
 	assert(foundB->edges->index == foundA->id ); 
-	APPEND(me, refDropset->acquiredPrimeE); 
+	pushMergingEventRef(&refDropset->acquiredPrimeE, me); 
       }
     else
       {	
 	IndexList
-	  *component = findAnIndependentComponent(allNodes,foundA);
+	  *component = findAnIndependentComponent(allNodes,foundA, arena);
 	if( component)
 	  {
-	    MergingEvent *complexMe  = CALLOC(1,sizeof(MergingEvent));
+	    MergingEvent *complexMe  = arenaAlloc(arena, sizeof(MergingEvent));
 	    complexMe->mergingBipartitions.many = component; 
 	    complexMe->isComplex = TRUE;
-	    APPEND(complexMe,refDropset->complexEvents);
+	    pushMergingEventRef(&refDropset->complexEvents, complexMe);
 	  }
       }
   }
-  
-  destroyHashTable(allNodes, freeNode);
-  freeListFlat(allEventsUncombined);  
+
+  resetArena(scratch);
 }
 
 
@@ -1262,6 +1701,7 @@ HashTable *combineMergerEvents(HashTable *mergingHash, Array *bipartitionsById)
   FOR_HASH(htIter, mergingHash)
     {
       GET_DROPSET_ELEM(allDropsets, cnt) = getCurrentValueFromHashTableIterator(htIter);
+      GET_DROPSET_ELEM(allDropsets, cnt)->position = cnt; 
       cnt++;
     }
   free(htIter);
@@ -1271,12 +1711,13 @@ HashTable *combineMergerEvents(HashTable *mergingHash, Array *bipartitionsById)
 #ifdef PARALLEL
   globalPArgs->allDropsets = allDropsets; 
   globalPArgs->bipartitionsById =bipartitionsById; 
-  numberOfJobs = allDropsets->length;
+  globalPArgs->mergingHash = mergingHash; 
+  distributeJobs(allDropsets->length);
   masterBarrier(THREAD_COMBINE_EVENTS, globalPArgs); 
 #else
   int i; 
   FOR_0_LIMIT(i,allDropsets->length)   
-    combineEventsForOneDropset(allDropsets, GET_DROPSET_ELEM(allDropsets,i), bipartitionsById);
+    combineEventsForOneDropset(mergingHash, GET_DROPSET_ELEM(allDropsets,i), bipartitionsById, roundArenas[0], scratchArenas[0]);
 #endif
 
   free(allDropsets->arrayTable);
@@ -1286,10 +1727,11 @@ HashTable *combineMergerEvents(HashTable *mergingHash, Array *bipartitionsById)
 }
 
 
-void getLostSupportThreshold(MergingEvent *me, Array *bipartitionsById)
+/* does not modify the event, thus threads may share it */
+static int getSupportLost(MergingEvent *me, Array *bipartitionsById)
 {
   ProfileElem *elemA, *elemB ; 
-  me->supportLost = 0; 
+  int supportLost = 0; 
   
   if(me->isComplex)
     {
@@ -1303,13 +1745,13 @@ void getLostSupportThreshold(MergingEvent *me, Array *bipartitionsById)
 	case VANILLA_CONSENSUS_OPT : 
 	  {
 	    if(elemA->treeVectorSupport > thresh)
-	      me->supportLost += computeSupport ? elemA->treeVectorSupport : 1; 
+	      supportLost += computeSupport ? elemA->treeVectorSupport : 1; 
 	    break ;
 	  }
 	case ML_TREE_OPT: 
 	  {
 	    if(elemA->isInMLTree)
-	      me->supportLost += computeSupport ? elemA->treeVectorSupport : 1  ; 
+	      supportLost += computeSupport ? elemA->treeVectorSupport : 1  ; 
 	    break; 
 	  }
 	default : 
@@ -1328,49 +1770,46 @@ void getLostSupportThreshold(MergingEvent *me, Array *bipartitionsById)
 	case VANILLA_CONSENSUS_OPT: 
 	  {
 	    if(elemA->treeVectorSupport > thresh)
-	      me->supportLost += computeSupport ? elemA->treeVectorSupport : 1 ;
+	      supportLost += computeSupport ? elemA->treeVectorSupport : 1 ;
 	    if(elemB->treeVectorSupport > thresh)
-	      me->supportLost += computeSupport ? elemB->treeVectorSupport : 1;
+	      supportLost += computeSupport ? elemB->treeVectorSupport : 1;
 	    break; 
 	  }
 	case ML_TREE_OPT:
 	  {
 	    if(elemA->isInMLTree)
-	      me->supportLost += computeSupport ? elemA->treeVectorSupport : 1 ; 
+	      supportLost += computeSupport ? elemA->treeVectorSupport : 1 ; 
 	    if(elemB->isInMLTree)
-	      me->supportLost += computeSupport ? elemB->treeVectorSupport : 1 ; 
+	      supportLost += computeSupport ? elemB->treeVectorSupport : 1 ; 
 	  }
 	}
     }
+
+  return supportLost; 
+}
+
+
+void getLostSupportThreshold(MergingEvent *me, Array *bipartitionsById)
+{
+  me->supportLost = getSupportLost(me, bipartitionsById);
 }
 
 
 void evaluateDropset(HashTable *mergingHash, Dropset *dropset,Array *bipartitionsById, List *consensusBipsCanVanish )
 {
-  int result = 0; 
-  List
-    *allElems = NULL, 
-    *elemsToCheck = NULL;
-  
-  if(maxDropsetSize == 1)
-    elemsToCheck = dropset->ownPrimeE ;
-  else
-    {
-      List *otherIter = dropset->acquiredPrimeE; 
-      FOR_LIST(otherIter)
-	APPEND(otherIter->value, elemsToCheck);
-      otherIter = dropset->complexEvents;
-      FOR_LIST(otherIter)
-	APPEND(otherIter->value, elemsToCheck);
-      allElems = elemsToCheck; 
-    }
+  int 
+    result = 0,
+    i,
+    numberOfEvents; 
+  MergingEvent
+    **elemsToCheck = getEventsOfDropset(dropset, &numberOfEvents);
 
   BitVector
     *bipsSeen = CALLOC(GET_BITVECTOR_LENGTH(bipartitionsById->length), sizeof(BitVector));
 
-  FOR_LIST(elemsToCheck)    
+  FOR_0_LIMIT(i,numberOfEvents)
   {
-    MergingEvent *me = (MergingEvent*)elemsToCheck->value;
+    MergingEvent *me = elemsToCheck[i];
     
     if(NOT me->computed)
       {
@@ -1381,7 +1820,7 @@ void evaluateDropset(HashTable *mergingHash, Dropset *dropset,Array *bipartition
     
     result -= me->supportLost;
     if(  me->supportGained
-	 &&  NOT mergedBipVanishes(me, bipartitionsById, dropset->taxaToDrop) )
+	 &&  NOT mergedBipVanishes(me, bipartitionsById, dropset) )
       result += me->supportGained;   
     
     if(me->isComplex)
@@ -1395,7 +1834,7 @@ void evaluateDropset(HashTable *mergingHash, Dropset *dropset,Array *bipartition
 	      PR("problem:");
 	      printIndexList(me->mergingBipartitions.many);
 	      PR("at ");
-	      printIndexList(dropset->taxaToDrop);		
+	      printDropsetTaxaToFile(stdout, dropset);		
 	      PR("\n");
 	      exit(0);
 	    }
@@ -1410,7 +1849,7 @@ void evaluateDropset(HashTable *mergingHash, Dropset *dropset,Array *bipartition
 	FLIP_NTH_BIT(bipsSeen,me->mergingBipartitions.pair[1]);
       }
   }
-  freeListFlat(allElems);
+  free(elemsToCheck);
   
   
   /* handle vanishing bip */
@@ -1442,52 +1881,345 @@ void evaluateDropset(HashTable *mergingHash, Dropset *dropset,Array *bipartition
       }
   }  
 
-  free(bipsSeen);
-  dropset->improvement = result;
-}
+  free(bipsSeen);
+  dropset->improvement = result;
+  dropset->upToDate = TRUE; 
+}
+
+
+List *getConsensusBipsCanVanish(Array *bipartitionProfile)
+{
+  List
+    *consensusBipsCanVanish = NULL; 
+
+  if(rogueMode == VANILLA_CONSENSUS_OPT
+     || rogueMode == MRE_CONSENSUS_OPT)
+    {
+      int i; 
+      FOR_0_LIMIT(i,bipartitionProfile->length)
+	{
+	  ProfileElem
+	    *elem = GET_PROFILE_ELEM(bipartitionProfile, i);
+
+	  if(NOT elem)
+	    break;
+
+	  if(elem->numberOfBitsSet - maxDropsetSize > 1 )
+	    break;
+      
+	  if(elem->treeVectorSupport > thresh)
+	    APPEND(elem,consensusBipsCanVanish);
+	}
+    }
+  else if(ML_TREE_OPT)
+    {
+      int i; 
+      FOR_0_LIMIT(i,bipartitionProfile->length)
+	{
+	  ProfileElem
+	    *elem = GET_PROFILE_ELEM(bipartitionProfile, i);
+
+	  if(NOT elem)
+	    break;
+      
+	  if(elem->isInMLTree)
+	    APPEND(elem,consensusBipsCanVanish);
+	}
+    }
+
+  return consensusBipsCanVanish;
+}
+
+
+/* 
+   the improvement of a dropset only changes, if its events (or those of
+   its subsets) changed or if a split that may vanish with it changed
+*/
+static boolean dropsetMustBeEvaluated(Dropset *dropset)
+{
+  int
+    i; 
+
+  if(NOT dropset->upToDate)
+    return TRUE; 
+
+  if(maxDropsetSize == 1 
+     ? dropset->modifiedInRound == dropRound 
+     /* which split represents a complex event depends on the order of the events */
+     : dropset->subsetModified || dropset->complexEvents.length)
+    return TRUE; 
+
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
+    if(NTH_BIT_IS_SET(touchedTaxa, dropset->taxa[i]))
+      return TRUE; 
+
+  return FALSE; 
+}
+
+
+/* 
+   TRUE, if a dropset with improvement A and size A is strictly better
+   than one with improvement B and size B
+*/
+static boolean qualityIsHigher(int improvementA, int sizeA, int improvementB, int sizeB)
+{
+  if(labelPenalty == 0.0)
+    return improvementA * sizeB > improvementB * sizeA; 
+  else 
+    return (double)(improvementA / (double)(computeSupport ?  numberOfTrees : 1.0)) - labelPenalty * (double)sizeA
+      > (double)(improvementB / (double)(computeSupport ?  numberOfTrees : 1.0)) - labelPenalty * (double)sizeB; 
+}
+
+
+/* 
+   TRUE, if dropset A is better than B (or there is no B). Ties are
+   broken by the position in the array of all dropsets, such that the
+   result of a reduction does not depend on the order.
+*/
+boolean dropsetIsBetter(Dropset *dropsetA, Dropset *dropsetB)
+{
+  if( NOT dropsetB)
+    return TRUE; 
+  if(qualityIsHigher(dropsetA->improvement, dropsetA->numberOfTaxa, dropsetB->improvement, dropsetB->numberOfTaxa))
+    return TRUE; 
+  if(qualityIsHigher(dropsetB->improvement, dropsetB->numberOfTaxa, dropsetA->improvement, dropsetA->numberOfTaxa))
+    return FALSE; 
+  return dropsetA->position < dropsetB->position; 
+}
+
+
+/* cheap upper bound of the support gained by an event */
+static int getSupportGainedBound(MergingEvent *me, Array *bipartitionsById)
+{
+  int
+    bestPossible = 0; 
+  boolean
+    isInMLTree = FALSE; 
+
+  if(me->computed)
+    return me->supportGained; 
+
+  if(me->isComplex)
+    {
+      IndexList
+	*iI = me->mergingBipartitions.many;  
+      FOR_LIST(iI)
+      {	
+	ProfileElem
+	  *elem = GET_PROFILE_ELEM(bipartitionsById, iI->index);
+	bestPossible += elem->treeVectorSupport;
+	isInMLTree |= elem->isInMLTree;
+      }
+    }
+  else
+    {
+      ProfileElem
+	*elemA = GET_PROFILE_ELEM(bipartitionsById, me->mergingBipartitions.pair[0]),
+	*elemB = GET_PROFILE_ELEM(bipartitionsById, me->mergingBipartitions.pair[1]);      
+      bestPossible = elemA->treeVectorSupport + elemB->treeVectorSupport; 
+      isInMLTree = elemA->isInMLTree || elemB->isInMLTree; 
+    }
+
+  if( rogueMode == VANILLA_CONSENSUS_OPT && bestPossible < thresh)
+    return 0; 
+  if( rogueMode == ML_TREE_OPT && NOT isInMLTree)
+    return 0;
+
+  return computeSupport ? MIN(bestPossible, numberOfTrees) : 1; 
+}
+
+
+/* 
+   the improvement of a dropset is at most the support gained by its
+   events minus the support lost
+*/
+static int getImprovementBound(Dropset *dropset, Array *bipartitionsById)
+{
+  int
+    result = 0,
+    i,
+    numberOfEvents; 
+  MergingEvent
+    **events = getEventsOfDropset(dropset, &numberOfEvents);
+
+  FOR_0_LIMIT(i,numberOfEvents)
+    {
+      MergingEvent
+	*me = events[i]; 
+      result += getSupportGainedBound(me, bipartitionsById) 
+	- (me->computed ? me->supportLost : getSupportLost(me, bipartitionsById)); 
+    }
+
+  free(events);
+  return result; 
+}
+
+
+typedef struct 
+{
+  Dropset *dropset; 
+  int key;			/* the improvement, if up to date, else a bound */
+  int position; 		/* ties are broken as in the linear scan */
+} HeapEntry; 
+
+
+static HeapEntry *selectionHeap = NULL; 
+
+
+/* 
+   marks the dropset, if it has to be evaluated, and computes its key
+   in the heap
+*/
+void prepareDropsetForSelection(Array *allDropsets, int position, Array *bipartitionsById)
+{
+  Dropset
+    *dropset = GET_DROPSET_ELEM(allDropsets, position); 
+  HeapEntry
+    *entry = selectionHeap + position; 
+
+  if(dropsetMustBeEvaluated(dropset))
+    dropset->upToDate = FALSE; 
+
+  entry->dropset = dropset; 
+  entry->position = position; 
+  entry->key = dropset->upToDate ? dropset->improvement : getImprovementBound(dropset, bipartitionsById); 
+}
+
+
+static boolean heapEntryBefore(HeapEntry *a, HeapEntry *b)
+{
+  if(qualityIsHigher(a->key, a->dropset->numberOfTaxa, b->key, b->dropset->numberOfTaxa))
+    return TRUE; 
+  if(qualityIsHigher(b->key, b->dropset->numberOfTaxa, a->key, a->dropset->numberOfTaxa))
+    return FALSE; 
+  return a->position < b->position; 
+}
+
+
+static void siftDown(HeapEntry *heap, int length, int i)
+{
+  while(2 * i + 1 < length)
+    {
+      int 
+	child = 2 * i + 1; 
+      if(child + 1 < length && heapEntryBefore(heap + child + 1, heap + child))
+	child++; 
+      if(NOT heapEntryBefore(heap + child, heap + i))
+	return; 
+
+      HeapEntry tmp = heap[i]; 
+      heap[i] = heap[child]; 
+      heap[child] = tmp; 
+      i = child; 
+    }
+}
+
+
+static void siftUp(HeapEntry *heap, int i)
+{
+  while(i > 0 && heapEntryBefore(heap + i, heap + (i - 1) / 2))
+    {
+      HeapEntry tmp = heap[i]; 
+      heap[i] = heap[(i - 1) / 2]; 
+      heap[(i - 1) / 2] = tmp; 
+      i = (i - 1) / 2; 
+    }
+}
+
+
+/* 
+   lazy greedy: dropsets are kept in a max-heap keyed by their
+   improvement (if it is up to date) or an upper bound of it. Only
+   dropsets whose bound is on top of the heap are evaluated
+   exactly. The dropset returned is the same as the one of a linear scan
+   over all evaluated dropsets.
+*/
+static Dropset *selectBestDropsetLazily(HashTable *mergingHash, Array *allDropsets, Array *bipartitionsById, List *consensusBipsCanVanish)
+{
+  int 
+    i,
+    length = allDropsets->length,
+#ifdef PARALLEL
+    /* each batch costs a barrier, thus batches grow */
+    batchSize = 16 * numberOfThreads; 
+#else
+    batchSize = 1; 
+#endif
+  HeapEntry
+    *heap = CALLOC(length, sizeof(HeapEntry)),
+    *batchEntries = CALLOC(length, sizeof(HeapEntry)); 
+  Array 
+    *batch = CALLOC(1,sizeof(Array)); 
+  Dropset 
+    *result = NULL; 
+
+  batch->arrayTable = CALLOC(length, sizeof(Dropset*));
 
+  selectionHeap = heap; 
+#ifdef PARALLEL
+  distributeJobs(length);
+  globalPArgs->allDropsets = allDropsets; 
+  globalPArgs->bipartitionsById = bipartitionsById; 
+  masterBarrier(THREAD_PREPARE_SELECTION, globalPArgs);
+#else
+  FOR_0_LIMIT(i,length)
+    prepareDropsetForSelection(allDropsets, i, bipartitionsById);
+#endif
+  selectionHeap = NULL; 
+  memset(touchedTaxa, 0, bitVectorLength * sizeof(BitVector));
 
-List *getConsensusBipsCanVanish(Array *bipartitionProfile)
-{
-  List
-    *consensusBipsCanVanish = NULL; 
+  for(i = length / 2 - 1; i >= 0; --i)
+    siftDown(heap, length, i);
 
-  if(rogueMode == VANILLA_CONSENSUS_OPT
-     || rogueMode == MRE_CONSENSUS_OPT)
+  while(length > 0)
     {
-      int i; 
-      FOR_0_LIMIT(i,bipartitionProfile->length)
+      if(heap[0].dropset->upToDate)
 	{
-	  ProfileElem
-	    *elem = GET_PROFILE_ELEM(bipartitionProfile, i);
-
-	  if(NOT elem)
-	    break;
-
-	  if(elem->numberOfBitsSet - maxDropsetSize > 1 )
-	    break;
-      
-	  if(elem->treeVectorSupport > thresh)
-	    APPEND(elem,consensusBipsCanVanish);
+	  result = heap[0].dropset; 
+	  break; 
 	}
-    }
-  else if(ML_TREE_OPT)
-    {
-      int i; 
-      FOR_0_LIMIT(i,bipartitionProfile->length)
+
+      /* pop the best bounds  */
+      batch->length = 0; 
+      while(length > 0 && batch->length < batchSize && NOT heap[0].dropset->upToDate)
 	{
-	  ProfileElem
-	    *elem = GET_PROFILE_ELEM(bipartitionProfile, i);
+	  batchEntries[batch->length] = heap[0]; 
+	  GET_DROPSET_ELEM(batch, batch->length) = heap[0].dropset; 
+	  batch->length++; 
+	  heap[0] = heap[--length]; 
+	  siftDown(heap, length, 0);
+	}
 
-	  if(NOT elem)
-	    break;
-      
-	  if(elem->isInMLTree)
-	    APPEND(elem,consensusBipsCanVanish);
+#ifdef PARALLEL
+      distributeJobs(batch->length);
+      globalPArgs->mergingHash = mergingHash; 
+      globalPArgs->allDropsets = batch; 
+      globalPArgs->bipartitionsById = bipartitionsById; 
+      globalPArgs->consensusBipsCanVanish = consensusBipsCanVanish;
+      masterBarrier(THREAD_EVALUATE_EVENTS, globalPArgs); 
+      batchSize *= 2; 
+#else
+      FOR_0_LIMIT(i, batch->length)
+	evaluateDropset(mergingHash, GET_DROPSET_ELEM(batch, i), bipartitionsById, consensusBipsCanVanish); 
+#endif
+
+      /* and push them back with their improvement */
+      FOR_0_LIMIT(i, batch->length)
+	{
+	  assert(batchEntries[i].dropset->upToDate);
+	  heap[length] = batchEntries[i]; 
+	  heap[length].key = batchEntries[i].dropset->improvement;
+	  siftUp(heap, length);
+	  length++; 
 	}
     }
 
-  return consensusBipsCanVanish;
+  free(batch->arrayTable);
+  free(batch);
+  free(batchEntries);
+  free(heap);
+
+  return result; 
 }
 
 
@@ -1514,6 +2246,7 @@ Dropset *evaluateEvents(HashTable *mergingHash, Array *bipartitionsById, Array *
   FOR_HASH(htIter, mergingHash)
     {    
       GET_DROPSET_ELEM(allDropsets,cnt) = getCurrentValueFromHashTableIterator(htIter);
+      GET_DROPSET_ELEM(allDropsets,cnt)->position = cnt; 
       cnt++; 
     }
   free(htIter); 
@@ -1523,70 +2256,41 @@ Dropset *evaluateEvents(HashTable *mergingHash, Array *bipartitionsById, Array *
   if(rogueMode == MRE_CONSENSUS_OPT)
     { 
       
+      prepareIncrementalMRE(bipartitionsById);
 #ifdef PARALLEL
-      numberOfJobs = allDropsets->length;
+      /* every thread reports its best dropset */
+      Dropset **bestPerThread = CALLOC(numberOfThreads, sizeof(Dropset*)); 
+      distributeJobs(allDropsets->length);
       globalPArgs->bipartitionsById =  bipartitionsById; 
       globalPArgs->allDropsets = allDropsets; 
+      globalPArgs->bestPerThread = bestPerThread; 
       masterBarrier(THREAD_MRE, globalPArgs); 
+      FOR_0_LIMIT(i,numberOfThreads)
+	if(bestPerThread[i] && dropsetIsBetter(bestPerThread[i], result))
+	  result = bestPerThread[i]; 
+      free(bestPerThread);
 #else
       
       FOR_0_LIMIT(i,allDropsets->length)	  
 	{
 	  Dropset *dropset =  GET_DROPSET_ELEM(allDropsets, i);
 	  dropset->improvement =  getSupportOfMRETree(bipartitionsById, dropset) - cumScore;
+	  if(dropsetIsBetter(dropset, result))
+	    result = dropset; 
 	}
 #endif     
+      freeIncrementalMRE();
     }
-  
-
-  /* evaluate dropsets */
-  if(rogueMode != MRE_CONSENSUS_OPT)
-    {
-#ifdef PARALLEL
-      numberOfJobs = allDropsets->length; 
-      globalPArgs->mergingHash = mergingHash; 
-      globalPArgs->allDropsets = allDropsets; 
-      globalPArgs->bipartitionsById = bipartitionsById; 
-      globalPArgs->consensusBipsCanVanish = consensusBipsCanVanish;
-      masterBarrier(THREAD_EVALUATE_EVENTS, globalPArgs); 
-#else
-      FOR_0_LIMIT(i, allDropsets->length)
-	{
-	  Dropset *dropset =  GET_DROPSET_ELEM(allDropsets, i);   
-	  evaluateDropset(mergingHash, dropset, bipartitionsById, consensusBipsCanVanish); 
-	}
-#endif
-    }
-  
-  FOR_0_LIMIT(i,allDropsets->length)
-    {      
-      Dropset
-	*dropset =  GET_DROPSET_ELEM(allDropsets, i);
+  else 
+    /* evaluate dropsets (the improvement of the others did not change) */
+    result = selectBestDropsetLazily(mergingHash, allDropsets, bipartitionsById, consensusBipsCanVanish); 
 
-      if(NOT result)
-	result = dropset;
-      else
-	{
-	  int drSize =  lengthIndexList(dropset->taxaToDrop),
-	    resSize = lengthIndexList(result->taxaToDrop);
-	  
-	  double oldQuality =  labelPenalty == 0.0  
-	    ? result->improvement * drSize 
-	    :  (double)(result->improvement / (double)(computeSupport ?  numberOfTrees : 1.0)) - labelPenalty * (double)resSize;
-	  double newQuality = labelPenalty == 0.0 
-	    ? dropset->improvement * resSize
-	    : (double)(dropset->improvement / (double)(computeSupport ? numberOfTrees : 1.0)) - labelPenalty * (double)drSize; 
-	  
-	  if( (newQuality  >  oldQuality) )
-	    result = dropset;	  
-	}
-    }
   freeListFlat(consensusBipsCanVanish);
 
   free(allDropsets->arrayTable);
   free(allDropsets);
 
-  if((result->improvement / (computeSupport ? numberOfTrees : 1.0) - labelPenalty * lengthIndexList(result->taxaToDrop))  > 0.0 )
+  if((result->improvement / (computeSupport ? numberOfTrees : 1.0) - labelPenalty * result->numberOfTaxa)  > 0.0 )
     return result;
 
   /* if(labelPenalty == 0.0 && result->improvement > 0) */
@@ -1599,10 +2303,83 @@ Dropset *evaluateEvents(HashTable *mergingHash, Array *bipartitionsById, Array *
 }
 
 
+/* the vectors are shared by all threads, but every thread sets the bits of its own splits */
+#ifdef PARALLEL
+#define SET_SHARED_BIT(bitVector,n) ATOMIC_FLIP_NTH_BIT(bitVector,n)
+#define CLEAR_SHARED_BIT(bitVector,n) ATOMIC_UNFLIP_NTH_BIT(bitVector,n)
+#define SHARED_BIT_IS_SET(bitVector,n) ATOMIC_NTH_BIT_IS_SET(bitVector,n)
+#else
+#define SET_SHARED_BIT(bitVector,n) FLIP_NTH_BIT(bitVector,n)
+#define CLEAR_SHARED_BIT(bitVector,n) UNFLIP_NTH_BIT(bitVector,n)
+#define SHARED_BIT_IS_SET(bitVector,n) NTH_BIT_IS_SET(bitVector,n)
+#endif
+
+
+/* 
+   removes the dropped taxa from a split. Returns TRUE, if the split
+   has to be updated in the hamming index.
+*/
+boolean cleanup_updateOneSplit(ProfileElem *elem, BitVector *mergingBipartitions, BitVector *newCandidates, Dropset *dropset)
+{
+  int 
+    i; 
+  boolean 
+    taxonDroppedP = FALSE;      
+
+  /* check if number of bits has changed  */
+  if( NOT elem 
+      || SHARED_BIT_IS_SET(mergingBipartitions,elem->id)) 
+    return FALSE; 
+
+  if( mxtips - taxaDropped - 2 * elem->numberOfBitsSet <= 2 * maxDropsetSize )	  
+    SET_SHARED_BIT(newCandidates, elem->id);
+
+  FOR_0_LIMIT(i,dropset->numberOfTaxa)
+    {
+      if(NTH_BIT_IS_SET(elem->bitVector, dropset->taxa[i])) 
+	{
+	  taxonDroppedP = TRUE;
+	  UNFLIP_NTH_BIT(elem->bitVector, dropset->taxa[i]);
+	  elem->numberOfBitsSet--;
+	}
+    }
+
+  if( NOT taxonDroppedP)
+    return FALSE; 
+
+  if(elem->numberOfBitsSet < 2)
+    { 
+      CLEAR_SHARED_BIT(newCandidates, elem->id);
+      SET_SHARED_BIT(mergingBipartitions, elem->id);
+      return FALSE; 
+    }	  
+
+  SET_SHARED_BIT(newCandidates, elem->id);
+  return TRUE; 
+}
+
+
 void cleanup_updateNumBitsAndCleanArrays(Array *bipartitionProfile, Array *bipartitionsById, BitVector *mergingBipartitions, BitVector *newCandidates, Dropset *dropset)
 {
-  int profileIndex; 
+  int 
+    profileIndex; 
+  char
+    *needsUpdate = CALLOC(bipartitionProfile->length + 1, sizeof(char));
+
+#ifdef PARALLEL
+  globalPArgs->bipartitionProfile = bipartitionProfile; 
+  globalPArgs->mergingBipartitions = mergingBipartitions; 
+  globalPArgs->newCandidates = newCandidates; 
+  globalPArgs->bestDropset = dropset; 
+  globalPArgs->splitFlags = needsUpdate; 
+  distributeJobs(bipartitionProfile->length);
+  masterBarrier(THREAD_UPDATE_SPLITS, globalPArgs);
+#else
+  FOR_0_LIMIT(profileIndex,bipartitionProfile->length)
+    needsUpdate[profileIndex] = cleanup_updateOneSplit(GET_PROFILE_ELEM(bipartitionProfile,profileIndex), mergingBipartitions, newCandidates, dropset);
+#endif
 
+  /* the hamming index is updated by the master only */
   FOR_0_LIMIT(profileIndex,bipartitionProfile->length)
     {
       ProfileElem
@@ -1610,45 +2387,24 @@ void cleanup_updateNumBitsAndCleanArrays(Array *bipartitionProfile, Array *bipar
 	      
       if( NOT elem )
 	continue;
-      
-      /* check if number of bits has changed  */
-      if(NOT NTH_BIT_IS_SET(mergingBipartitions,elem->id)) 
-	{	  
-	  if( mxtips - taxaDropped - 2 * elem->numberOfBitsSet <= 2 * maxDropsetSize )	  
-	    FLIP_NTH_BIT(newCandidates, elem->id);
-	  IndexList *iter = dropset->taxaToDrop;
-	  boolean taxonDroppedP = FALSE;      
-	  FOR_LIST(iter)
-	  {
-	    if(NTH_BIT_IS_SET(elem->bitVector, iter->index)) 
-	      {
-		taxonDroppedP = TRUE;
-		UNFLIP_NTH_BIT(elem->bitVector, iter->index);
-		elem->numberOfBitsSet--;
-	      }
-	  }
 
-	  if(taxonDroppedP)
-	    {
-	      if(elem->numberOfBitsSet < 2)
-		{ 
-		  UNFLIP_NTH_BIT(newCandidates, elem->id);
-		  FLIP_NTH_BIT(mergingBipartitions, elem->id);
-		}	  
-	      else
-		FLIP_NTH_BIT(newCandidates, elem->id);
-	    }
-	}
+      if(needsUpdate[profileIndex])
+	updateHammingIndex(hammingIndex, elem);
       
+      if(NTH_BIT_IS_SET(mergingBipartitions,elem->id) || NTH_BIT_IS_SET(newCandidates, elem->id))
+	touchTaxaOfSplit(elem);
+
       /* bip has been merged or vanished  */
       if(NTH_BIT_IS_SET(mergingBipartitions,elem->id)) 
 	{
 	  assert(NOT NTH_BIT_IS_SET(newCandidates, elem->id));
+	  removeFromHammingIndex(hammingIndex, elem);
 	  GET_PROFILE_ELEM(bipartitionProfile, profileIndex) = NULL;
 	  GET_PROFILE_ELEM(bipartitionsById, elem->id) = NULL;
-	  freeProfileElem(elem);
 	}
     }  
+
+  free(needsUpdate);
 }
 
 
@@ -1663,25 +2419,26 @@ BitVector *cleanup_applyAllMergerEvents(Array *bipartitionsById, Dropset *bestDr
       printDropset(bestDropset);
 #endif
       
-      List *iter = NULL ; 
+      int i; 
       if(maxDropsetSize == 1)
-	iter = bestDropset->ownPrimeE;
-      else 
-	iter = bestDropset->acquiredPrimeE; 
-      FOR_LIST(iter)
-      {
-	int newBipId = cleanup_applyOneMergerEvent((MergingEvent*)iter->value, bipartitionsById, mergingBipartitions);
-	FLIP_NTH_BIT(candidateBips, newBipId);
-      }
-
-      if(maxDropsetSize > 1 )
-	{
-	  iter = bestDropset->complexEvents;
-	  FOR_LIST(iter)
+	FOR_0_LIMIT(i,bestDropset->ownPrimeE.length)
 	  {
-	    int newBipId = cleanup_applyOneMergerEvent((MergingEvent*)iter->value, bipartitionsById, mergingBipartitions);
+	    int newBipId = cleanup_applyOneMergerEvent(GET_EVENT(bestDropset->ownPrimeE,i), bipartitionsById, mergingBipartitions);
 	    FLIP_NTH_BIT(candidateBips, newBipId);
 	  }
+      else 
+	{
+	  FOR_0_LIMIT(i,bestDropset->acquiredPrimeE.length)
+	    {
+	      int newBipId = cleanup_applyOneMergerEvent(GET_EVENT_REF(bestDropset->acquiredPrimeE,i), bipartitionsById, mergingBipartitions);
+	      FLIP_NTH_BIT(candidateBips, newBipId);
+	    }
+
+	  FOR_0_LIMIT(i,bestDropset->complexEvents.length)
+	    {
+	      int newBipId = cleanup_applyOneMergerEvent(GET_EVENT_REF(bestDropset->complexEvents,i), bipartitionsById, mergingBipartitions);
+	      FLIP_NTH_BIT(candidateBips, newBipId);
+	    }
 	}
     } 
   
@@ -1689,78 +2446,116 @@ BitVector *cleanup_applyAllMergerEvents(Array *bipartitionsById, Dropset *bestDr
 }
 
 
+/* what happens to a dropset, when the best dropset is dropped */
+#define REHASH_KEEP 0
+#define REHASH_FREE 1
+#define REHASH_FREE_IF_EMPTY 2
+#define REHASH_REINSERT 3
+
+/* 
+   decides, what happens to a dropset after bestDropset has been
+   dropped. Only reads the dropset, thus the threads can decide for
+   their share of the dropsets concurrently.
+*/
+char cleanup_rehashActionOfDropset(Dropset *dropset, Dropset *bestDropset)
+{
+  if(isSubDropset(dropset, bestDropset))
+    return REHASH_FREE; 
+  else if(NOT dropset->ownPrimeE.length)
+    return REHASH_FREE_IF_EMPTY; 
+  else if(dropsetsIntersect(dropset, bestDropset))
+    return REHASH_REINSERT; 
+  else 
+    return REHASH_KEEP; 
+}
+
+
 void cleanup_rehashDropsets(HashTable *mergingHash, Dropset *bestDropset)
 {
-  if(maxDropsetSize == 1)
+  if(maxDropsetSize == 1 || NOT mergingHash->entryCount)
     return; 
   
-  IndexList
-    *taxaToDrop = bestDropset->taxaToDrop;
+  HashTableIterator
+    *htIter; 
+  Array
+    *allDropsets = CALLOC(1,sizeof(Array)); 
+  char
+    *actions = CALLOC(mergingHash->entryCount, sizeof(char));
+  int
+    i, 
+    cnt = 0; 
 
-  List *allDropsets = NULL; 
-  HashTableIterator *htIter; 
+  allDropsets->arrayTable = CALLOC(mergingHash->entryCount, sizeof(Dropset*));
   FOR_HASH(htIter, mergingHash)
-    {
-      Dropset
-	*dropset = getCurrentValueFromHashTableIterator(htIter);
-      allDropsets = appendToList(dropset, allDropsets);
-    }
+    GET_DROPSET_ELEM(allDropsets, cnt++) = getCurrentValueFromHashTableIterator(htIter);
   free(htIter);
-  
-  List *iter = allDropsets; 
-  FOR_LIST(iter)
+  allDropsets->length = cnt; 
+
+#ifdef PARALLEL
+  globalPArgs->allDropsets = allDropsets; 
+  globalPArgs->bestDropset = bestDropset; 
+  globalPArgs->dropsetFlags = actions; 
+  distributeJobs(allDropsets->length);
+  masterBarrier(THREAD_REHASH_DROPSETS, globalPArgs);
+#else
+  FOR_0_LIMIT(i,allDropsets->length)
+    actions[i] = cleanup_rehashActionOfDropset(GET_DROPSET_ELEM(allDropsets, i), bestDropset);
+#endif
+
+  /* applied in the order of the hash, such that events are merged deterministically */
+  FOR_0_LIMIT(i,allDropsets->length)
   {
     Dropset
-      *dropset = (Dropset*)iter->value;
-
-    if( NOT dropset)
-      break;
+      *dropset = GET_DROPSET_ELEM(allDropsets, i);
 
-    if(NOT dropset->ownPrimeE || isSubsetOf(dropset->taxaToDrop, taxaToDrop) )
+    /* the dropset may have acquired the events of a reinserted dropset */
+    if(actions[i] == REHASH_FREE 
+       || (actions[i] == REHASH_FREE_IF_EMPTY && NOT dropset->ownPrimeE.length))
       {
 	removeElementFromHash(mergingHash, dropset);
-	freeDropsetDeep(dropset, FALSE);
+	freeDropsetDeep(dropset);
       }
-    else if(haveIntersection(dropset->taxaToDrop, taxaToDrop)) /* needs reinsert */
+    else if(actions[i] == REHASH_REINSERT)
       {
 	removeElementFromHash(mergingHash, dropset);
 
 #ifdef MYDEBUG 
-	int length = lengthIndexList(dropset->taxaToDrop);
+	int length = dropset->numberOfTaxa;
 #endif    
 
-	dropset->taxaToDrop = setMinusOf(dropset->taxaToDrop, taxaToDrop);
+	removeTaxaOfDropset(dropset, bestDropset);
 
 #ifdef MYDEBUG
-	assert(length > lengthIndexList(dropset->taxaToDrop));
+	assert(length > dropset->numberOfTaxa);
 #endif
 	unsigned int hv = mergingHash->hashFunction(mergingHash, dropset);
 	Dropset *found = searchHashTable(mergingHash, dropset, hv);
 	if( NOT found)
-	  insertIntoHashTable(mergingHash,dropset,hv);
+	  {
+	    dropset->modifiedInRound = dropRound + 1; 
+	    insertIntoHashTable(mergingHash,dropset,hv);
+	  }
 	else			/* reuse the merging events */
 	  {
-	    List
-	      *iter, *next; 
-	    for(iter = dropset->ownPrimeE; iter; iter = next)
-	      {
-		/* TODO potential error: double check, if this stuff did not already occur would be great */
-		next = iter->next; 
-		iter->next = found->ownPrimeE;
-		found->ownPrimeE = iter;
-	      }
-	    freeIndexList(dropset->taxaToDrop);
-	    free(dropset);
+	    int j; 
+	    found->modifiedInRound = dropRound + 1; 
+	    /* TODO potential error: double check, if this stuff did not already occur would be great */
+	    FOR_0_LIMIT(j,dropset->ownPrimeE.length)
+	      *pushMergingEvent(&(found->ownPrimeE)) = *GET_EVENT(dropset->ownPrimeE,j);
+	    freeDropsetDeep(dropset);
 	  } 	
       }
   }
-  freeListFlat(allDropsets);
+
+  free(actions);
+  free(allDropsets->arrayTable);
+  free(allDropsets);
 }
 
 BitVector *cleanup(All *tr, HashTable *mergingHash, Dropset *bestDropset, BitVector *candidateBips, Array *bipartitionProfile, Array *bipartitionsById)
 {
-  IndexList
-    *ilIter;
+  int 
+    i; 
 
   BitVector 
     *bipsToVanish = CALLOC(GET_BITVECTOR_LENGTH(bipartitionsById->length), sizeof(BitVector));
@@ -1775,9 +2570,8 @@ BitVector *cleanup(All *tr, HashTable *mergingHash, Dropset *bestDropset, BitVec
     }
 	  
   /* add to list of dropped taxa */
-  ilIter = bestDropset->taxaToDrop;
-  FOR_LIST(ilIter)
-    FLIP_NTH_BIT(droppedTaxa,ilIter->index);
+  FOR_0_LIMIT(i,bestDropset->numberOfTaxa)
+    FLIP_NTH_BIT(droppedTaxa,bestDropset->taxa[i]);
 
   /* remove merging bipartitions from arrays (not candidates) */
   cleanup_updateNumBitsAndCleanArrays(bipartitionProfile, bipartitionsById, bipsToVanish,candidateBips,bestDropset );
@@ -1787,7 +2581,6 @@ BitVector *cleanup(All *tr, HashTable *mergingHash, Dropset *bestDropset, BitVec
   cleanup_rehashDropsets(mergingHash, bestDropset);
   
 #ifdef PRINT_VERY_VERBOSE
-  int i; 
   PR("CLEAN UP: need to recompute bipartitions ");
   FOR_0_LIMIT(i, bipartitionProfile->length)
     if(NTH_BIT_IS_SET(candidateBips, i))
@@ -1820,7 +2613,7 @@ BitVector *cleanup(All *tr, HashTable *mergingHash, Dropset *bestDropset, BitVec
 }
 
 
-void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *treeFile, boolean mreOptimisation, int rawThresh)
+void doomRogues(All *tr, TreeReader *bootstrapTreesFile, ProfileCache *profileCache, char *profileCacheFile, char *dontDropFile, char *treeFile, boolean mreOptimisation, int rawThresh)
 {
   double startingTime = gettime();
   timeInc = gettime();
@@ -1830,7 +2623,6 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
     i;  
 
   FILE
-    *bootstrapTreesFile = getNumberOfTrees(tr, bootStrapFileName),
     *rogueOutput = getOutputFileFromString("droppedRogues");
 
   BitVector
@@ -1839,8 +2631,6 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
   HashTable
     *mergingHash = NULL;  
 
-  numberOfTrees = tr->numberOfTrees;
-
   if(strlen(treeFile))
     {
       rogueMode = ML_TREE_OPT;
@@ -1849,32 +2639,76 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
 	  PR("ERROR: Please choose either support in the MRE consensus tree OR the bipartitions in the ML tree for optimization.\n");
 	  exit(-1);
 	}
-      PR("mode: optimization of support of ML tree bipartitions in the bootstrap tree set.\n");
     }
   else if(mreOptimisation)
+    rogueMode = MRE_CONSENSUS_OPT;
+  else 
+    rogueMode = VANILLA_CONSENSUS_OPT;
+
+  TreeReader
+    *bestTree = (rogueMode == ML_TREE_OPT) ? openTreeReader(treeFile) : NULL;
+
+  mxtips = tr->mxtips;
+  tr->bitVectorLength = GET_BITVECTOR_LENGTH(mxtips);
+
+  TreeChunk 
+    *treeChunks = NULL; 
+  int 
+    numberOfChunks = 0; 
+
+  Array
+    *bipartitionProfile = NULL; 
+
+#ifdef PARALLEL
+  globalPArgs = CALLOC(1,sizeof(parallelArguments));   
+  startThreads();
+
+  if( NOT profileCache)
+    treeChunks = splitIntoTreeChunks(tr, bootstrapTreesFile, numberOfThreads);
+  if(treeChunks)
     {
-      rogueMode = MRE_CONSENSUS_OPT;
-      thresh = tr->numberOfTrees  * 0.5;
-      PR("mode: optimization on MRE consensus tree. \n");
+      numberOfChunks = numberOfThreads; 
+      globalPArgs->treeChunks = treeChunks; 
+      masterBarrier(THREAD_PARSE_TREES, globalPArgs);
     }
-  else 
+#endif
+
+  /* this also determines the number of trees */
+  if(profileCache)
+    bipartitionProfile = getBipArrayFromProfileCache(tr, profileCache, bestTree);
+  else
+    bipartitionProfile = getOriginalBipArray(tr, bestTree, bootstrapTreesFile, treeChunks, numberOfChunks);
+
+  if(treeChunks)
+    freeTreeChunks(treeChunks, numberOfChunks);
+
+  if(strlen(profileCacheFile))
+    writeProfileCache(profileCacheFile, tr, bipartitionProfile);
+
+  if(bestTree)
+    closeTreeReader(bestTree);
+
+  numberOfTrees = tr->numberOfTrees;
+
+  switch(rogueMode)
     {
-      rogueMode = VANILLA_CONSENSUS_OPT;
+    case ML_TREE_OPT:
+      PR("mode: optimization of support of ML tree bipartitions in the bootstrap tree set.\n");
+      break; 
+    case MRE_CONSENSUS_OPT:
+      thresh = tr->numberOfTrees  * 0.5;
+      PR("mode: optimization on MRE consensus tree. \n");
+      break; 
+    case VANILLA_CONSENSUS_OPT:
       thresh = tr->numberOfTrees * rawThresh / 100; 
       if(thresh == tr->numberOfTrees)
 	thresh--; 
       PR("mode: optimization on consensus tree. Bipartition is part of consensus, if it occurs in more than %d trees\n", thresh); 
+      break; 
+    default: 
+      assert(0);
     }
 
-  FILE
-    *bestTree = (rogueMode == ML_TREE_OPT) ? myfopen(treeFile,"r") : NULL;
-
-  mxtips = tr->mxtips;
-  tr->bitVectorLength = GET_BITVECTOR_LENGTH(mxtips);
-
-  Array 
-    *bipartitionProfile = getOriginalBipArray(tr, bestTree, bootstrapTreesFile);
-
   if(maxDropsetSize >= mxtips - 3)
     {
       PR("\nMaximum dropset size (%d) too large. If we prune %d taxa, then there \n\
@@ -1895,6 +2729,7 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
   treeVectorLength = GET_BITVECTOR_LENGTH(tr->numberOfTrees);
   bitVectorLength = GET_BITVECTOR_LENGTH(tr->mxtips);
   droppedTaxa = CALLOC(bitVectorLength, sizeof(BitVector));
+  touchedTaxa = CALLOC(bitVectorLength, sizeof(BitVector));
 
   paddingBits = CALLOC(GET_BITVECTOR_LENGTH(mxtips), sizeof(BitVector));
   for(i = mxtips; i < GET_BITVECTOR_LENGTH(mxtips) * MASK_LENGTH; ++i)
@@ -1936,11 +2771,20 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
 				dropsetHashValue, 
 				dropsetEqual); 
 
-   
-
 #ifdef PARALLEL
-  globalPArgs = CALLOC(1,sizeof(parallelArguments));   
-  startThreads();
+  numberOfRoundArenas = numberOfThreads; 
+#else
+  numberOfRoundArenas = 1; 
+#endif
+  roundArenas = CALLOC(numberOfRoundArenas, sizeof(Arena*));
+  scratchArenas = CALLOC(numberOfRoundArenas, sizeof(Arena*));
+  FOR_0_LIMIT(i,numberOfRoundArenas)
+    {
+      roundArenas[i] = createArena(ARENA_SLAB_SIZE);
+      scratchArenas[i] = createArena(ARENA_SLAB_SIZE);
+    }
+#ifdef PARALLEL
+  eventLogs = createEventLogs(numberOfThreads);
 #endif
 
   /* main loop */
@@ -1957,8 +2801,14 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
       /* prepare */
       /***********/
       bestDropset = NULL;
+      /* complex events of the last round are gone */
+      FOR_0_LIMIT(i,numberOfRoundArenas)
+	resetArena(roundArenas[i]);
       unifyBipartitionRepresentation(bipartitionProfile,droppedTaxa); 
       indexByNumberBits = createNumBitIndex(bipartitionProfile, mxtips);
+      if(NOT hammingIndex)
+	hammingIndex = createHammingIndex(bipartitionsById, mxtips, maxDropsetSize);
+      setHammingIndexPositions(hammingIndex, bipartitionProfile);
 
 #ifdef PRINT_TIME
       PR("[%f] sorting bipartition profile\n", updateTime(&timeInc));
@@ -1972,7 +2822,7 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
       /* create / update  merging events */
       /***********************************/
 #ifdef PARALLEL
-      numberOfJobs = bipartitionProfile->length;
+      distributeJobs(bipartitionProfile->length);
       globalPArgs->mergingHash = mergingHash; 
       globalPArgs->candidateBips = candidateBips; 
       globalPArgs->bipartitionsById = bipartitionsById; 
@@ -1980,6 +2830,9 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
       globalPArgs->indexByNumberBits = indexByNumberBits; 
       globalPArgs->firstMerge = firstMerge; 
       masterBarrier(THREAD_GET_EVENTS, globalPArgs);
+      orderLogSegments(eventLogs);
+      masterBarrier(THREAD_INSERT_EVENTS, globalPArgs);
+      clearEventLogs(eventLogs);
       free(candidateBips);      
 #else 
       createOrUpdateMergingHash(tr, mergingHash, bipartitionProfile, bipartitionsById, candidateBips, firstMerge, indexByNumberBits );
@@ -2045,7 +2898,7 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
 	      if( NOT elemB)
 		continue;
 
-	      if(elemA->numberOfBitsSet == elemB->numberOfBitsSet && myBitVectorEqual(elemA,elemB))
+	      if(elemA->numberOfBitsSet == elemB->numberOfBitsSet && bitVectorEqual(elemA,elemB))
 		{
 		  PR("%d and %d are equal!\n", elemA->id, elemB->id);
 		  printBitVector(elemA->bitVector, bitVectorLength);
@@ -2065,7 +2918,7 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
       PR("\n");
 #endif
       if(bestDropset)
-	taxaDropped += lengthIndexList(bestDropset->taxaToDrop);      
+	taxaDropped += bestDropset->numberOfTaxa;      
 
       dropRound++;      
     } while(bestDropset);
@@ -2074,25 +2927,34 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
   printRogueInformationToFile(tr, rogueOutput, bestCumEver,cumScores, dropsetPerRound);
 
   PR("total time elapsed: %f\n", updateTime(&startingTime));
+#if defined(PARALLEL) && defined(PRINT_TIME)
+  printSchedulerStatistics();
+#endif
 
   /* free everything */   
-  FOR_0_LIMIT(i, bipartitionProfile->length)
+  freeHammingIndex(hammingIndex);
+  hammingIndex = NULL; 
+  freeProfile(bipartitionProfile);
+  freeArray(bipartitionsById);
+  destroyHashTable(mergingHash, freeDropsetDeep);
+  FOR_0_LIMIT(i,numberOfRoundArenas)
     {
-      ProfileElem *elem = GET_PROFILE_ELEM(bipartitionProfile,i);
-      if(elem)
-  	freeProfileElem(elem);
+      freeArena(roundArenas[i]);
+      freeArena(scratchArenas[i]);
     }
-  free(((ProfileElemAttr*)bipartitionProfile->commonAttributes));
-  freeArray(bipartitionProfile);
-  freeArray(bipartitionsById);
-  destroyHashTable(mergingHash, freeDropsetDeepInHash);
+  free(roundArenas);
+  free(scratchArenas);
+#ifdef PARALLEL
+  freeEventLogs(eventLogs);
+  eventLogs = NULL; 
+#endif
 
   fclose(rogueOutput);
   for(i= 0 ; i < dropRound + 1; ++i)
     {
       Dropset *theDropset = dropsetPerRound[i];
       if(theDropset)
-	freeDropsetDeepInEnd(theDropset);
+	freeDropsetDeep(theDropset);
     }
   free(dropsetPerRound);
   free(neglectThose);
@@ -2100,7 +2962,11 @@ void doomRogues(All *tr, char *bootStrapFileName, char *dontDropFile, char *tree
   free(paddingBits);
   free(randForTaxa);
   free(droppedTaxa);
+  free(touchedTaxa);
   free(candidateBips);
+#ifdef PARALLEL
+  stopThreads();
+#endif
 }
 
 
@@ -2109,7 +2975,7 @@ void printHelpFile()
   printVersionInfo(FALSE);
   printf("This program implements the RogueNaRok algorithm for rogue taxon identification.\n\nSYNTAX: ./%s -i <bootTrees> -n <runId> [-x <excludeFile>] [-c <threshold>] [-b] [-s <dropsetSize>] [-w <workingDir>] [-h]\n", programName);
   printf("\n\tOBLIGATORY:\n");
-  printf("-i <bootTrees>\n\tA collection of bootstrap trees.\n");
+  printf("-i <bootTrees>\n\tA collection of bootstrap trees. The trees are read only once, thus also a pipe \n\t(e.g., /dev/stdin) can be specified.\n\tAlternatively, a bipartition profile created with -P.\n");
   printf("-n <runId>\n\tAn identifier for this run.\n");
   printf("\n\tOPTIONAL:\n");
   printf("-t <bestKnownTree>\n\tIf a single best-known tree (such as an ML or MP\n\t\
@@ -2133,8 +2999,13 @@ conservative the algorithm is in pruning taxa. DEFAULT: 0.0 (=RBIC)\n");
 dropsetSize == n, then RogueNaRok will test in each iteration which\n\t\
 tuple of n taxa increases optimality criterion the most and prunes\n\t\
 taxa accordingly. This improves the result, but runtimes will\n\t\
-increase at least linearly. DEFAULT: 1\n");
+increase at least linearly. Valid values are 1 <= n <= %d.\n\t\
+DEFAULT: 1\n", MAX_DROPSET_SIZE);
   printf("-w <workDir>\n\tA working directory where output files are created.\n");
+  printf("-P <profileFile>\n\tStores the bipartition profile of the bootstrap trees in a\n\t\
+binary file. Passing this file via -i in further runs avoids reading\n\t\
+the trees again. The file can only be used on the machine that\n\t\
+created it.\n");
   printf("-T <num>\n\tExecute RogueNaRok in parallel with <num> threads. You need to compile the program for parallel execution first.\n");
   printf("-h\n\tThis help file.\n");
   printf("\nMINIMAL EXAMPLE:\n./%s -i <bootstrapTreeFile> -n run1\n", programName);
@@ -2151,6 +3022,7 @@ int main(int argc, char *argv[])
   char
     *excludeFile = "", 
     *bootTrees = "",
+    *profileCacheFile = "",
     *treeFile = ""; 
 
   boolean
@@ -2167,7 +3039,7 @@ int main(int argc, char *argv[])
   programVersion = PROG_VERSION;
   programReleaseDate  = PROG_RELEASE_DATE;
   
-  while ((c = getopt (argc, argv, "i:t:n:x:w:hc:s:bT:L:")) != -1)
+  while ((c = getopt (argc, argv, "i:t:n:x:w:hc:s:bT:L:P:")) != -1)
     switch (c)
       {
       case 'i':
@@ -2201,6 +3073,9 @@ int main(int argc, char *argv[])
       case 'w':
 	strcpy(workdir, optarg) ; 
 	break;
+      case 'P':
+	profileCacheFile = optarg; 
+	break;
       case 'L':
 	labelPenalty = wrapStrToDouble(optarg); 
 	break; 
@@ -2224,8 +3099,8 @@ int main(int argc, char *argv[])
       }
   
   /* initialize fast bit counting */
-  compute_bits_in_16bits();
   initializeMask();
+  initializeBitVectorKernels();
 
 #ifdef PARALLEL
   if(NOT numberOfThreads)
@@ -2270,22 +3145,51 @@ Please compile a sequential version of RogueNaRok instead.\n\n");
       exit(-1);
     }
 
+  if(maxDropsetSize < 1 || maxDropsetSize > MAX_DROPSET_SIZE)
+    {
+      printf("ERROR: Only accepting dropset sizes between 1 and %d.\n", MAX_DROPSET_SIZE);
+      exit(-1);
+    }
+
   All 
     *tr = CALLOC(1,sizeof(All));  
   setupInfoFile();
-  if  (NOT setupTree(tr, bootTrees))
+
+  TreeReader
+    *bootstrapTreesFile = NULL; 
+  ProfileCache 
+    *profileCache = NULL; 
+
+  if(isProfileCache(bootTrees))
     {
-      PR("Something went wrong during tree initialisation. Sorry.\n");
-      exit(-1);
-    }   
+      profileCache = openProfileCache(bootTrees);
+      setupTreeFromProfileCache(tr, profileCache);
+    }
+  else 
+    {
+      /* the trees are read only once, thus they can also be streamed through a pipe */
+      bootstrapTreesFile = openTreeStream(bootTrees);
+
+      if  (NOT setupTreeFromReader(tr, bootstrapTreesFile))
+	{
+	  PR("Something went wrong during tree initialisation. Sorry.\n");
+	  exit(-1);
+	}   
+    }
 
   doomRogues(tr,
-  	     bootTrees,
+  	     bootstrapTreesFile,
+	     profileCache,
+	     profileCacheFile,
   	     excludeFile,
   	     treeFile,
   	     mreOptimisation,
 	     threshold);
 
+  if(bootstrapTreesFile)
+    closeTreeReader(bootstrapTreesFile);
+  if(profileCache)
+    closeProfileCache(profileCache);
   freeTree(tr);
   free(mask32);
   free(infoFileName);
@@ -0,0 +1,242 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifdef PARALLEL
+#include <stdint.h>
+#include "common.h"
+#include "parallel.h"
+#include "Scheduler.h"
+
+#define PACK_RANGE(begin,end) (((uint64_t)(uint32_t)(end) << 32) | (uint32_t)(begin))
+#define RANGE_BEGIN(range) ((int)((range) & 0xFFFFFFFF))
+#define RANGE_END(range) ((int)((range) >> 32))
+
+#define NUMBER_OF_JOB_TYPES THREAD_EXIT
+
+#define CACHE_LINE_SIZE 64
+
+/* one cache line per thread: the array is allocated aligned to a
+   cache line and the alignment of the struct rounds its size up */
+typedef struct
+{
+  uint64_t range; 		/* only accessed atomically */
+  double busyTime; 
+  int chunksStolen; 
+} __attribute__((aligned(CACHE_LINE_SIZE))) ThreadSchedule; 
+
+typedef struct
+{
+  int numberOfPhases; 
+  double sumOfMaxima; 		/* busy time of the slowest thread */
+  double sumOfMeans; 
+  int chunksStolen; 
+} PhaseStatistics; 
+
+static ThreadSchedule *schedules = NULL; 
+static PhaseStatistics statistics[NUMBER_OF_JOB_TYPES]; 
+static int numberOfSchedules = 0; 
+
+static char *jobNames[NUMBER_OF_JOB_TYPES] = 
+  {
+    "", 
+    "computing events", 
+    "combining events", 
+    "MRE evaluation", 
+    "evaluating dropsets", 
+    "parsing trees", 
+    "inserting events", 
+    "unifying splits", 
+    "updating splits", 
+    "cleaning up events", 
+    "preparing the selection", 
+    "rehashing dropsets"
+  };
+
+
+void initializeScheduler(int numberOfThreads)
+{
+  if(posix_memalign((void**)&schedules, CACHE_LINE_SIZE, numberOfThreads * sizeof(ThreadSchedule)))
+    {
+      printf("ERROR: Unable to obtain sufficient memory\n");
+      exit(-1);
+    }
+  memset(schedules, 0, numberOfThreads * sizeof(ThreadSchedule));
+  numberOfSchedules = numberOfThreads; 
+  memset(statistics, 0, NUMBER_OF_JOB_TYPES * sizeof(PhaseStatistics));
+}
+
+
+/* called by the master before the barrier */
+void distributeJobs(int numberOfJobs)
+{
+  int 
+    t; 
+
+  FOR_0_LIMIT(t,numberOfSchedules)
+    __atomic_store_n(&(schedules[t].range), PACK_RANGE((int64_t)numberOfJobs * t / numberOfSchedules, (int64_t)numberOfJobs * (t + 1) / numberOfSchedules), __ATOMIC_RELEASE);
+}
+
+
+static boolean takeFromFront(ThreadSchedule *schedule, int *begin, int *end)
+{
+  while(TRUE)
+    {
+      uint64_t
+	range = __atomic_load_n(&(schedule->range), __ATOMIC_ACQUIRE); 
+      int 
+	b = RANGE_BEGIN(range),
+	e = RANGE_END(range),
+	chunk; 
+
+      if(b >= e)
+	return FALSE; 
+
+      chunk = MAX(1, (e - b) / SCHEDULER_CHUNK_FRACTION); 
+      if(__sync_bool_compare_and_swap(&(schedule->range), range, PACK_RANGE(b + chunk, e)))
+	{
+	  *begin = b; 
+	  *end = b + chunk; 
+	  return TRUE; 
+	}
+    }
+}
+
+
+static boolean stealFromBack(ThreadSchedule *victim, int *begin, int *end)
+{
+  while(TRUE)
+    {
+      uint64_t
+	range = __atomic_load_n(&(victim->range), __ATOMIC_ACQUIRE); 
+      int 
+	b = RANGE_BEGIN(range),
+	e = RANGE_END(range),
+	newEnd; 
+
+      if(b >= e)
+	return FALSE; 
+
+      newEnd = e - MAX(1, (e - b) / 2); 
+      if(__sync_bool_compare_and_swap(&(victim->range), range, PACK_RANGE(b, newEnd)))
+	{
+	  *begin = newEnd; 
+	  *end = e; 
+	  return TRUE; 
+	}
+    }
+}
+
+
+/* 
+   the next jobs [begin,end) of this thread. FALSE, if there are no
+   jobs left.
+*/
+boolean getJobRange(int tid, int *begin, int *end)
+{
+  ThreadSchedule
+    *own = schedules + tid; 
+  int 
+    i; 
+
+  if(takeFromFront(own, begin, end))
+    return TRUE; 
+
+  for(i = 1; i < numberOfSchedules; ++i)
+    {
+      int 
+	stolenBegin, 
+	stolenEnd; 
+
+      if(stealFromBack(schedules + (tid + i) % numberOfSchedules, &stolenBegin, &stolenEnd))
+	{
+	  /* nobody steals from an empty range, thus no compare-and-swap is needed */
+	  __atomic_store_n(&(own->range), PACK_RANGE(stolenBegin, stolenEnd), __ATOMIC_RELEASE);
+	  own->chunksStolen++; 
+	  return takeFromFront(own, begin, end); 
+	}
+    }
+
+  return FALSE; 
+}
+
+
+void recordBusyTime(int tid, double time)
+{
+  schedules[tid].busyTime = time; 
+}
+
+
+/* called by the master after the barrier */
+void finishPhase(int jobType)
+{
+  int 
+    t; 
+  double 
+    max = 0, 
+    sum = 0; 
+  PhaseStatistics 
+    *stat = statistics + jobType; 
+
+  FOR_0_LIMIT(t,numberOfSchedules)
+    {
+      max = MAX(max, schedules[t].busyTime); 
+      sum += schedules[t].busyTime; 
+      stat->chunksStolen += schedules[t].chunksStolen; 
+      schedules[t].busyTime = 0; 
+      schedules[t].chunksStolen = 0; 
+    }
+
+  stat->numberOfPhases++; 
+  stat->sumOfMaxima += max; 
+  stat->sumOfMeans += sum / numberOfSchedules; 
+}
+
+
+void printSchedulerStatistics(void)
+{
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,NUMBER_OF_JOB_TYPES)
+    if(statistics[i].numberOfPhases && statistics[i].sumOfMeans > 0)
+      PR("%s: %f seconds in %d phases, load imbalance %.3f (max/mean busy time), %d ranges stolen\n", 
+	 jobNames[i], statistics[i].sumOfMaxima, statistics[i].numberOfPhases, 
+	 statistics[i].sumOfMaxima / statistics[i].sumOfMeans, statistics[i].chunksStolen);
+}
+
+
+void freeScheduler(void)
+{
+  free(schedules);
+  schedules = NULL; 
+  numberOfSchedules = 0; 
+}
+#endif
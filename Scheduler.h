@@ -0,0 +1,60 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "common.h"
+
+/* 
+   Chunked work stealing for the jobs of a parallel phase. The jobs
+   0..n-1 are split into one contiguous range per thread. A thread
+   takes chunks from the front of its own range; the chunks shrink with
+   the work left in the range. If its own range is empty, the thread
+   steals the back half of the range of another thread. A range is a
+   single 64-bit word (begin and end), thus both ends are modified
+   with compare-and-swap.
+
+   The busy time of each thread is recorded per phase, such that the
+   load imbalance of each job type can be reported.
+*/
+
+#define SCHEDULER_CHUNK_FRACTION 8
+
+void initializeScheduler(int numberOfThreads);
+void distributeJobs(int numberOfJobs);
+boolean getJobRange(int tid, int *begin, int *end);
+void recordBusyTime(int tid, double time);
+void finishPhase(int jobType);
+void printSchedulerStatistics(void);
+void freeScheduler(void);
+
+#endif
@@ -0,0 +1,331 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include "SplitHash.h"
+
+#define SPLIT_HASH_MAX_LOAD 0.5
+
+
+static unsigned int getSplitTableSize(unsigned int expectedSplits)
+{
+  unsigned int 
+    result = 64; 
+
+  while(result * SPLIT_HASH_MAX_LOAD < expectedSplits)
+    result *= 2; 
+
+  return result; 
+}
+
+
+SplitHash *createSplitHash(int bitVectorLength, int treeVectorLength, unsigned int expectedSplits)
+{
+  SplitHash 
+    *result = CALLOC(1, sizeof(SplitHash));
+  unsigned int 
+    i; 
+
+  result->tableSize = getSplitTableSize(expectedSplits);
+  result->slots = CALLOC(result->tableSize, sizeof(SplitSlot));
+  FOR_0_LIMIT(i,result->tableSize)
+    result->slots[i].index = -1; 
+
+  result->capacity = 1024; 
+  result->splits = CALLOC(result->capacity, sizeof(ProfileElem*));
+  result->fingerprints = CALLOC(result->capacity, sizeof(uint64_t));
+
+  result->bitVectorLength = bitVectorLength; 
+  result->treeVectorLength = treeVectorLength; 
+  result->arena = createArena(ARENA_SLAB_SIZE);
+  result->treeVectorArena = createArena(ARENA_SLAB_SIZE);
+
+  return result; 
+}
+
+
+void freeSplitHash(SplitHash *h)
+{
+  free(h->slots);
+  free(h->splits);
+  free(h->fingerprints);
+  freeArena(h->arena);
+  freeArena(h->treeVectorArena);
+  free(h);
+}
+
+
+static void rehashSplits(SplitHash *h)
+{
+  SplitSlot 
+    *oldSlots = h->slots; 
+  unsigned int 
+    i,
+    oldSize = h->tableSize; 
+
+  h->tableSize *= 2; 
+  h->slots = CALLOC(h->tableSize, sizeof(SplitSlot));
+  FOR_0_LIMIT(i,h->tableSize)
+    h->slots[i].index = -1; 
+
+  FOR_0_LIMIT(i,oldSize)
+    if(oldSlots[i].index != -1)
+      {
+	unsigned int 
+	  position = oldSlots[i].fingerprint & (h->tableSize - 1);
+
+	while(h->slots[position].index != -1)
+	  position = (position + 1) & (h->tableSize - 1);
+
+	h->slots[position] = oldSlots[i];
+      }
+
+  free(oldSlots);
+}
+
+
+/* returns the slot of the split or the empty slot where it belongs */
+static unsigned int probeSplit(SplitHash *h, BitVector *bitVector, uint64_t fingerprint)
+{
+  unsigned int 
+    position = fingerprint & (h->tableSize - 1);
+
+  while(h->slots[position].index != -1)
+    {
+      if(h->slots[position].fingerprint == fingerprint
+	 && areSameBitVectors(h->splits[h->slots[position].index]->bitVector, bitVector, h->bitVectorLength))
+	return position; 
+
+      position = (position + 1) & (h->tableSize - 1);
+    }
+
+  return position; 
+}
+
+
+/* the index of the split (in order of first occurrence) or -1 */
+int findSplit(SplitHash *h, BitVector *bitVector, uint64_t fingerprint)
+{
+  return h->slots[probeSplit(h, bitVector, fingerprint)].index; 
+}
+
+
+static ProfileElem *findOrInsertSplit(SplitHash *h, BitVector *bitVector, uint64_t fingerprint)
+{
+  unsigned int 
+    position = probeSplit(h, bitVector, fingerprint);
+  ProfileElem
+    *elem; 
+
+  if(h->slots[position].index != -1)
+    return h->splits[h->slots[position].index];
+
+  if(h->numberOfSplits == h->capacity)
+    {
+      h->capacity *= 2; 
+      h->splits = realloc(h->splits, h->capacity * sizeof(ProfileElem*));
+      h->fingerprints = realloc(h->fingerprints, h->capacity * sizeof(uint64_t));
+      assert(h->splits && h->fingerprints);
+    }
+
+  elem = arenaAlloc(h->arena, sizeof(ProfileElem));
+  elem->bitVector = arenaAlloc(h->arena, h->bitVectorLength * sizeof(BitVector));
+  memcpy(elem->bitVector, bitVector, h->bitVectorLength * sizeof(BitVector));
+  elem->treeVector = arenaAlloc(h->treeVectorArena, h->treeVectorLength * sizeof(BitVector));
+
+  h->slots[position].fingerprint = fingerprint; 
+  h->slots[position].index = h->numberOfSplits; 
+  h->splits[h->numberOfSplits] = elem;
+  h->fingerprints[h->numberOfSplits] = fingerprint; 
+  h->numberOfSplits++;
+
+  if(h->numberOfSplits > h->tableSize * SPLIT_HASH_MAX_LOAD)
+    rehashSplits(h);
+
+  return elem; 
+}
+
+
+void addSplitOfTree(SplitHash *h, BitVector *bitVector, uint64_t fingerprint, int treeNumber)
+{
+  ProfileElem 
+    *elem = findOrInsertSplit(h, bitVector, fingerprint);
+
+  assert(treeNumber < h->treeVectorLength * MASK_LENGTH);
+  FLIP_NTH_BIT(elem->treeVector, treeNumber);
+}
+
+
+/* moves all tree vectors into a new arena with longer vectors */
+void growSplitTreeVectors(SplitHash *h, int treeVectorLength)
+{
+  Arena
+    *oldArena = h->treeVectorArena; 
+  int 
+    i; 
+
+  assert(treeVectorLength >= h->treeVectorLength);
+
+  h->treeVectorArena = createArena(ARENA_SLAB_SIZE);
+  FOR_0_LIMIT(i,h->numberOfSplits)
+    {
+      BitVector
+	*treeVector = arenaAlloc(h->treeVectorArena, treeVectorLength * sizeof(BitVector));
+      memcpy(treeVector, h->splits[i]->treeVector, h->treeVectorLength * sizeof(BitVector));
+      h->splits[i]->treeVector = treeVector; 
+    }
+  
+  h->treeVectorLength = treeVectorLength; 
+  freeArena(oldArena);
+}
+
+
+/* 
+   adds the splits of source (in the order of their first occurrence)
+   as if its trees had been added to h with numbers increased by
+   treeOffset
+*/
+void mergeSplitHash(SplitHash *h, SplitHash *source, int treeOffset)
+{
+  int 
+    i; 
+
+  assert(h->bitVectorLength == source->bitVectorLength);
+
+  FOR_0_LIMIT(i,source->numberOfSplits)
+    {
+      ProfileElem
+	*elem = findOrInsertSplit(h, source->splits[i]->bitVector, source->fingerprints[i]);
+
+      orShiftedBitVector(elem->treeVector, h->treeVectorLength, source->splits[i]->treeVector, source->treeVectorLength, treeOffset);
+    }
+}
+
+
+typedef struct
+{
+  unsigned int position; 
+  int index; 
+  ProfileElem *elem; 
+} PositionKey; 
+
+
+static int sortByPosition(const void *a, const void *b)
+{
+  const PositionKey
+    *ka = a, 
+    *kb = b; 
+
+  if(ka->position != kb->position)
+    return ka->position < kb->position ? -1 : 1; 
+  
+  return kb->index - ka->index; 
+}
+
+
+/* 
+   Orders elements (given in the order of their insertion) like a
+   traversal of a chained hash table in which each element is
+   prepended to the chain at positions[i]. This is the order in which
+   bipartition profiles always have been created, ties in the
+   algorithm are broken by it.
+*/
+void sortLikeChainedTable(ProfileElem **elems, unsigned int *positions, int numberOfElems)
+{
+  PositionKey
+    *keys = CALLOC(numberOfElems, sizeof(PositionKey));
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,numberOfElems)
+    {
+      keys[i].position = positions[i];
+      keys[i].index = i; 
+      keys[i].elem = elems[i];
+    }
+
+  qsort(keys, numberOfElems, sizeof(PositionKey), sortByPosition);
+
+  FOR_0_LIMIT(i,numberOfElems)
+    elems[i] = keys[i].elem; 
+
+  free(keys);
+}
+
+
+/* 
+   turns the splits into the bipartition profile, h is consumed. The
+   tree vector of each split may hold the best tree as tree number
+   numberOfTrees.
+*/
+Array *splitHashToProfile(SplitHash *h, int numberOfTrees, unsigned int chainedTableSize)
+{
+  Array 
+    *result = CALLOC(1, sizeof(Array));
+  ProfileElemAttr
+    *attr = CALLOC(1, sizeof(ProfileElemAttr));
+  unsigned int 
+    *positions = CALLOC(h->numberOfSplits, sizeof(unsigned int));
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,h->numberOfSplits)
+    {
+      ProfileElem
+	*elem = h->splits[i];
+
+      if(NTH_BIT_IS_SET(elem->treeVector, numberOfTrees))
+	{
+	  elem->isInMLTree = TRUE;
+	  UNFLIP_NTH_BIT(elem->treeVector, numberOfTrees);
+	}
+      elem->treeVectorSupport = genericBitCount(elem->treeVector, h->treeVectorLength);
+      
+      positions[i] = h->fingerprints[i] % chainedTableSize; 
+    }
+
+  sortLikeChainedTable(h->splits, positions, h->numberOfSplits);
+
+  attr->bitVectorLength = h->bitVectorLength; 
+  attr->treeVectorLength = GET_BITVECTOR_LENGTH(numberOfTrees + 1);
+  attr->arena = h->arena; 
+  attr->treeVectorArena = h->treeVectorArena; 
+
+  result->commonAttributes = attr; 
+  result->arrayTable = h->splits; 
+  result->length = h->numberOfSplits; 
+
+  free(positions);
+  free(h->slots);
+  free(h->fingerprints);
+  free(h);
+
+  return result; 
+}
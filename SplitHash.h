@@ -0,0 +1,84 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef SPLIT_HASH_H
+#define SPLIT_HASH_H
+
+#include <stdint.h>
+
+#include "common.h"
+#include "Array.h"
+#include "Arena.h"
+#include "BitVector.h"
+#include "ProfileElem.h"
+
+/* 
+   Collects the bipartitions (splits) of a tree set. The table uses
+   open addressing with linear probing and stores a 64-bit fingerprint
+   (the XOR of the hash values of the tips in the split) for each
+   split, such that bit vectors only are compared if the fingerprints
+   match.
+
+   The splits are profile elements (kept in the order of first
+   occurrence) whose vectors live in arenas; they become the
+   bipartition profile without copying.
+*/
+
+typedef struct
+{
+  uint64_t fingerprint; 
+  int index;			/* -1, if the slot is empty */
+} SplitSlot; 
+
+typedef struct
+{
+  SplitSlot *slots; 
+  unsigned int tableSize;	/* a power of two */
+  int numberOfSplits; 
+  int capacity; 
+  ProfileElem **splits; 
+  uint64_t *fingerprints; 
+  int bitVectorLength; 
+  int treeVectorLength; 
+  Arena *arena;			/* elements and bit vectors */
+  Arena *treeVectorArena; 
+} SplitHash; 
+
+SplitHash *createSplitHash(int bitVectorLength, int treeVectorLength, unsigned int expectedSplits);
+void freeSplitHash(SplitHash *h);
+int findSplit(SplitHash *h, BitVector *bitVector, uint64_t fingerprint);
+void addSplitOfTree(SplitHash *h, BitVector *bitVector, uint64_t fingerprint, int treeNumber);
+void growSplitTreeVectors(SplitHash *h, int treeVectorLength);
+void mergeSplitHash(SplitHash *h, SplitHash *source, int treeOffset);
+void sortLikeChainedTable(ProfileElem **elems, unsigned int *positions, int numberOfElems);
+Array *splitHashToProfile(SplitHash *h, int numberOfTrees, unsigned int chainedTableSize);
+
+#endif
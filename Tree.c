@@ -31,15 +31,12 @@
 
 #include "Tree.h"
 
-static int treeGetCh (FILE *fp) ;
-static void insertHashBootstop(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber, int treeVectorLength, unsigned int position);
-static void  treeEchoContext (FILE *fp1, FILE *fp2, int n);
-static double getBranchLength(All *tr, int perGene, nodeptr p);
+static int treeGetCh (TreeReader *reader) ;
+static void insertHashBootstop(BitVector *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber, int treeVectorLength, unsigned int position);
+static void  treeEchoContext (TreeReader *reader, FILE *fp2, int n);
 boolean isTip(int number, int maxTips);
 void getxnode (nodeptr p);
-static void insertHashAll(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber,  unsigned int position);
-static void insertHash(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, int bipNumber, unsigned int position);
-static int countHash(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, unsigned int position);
+static void insertHashAll(BitVector *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber,  unsigned int position);
 
 
 static unsigned int KISS32(void)
@@ -97,11 +94,12 @@ stringHashtable *initStringHashTable(unsigned int n)
 }
 
 
-static unsigned int  hashString(char *p, unsigned int tableSize)
+static unsigned int  hashString(char *p, int length, unsigned int tableSize)
 {
   unsigned int h = 0;
+  char *end = p + length; 
   
-  for(; *p; p++)
+  for(; p < end; p++)
     h = 31 * h + *p;
   
   return (h % tableSize);
@@ -110,7 +108,7 @@ static unsigned int  hashString(char *p, unsigned int tableSize)
 
 void addword(char *s, stringHashtable *h, int nodeNumber)
 {
-  unsigned int position = hashString(s, h->tableSize);
+  unsigned int position = hashString(s, strlen(s), h->tableSize);
   stringEntry *p = h->table[position];
   
   for(; p!= NULL; p = p->next)
@@ -135,101 +133,137 @@ void addword(char *s, stringHashtable *h, int nodeNumber)
 }
 
 
-int getNumberOfTaxa(All *tr, char *bootStrapFile)
+/* scans the first tree without consuming it */
+/* tr takes over the names, the first name belongs to taxon 1 */
+static void setTaxonNames(All *tr, char **nameList, int taxaCount)
 {
-  FILE *f = myfopen(bootStrapFile, "rb");
+  int 
+    i; 
+
+  tr->nameList = (char **)malloc(sizeof(char *) * (taxaCount + 1));  
+  for(i = 1; i <= taxaCount; i++)
+    tr->nameList[i] = nameList[i - 1];
+
+  tr->nameHash = initStringHashTable(10 * taxaCount);
+  for(i = 1; i <= taxaCount; i++)
+    addword(tr->nameList[i], tr->nameHash, i);
+}
+
 
+static int getNumberOfTaxa(All *tr, TreeReader *reader)
+{
   char 
+    *bootStrapFile = reader->fileName, 
     **nameList,
-    buffer[nmlngth + 2]; 
+    *treeEnd = readerFindAhead(reader, ';'),
+    *iter = reader->buffer + reader->position,
+    *end = reader->buffer + reader->length;
 
   int
     i = 0,
-    c,
     taxaSize = 1024,
     taxaCount = 0;
+
+  if( NOT treeEnd)
+    {
+      printf("Could not find a complete tree in tree collection %s, exiting ...\n", bootStrapFile);
+      exit(-1);
+    }
    
   nameList = (char**)malloc(sizeof(char*) * taxaSize);  
 
-  while((c = fgetc(f)) != ';')
+  for(; iter < treeEnd; iter++)
     {
-      if(c == '(' || c == ',')
+      if((*iter == '(' || *iter == ',') && iter + 1 < end && iter[1] != '(' && iter[1] != ',')
 	{
-	  c = fgetc(f);
-	  if(c ==  '(' || c == ',')
-	    ungetc(c, f);
-	  else
-	    {	      
-	      i = 0;	      	     
-	      
-	      do
-		{
-		  buffer[i++] = c;
-		  c = fgetc(f);
-		}
-	      while(c != ':' && c != ')' && c != ',');
-	      buffer[i] = '\0';	    
+	  char 
+	    *label = ++iter; 
+	  int 
+	    labelLength; 
 
-	      for(i = 0; i < taxaCount; i++)
+	  while(iter < end && *iter != ':' && *iter != ')' && *iter != ',')
+	    iter++;
+	  labelLength = iter - label;
+
+	  for(i = 0; i < taxaCount; i++)
+	    {
+	      if(strncmp(label, nameList[i], labelLength) == 0 && nameList[i][labelLength] == '\0')
 		{
-		  if(strcmp(buffer, nameList[i]) == 0)
-		    {
-		      printf("A taxon labelled by %s appears twice in the first tree of tree collection %s, exiting ...\n", buffer, bootStrapFile);
-		      exit(-1);
-		    }
-		}	     
-	     
-	      if(taxaCount == taxaSize)
-		{		  
-		  taxaSize *= 2;
-		  nameList = (char **)realloc(nameList, sizeof(char*) * taxaSize);		 
+		  printf("A taxon labelled by %s appears twice in the first tree of tree collection %s, exiting ...\n", nameList[i], bootStrapFile);
+		  exit(-1);
 		}
-	      
-	      nameList[taxaCount] = (char*)malloc(sizeof(char) * (strlen(buffer) + 1));
-	      strcpy(nameList[taxaCount], buffer);
-	     
-	      taxaCount++;
-			    
-	      ungetc(c, f);
+	    }	     
+		     
+	  if(taxaCount == taxaSize)
+	    {		  
+	      taxaSize *= 2;
+	      nameList = (char **)realloc(nameList, sizeof(char*) * taxaSize);		 
 	    }
+		      
+	  nameList[taxaCount] = (char*)malloc(sizeof(char) * (labelLength + 1));
+	  memcpy(nameList[taxaCount], label, labelLength);
+	  nameList[taxaCount][labelLength] = '\0';
+		     
+	  taxaCount++;
+
+	  iter--;
 	}   
     }
   
   printf("Found a total of %d taxa in first tree of tree collection %s\n", taxaCount, bootStrapFile);
   printf("Expecting all remaining trees in collection to have the same taxon set\n\n");
 
-  tr->nameList = (char **)malloc(sizeof(char *) * (taxaCount + 1));  
-  for(i = 1; i <= taxaCount; i++)
-    tr->nameList[i] = nameList[i - 1];
-  
+  setTaxonNames(tr, nameList, taxaCount);
   free(nameList);
 
-  tr->nameHash = initStringHashTable(10 * taxaCount);
-  for(i = 1; i <= taxaCount; i++)
-    addword(tr->nameList[i], tr->nameHash, i);
-
-  fclose(f);
-
   return taxaCount;
 }
 
 
 boolean setupTree (All *tr, char *bootstrapFile)
+{
+  TreeReader 
+    *reader = openTreeReader(bootstrapFile);
+  boolean 
+    result = setupTreeFromReader(tr, reader);
+
+  closeTreeReader(reader);
+
+  return result; 
+}
+
+
+/* 
+   allocates the nodes of tr. If reference is given, the tips obtain
+   the same hash values as in the reference tree, otherwise new ones
+   are drawn.
+*/
+/* 
+   the upper half of a tip hash value only is used to tell apart
+   bipartitions in the split hash, thus it may be derived from the
+   taxon number
+*/
+static uint64_t getTipHash(int number)
+{
+  uint64_t 
+    x = (uint64_t)number * 0x9E3779B97F4A7C15ULL; 
+
+  x ^= x >> 31; 
+  x *= 0xBF58476D1CE4E5B9ULL; 
+  x ^= x >> 29; 
+  
+  return (x & 0xFFFFFFFF00000000ULL) | KISS32(); 
+}
+
+
+static boolean allocateNodes(All *tr, All *reference)
 {
   nodeptr  p0, p, q;
   int
     i,
     j,
-    k,
-    tips,
-    inter; 
-
-  tips = getNumberOfTaxa(tr, bootstrapFile);
-  tr->mxtips = tips;
-  
-  tips  = tr->mxtips;
-  inter = tr->mxtips - 1;
-  tr->numberOfTrees = -1;
+    tips = tr->mxtips,
+    inter = tr->mxtips - 1; 
 
   if (NOT(p0 = (nodeptr) malloc((tips + 3*inter) * sizeof(node))))
     {
@@ -249,22 +283,12 @@ boolean setupTree (All *tr, char *bootstrapFile)
     {
       p = p0++;
 
-      p->hash   =  KISS32(); /* hast table stuff */
+      p->hash   =  reference ? reference->nodep[i]->hash : getTipHash(i); /* hast table stuff */
       p->x      =  0;
       p->number =  i;
       p->next   =  p;
       p->back   = (node *)NULL;
-      p->bInf   = (branchInfo *)NULL;
-
-      
-      for(k = 0; k < NUM_BRANCHES; k++)
-	{
-	  p->xs[k]    = 0;
-	  p->backs[k] = (nodeptr)NULL;
-	}
-
-      for(k = 0; k < VECTOR_LENGTH; k++)
-	p->isPresent[k] = 0;
+      p->z      =  defaultz;
 
       tr->nodep[i] = p;
     }
@@ -281,26 +305,9 @@ boolean setupTree (All *tr, char *bootstrapFile)
 	    p->x =  0;
 	  p->number = i;
 	  p->next   = q;
-	  p->bInf   = (branchInfo *)NULL;
 	  p->back   = (node *) NULL;
 	  p->hash   = 0;
-
-	  if(j == 1)
-	    for(k = 0; k < NUM_BRANCHES; k++)
-	      {
-		p->xs[k]    = 1;
-		p->backs[k] = (nodeptr)NULL;
-	      }
-	  else
-	    for(k = 0; k < NUM_BRANCHES; k++)
-	      {
-		p->xs[k]    = 0;
-		p->backs[k] = (nodeptr)NULL;
-	      }
-
-	  for(k = 0; k < VECTOR_LENGTH; k++)
-	    p->isPresent[k] = 0;
-
+	  p->z      = defaultz;
 
 	  q = p;
 	}
@@ -313,43 +320,99 @@ boolean setupTree (All *tr, char *bootstrapFile)
   tr->ntips       = 0;
   tr->nextnode    = 0;
 
-  for(i = 0; i < tr->numBranches; i++)
-    tr->partitionSmoothed[i] = FALSE;
-
   return TRUE;
 }
 
 
+boolean setupTreeFromReader(All *tr, TreeReader *reader)
+{
+  tr->mxtips = getNumberOfTaxa(tr, reader);
+  tr->numberOfTrees = -1;
+
+  return allocateNodes(tr, (All*)NULL);
+}
+
+
+/* 
+   sets up a tree for the given taxa (without reading any tree),
+   tipHashes[i] is the hash value of taxon i + 1
+*/
+boolean setupTreeFromNames(All *tr, char **names, uint64_t *tipHashes, int numberOfTaxa)
+{
+  char 
+    **nameList = (char**)malloc(sizeof(char*) * numberOfTaxa);
+  int 
+    i; 
+
+  FOR_0_LIMIT(i,numberOfTaxa)
+    {
+      nameList[i] = (char*)malloc(sizeof(char) * (strlen(names[i]) + 1));
+      strcpy(nameList[i], names[i]);
+    }
+  
+  tr->mxtips = numberOfTaxa; 
+  tr->numberOfTrees = -1;
+  setTaxonNames(tr, nameList, numberOfTaxa);
+  free(nameList);
+
+  if(NOT allocateNodes(tr, (All*)NULL))
+    return FALSE; 
+
+  for(i = 1; i <= numberOfTaxa; ++i)
+    tr->nodep[i]->hash = tipHashes[i - 1];
+
+  return TRUE; 
+}
+
+
+/* 
+   creates a tree with its own nodes that shares taxon names and tip
+   hash values with tr, such that trees can be read into it
+   independently of tr (e.g., by another thread)
+*/
+All *copyTreeSkeleton(All *tr)
+{
+  All 
+    *result = CALLOC(1, sizeof(All));
+
+  *result = *tr; 
+
+  if(NOT allocateNodes(result, tr))
+    exit(-1);
+
+  return result; 
+}
+
+
+void freeTreeSkeleton(All *tr)
+{
+  free(tr->nodep[1]);
+  free(tr->nodep);
+  free(tr);
+}
+
+
 nodeptr findAnyTip(nodeptr p, int numsp)
 {   
   return  isTip(p->number, numsp) ? p : findAnyTip(p->next->back, numsp);
 } 
 
 
-void hookupAdd(nodeptr p, nodeptr q, int numBranches)
+void hookupAdd(nodeptr p, nodeptr q)
 {
-  int i ; 
-  
   p->back = q; 
   q->back = p; 
 
-  for(i = 0; i < numBranches; ++i)
-    {
-      p->z[i] += q->z[i]; 
-      q->z[i] = p->z[i]; 
-    }
-  
+  p->z += q->z; 
+  q->z = p->z; 
 }
 
-void hookup (nodeptr p, nodeptr q, double *z, int numBranches)
+void hookup (nodeptr p, nodeptr q, double z)
 {
-  int i;
-
   p->back = q;
   q->back = p;
 
-  for(i = 0; i < numBranches; i++)
-    p->z[i] = q->z[i] = z[i];
+  p->z = q->z = z;
 }
 
 
@@ -361,7 +424,7 @@ static void newviewBipartitions(BitVector **bitVectors, nodeptr p, int numsp, un
     nodeptr 
       q = p->next->back, 
       r = p->next->next->back;
-    unsigned int       
+    BitVector       
       *vector = bitVectors[p->number],
       *left  = bitVectors[q->number],
       *right = bitVectors[r->number];
@@ -421,7 +484,7 @@ static void newviewBipartitions(BitVector **bitVectors, nodeptr p, int numsp, un
 
 
 
-void bitVectorInitravSpecial(unsigned int **bitVectors, nodeptr p, int numsp, unsigned int vectorLength, hashtable *h, int treeNumber, int function, branchInfo *bInf, int *countBranches, int treeVectorLength, boolean traverseOnly, boolean computeWRF)
+void bitVectorInitravSpecial(BitVector **bitVectors, nodeptr p, int numsp, unsigned int vectorLength, hashtable *h, int treeNumber, int function, int *countBranches, int treeVectorLength, boolean traverseOnly, boolean computeWRF)
 {
   if(isTip(p->number, numsp))
     return;
@@ -431,7 +494,7 @@ void bitVectorInitravSpecial(unsigned int **bitVectors, nodeptr p, int numsp, un
 
       do 
 	{
-	  bitVectorInitravSpecial(bitVectors, q->back, numsp, vectorLength, h, treeNumber, function, bInf, countBranches, treeVectorLength, traverseOnly, computeWRF);
+	  bitVectorInitravSpecial(bitVectors, q->back, numsp, vectorLength, h, treeNumber, function, countBranches, treeVectorLength, traverseOnly, computeWRF);
 	  q = q->next;
 	}
       while(q != p);
@@ -449,7 +512,7 @@ void bitVectorInitravSpecial(unsigned int **bitVectors, nodeptr p, int numsp, un
 
       if(NOT(isTip(p->back->number, numsp)))
 	{
-	  unsigned int *toInsert  = bitVectors[p->number];
+	  BitVector *toInsert  = bitVectors[p->number];
 	  unsigned int position = p->hash % h->tableSize;
 
 	  switch(function)
@@ -458,25 +521,6 @@ void bitVectorInitravSpecial(unsigned int **bitVectors, nodeptr p, int numsp, un
 	      insertHashAll(toInsert, h, vectorLength, treeNumber, position);
 	      *countBranches =  *countBranches + 1;	
 	      break;
-	    case GET_BIPARTITIONS_BEST:	   	     
-	      insertHash(toInsert, h, vectorLength, *countBranches, position);	     
-	      
-	      p->bInf            = &bInf[*countBranches];
-	      p->back->bInf      = &bInf[*countBranches];        
-	      p->bInf->support   = 0;	  	 
-	      p->bInf->oP = p;
-	      p->bInf->oQ = p->back;
-	      
-	      *countBranches =  *countBranches + 1;		
-	      break;
-	    case DRAW_BIPARTITIONS_BEST:
-	      {
-		int found = countHash(toInsert, h, vectorLength, position);
-		if(found >= 0)
-		  bInf[found].support =  bInf[found].support + 1;
-		*countBranches =  *countBranches + 1;
-	      }	      
-	      break;
 	    case BIPARTITIONS_BOOTSTOP:	      
 	      insertHashBootstop(toInsert, h, vectorLength, treeNumber, treeVectorLength, position);
 	      *countBranches =  *countBranches + 1;
@@ -492,15 +536,44 @@ void bitVectorInitravSpecial(unsigned int **bitVectors, nodeptr p, int numsp, un
 
 
 
-void hookupDefault (nodeptr p, nodeptr q, int numBranches)
+/* 
+   adds the bipartitions of the tree below p to the split hash (the
+   counterpart of bitVectorInitravSpecial for BIPARTITIONS_BOOTSTOP)
+*/
+void bitVectorInitravSplits(BitVector **bitVectors, nodeptr p, int numsp, unsigned int vectorLength, SplitHash *h, int treeNumber, int *countBranches)
 {
-  int i;
+  if(isTip(p->number, numsp))
+    return;
+  else
+    {
+      nodeptr q = p->next;          
 
+      do 
+	{
+	  bitVectorInitravSplits(bitVectors, q->back, numsp, vectorLength, h, treeNumber, countBranches);
+	  q = q->next;
+	}
+      while(q != p);
+      
+      newviewBipartitions(bitVectors, p, numsp, vectorLength);
+      
+      assert(p->x);
+
+      if(NOT(isTip(p->back->number, numsp)))
+	{
+	  addSplitOfTree(h, bitVectors[p->number], p->hash, treeNumber);
+	  *countBranches =  *countBranches + 1;
+	}
+    }
+}
+
+
+void hookupDefault (nodeptr p, nodeptr q)
+{
   p->back = q;
   q->back = p;
 
-  for(i = 0; i < numBranches; i++)
-    p->z[i] = q->z[i] = defaultz;
+  p->z = q->z = defaultz;
 }
 
 
@@ -526,7 +599,7 @@ static boolean treeLabelEnd (int ch)
   return FALSE;
 }
 
-static boolean  treeGetLabel (FILE *fp, char *lblPtr, int maxlen)
+static boolean  treeGetLabel (TreeReader *reader, char *lblPtr, int maxlen)
 {
   int      ch;
   boolean  done, quoted, lblfound;
@@ -537,14 +610,14 @@ static boolean  treeGetLabel (FILE *fp, char *lblPtr, int maxlen)
     if (lblPtr == NULL) 
       maxlen = 0;
 
-  ch = getc(fp);
+  ch = READER_GETC(reader);
   done = treeLabelEnd(ch);
 
   lblfound = NOT done;
   quoted = (ch == '\'');
   if (quoted && NOT done) 
     {
-      ch = getc(fp); 
+      ch = READER_GETC(reader); 
       done = (ch == EOF);
     }
 
@@ -554,7 +627,7 @@ static boolean  treeGetLabel (FILE *fp, char *lblPtr, int maxlen)
 	{
 	  if (ch == '\'') 
 	    {
-	      ch = getc(fp); 
+	      ch = READER_GETC(reader); 
 	      if (ch != '\'') 
 		break;
 	    }
@@ -563,30 +636,31 @@ static boolean  treeGetLabel (FILE *fp, char *lblPtr, int maxlen)
 	if (treeLabelEnd(ch)) break;     
 
       if (--maxlen >= 0) *lblPtr++ = ch;
-      ch = getc(fp);
+      ch = READER_GETC(reader);
       if (ch == EOF) break;
     }
 
-  if (ch != EOF)  (void) ungetc(ch, fp);
+  READER_UNGETC(ch, reader);
 
   if (lblPtr != NULL) *lblPtr = '\0';
 
   return lblfound;
 }
 
-static boolean  treeFlushLabel (FILE *fp)
+static boolean  treeFlushLabel (TreeReader *reader)
 { 
-  return  treeGetLabel(fp, (char *) NULL, (int) 0);
+  return  treeGetLabel(reader, (char *) NULL, (int) 0);
 } 
 
-int lookupWord(char *s, stringHashtable *h)
+
+static int lookupWordWithLength(char *s, int length, stringHashtable *h)
 {
-  unsigned int position = hashString(s, h->tableSize);
+  unsigned int position = hashString(s, length, h->tableSize);
   stringEntry *p = h->table[position];
   
   for(; p!= NULL; p = p->next)
     {
-      if(strcmp(s, p->word) == 0)		 
+      if(strncmp(s, p->word, length) == 0 && p->word[length] == '\0')		 
 	return p->nodeNumber;	  	
     }
 
@@ -594,6 +668,12 @@ int lookupWord(char *s, stringHashtable *h)
 }
 
 
+int lookupWord(char *s, stringHashtable *h)
+{
+  return lookupWordWithLength(s, strlen(s), h);
+}
+
+
 int treeFindTipByLabelString(char  *str, All *tr)
 {
   int lookup = lookupWord(str, tr->nameHash);
@@ -611,31 +691,86 @@ int treeFindTipByLabelString(char  *str, All *tr)
 }
 
 
-int treeFindTipName(FILE *fp, All *tr)
+/* 
+   Unquoted labels are looked up directly in the mapped buffer, only
+   quoted labels (that may contain escaped quotes) are copied.
+*/
+int treeFindTipName(TreeReader *reader, All *tr)
 {
-  char    str[nmlngth+2];
-  int      n;
+  char    
+    str[nmlngth+2]; 
+  int      
+    n,
+    labelLength, 
+    ch;
 
-  if(treeGetLabel(fp, str, nmlngth+2))
-    n = treeFindTipByLabelString(str, tr);
-  else
-    n = 0;
-   
+  READER_SET_MARK(reader);
+  ch = READER_GETC(reader);
+
+  if(ch == '\'')
+    {
+      READER_CLEAR_MARK(reader);
+      READER_UNGETC(ch, reader);
+      if(treeGetLabel(reader, str, nmlngth+2))
+	n = treeFindTipByLabelString(str, tr);
+      else
+	n = 0;
+      return n; 
+    }
+
+  while(NOT treeLabelEnd(ch))
+    ch = READER_GETC(reader);
+  READER_UNGETC(ch, reader);
+  READER_CLEAR_MARK(reader);
+
+  labelLength = reader->position - reader->mark; 
+  if(labelLength == 0)
+    return 0; 
+
+  n = lookupWordWithLength(READER_MARKED_BYTES(reader), labelLength, tr->nameHash);
+
+  if(n <= 0)
+    {
+      printf("ERROR: Cannot find tree species: %.*s\n", labelLength, READER_MARKED_BYTES(reader));
+      n = 0; 
+    }
 
   return  n;
 }
 
 
-static boolean treeProcessLength (FILE *fp, double *dptr)
+static boolean isNumberChar(int ch)
 {
-  int  ch;
+  return (isdigit(ch) || ch == '.' || ch == '-' || ch == '+' || ch == 'e' || ch == 'E');
+}
+
+
+static boolean treeProcessLength (TreeReader *reader, double *dptr)
+{
+  int  
+    ch, 
+    i = 0; 
+  char 
+    number[64],
+    *numberEnd; 
   
-  if ((ch = treeGetCh(fp)) == EOF)  return FALSE;    /*  Skip comments */
-  (void) ungetc(ch, fp);
+  if ((ch = treeGetCh(reader)) == EOF)  return FALSE;    /*  Skip comments */
+  READER_UNGETC(ch, reader);
+
+  /* the mapped buffer is not null-terminated, thus copy the number */
+  READER_SET_MARK(reader);
+  while(i < 63 && isNumberChar(ch = READER_GETC(reader)))
+    number[i++] = ch;
+  READER_UNGETC(ch, reader);
+  number[i] = '\0';
   
-  if (fscanf(fp, "%lf", dptr) != 1) {
+  *dptr = strtod(number, &numberEnd);
+  reader->position = reader->mark + (numberEnd - number); 
+  READER_CLEAR_MARK(reader);
+
+  if (numberEnd == number) {
     printf("ERROR: treeProcessLength: Problem reading branch length\n");
-    treeEchoContext(fp, stdout, 40);
+    treeEchoContext(reader, stdout, 40);
     printf("\n");
     return  FALSE;
   }
@@ -644,25 +779,23 @@ static boolean treeProcessLength (FILE *fp, double *dptr)
 }
 
 
-static int treeFlushLen (FILE  *fp)
+static int treeFlushLen (TreeReader *reader)
 {
   double  dummy;  
   int     ch;
   
-  ch = treeGetCh(fp);
+  ch = treeGetCh(reader);
   
   if (ch == ':') 
     {
-      ch = treeGetCh(fp);
+      ch = treeGetCh(reader);
       
-      ungetc(ch, fp);
-      if(NOT treeProcessLength(fp, & dummy)) return 0;
+      READER_UNGETC(ch, reader);
+      if(NOT treeProcessLength(reader, & dummy)) return 0;
       return 1;	  
     }
   
-  
-  
-  if (ch != EOF) (void) ungetc(ch, fp);
+  READER_UNGETC(ch, reader);
   return 1;
 }
 
@@ -678,7 +811,7 @@ boolean isTip(int number, int maxTips)
 }
 
 
-static char *Tree2StringREC(char *treestr, All *tr, nodeptr p, boolean printBranchLengths, boolean printNames, boolean printLikelihood, boolean rellTree, boolean finalPrint, int perGene, boolean branchLabelSupport, boolean printSHSupport)
+static char *Tree2StringREC(char *treestr, All *tr, nodeptr p, boolean printBranchLengths, boolean printNames)
 {
   char  *nameptr;            
       
@@ -697,60 +830,30 @@ static char *Tree2StringREC(char *treestr, All *tr, nodeptr p, boolean printBran
   else 
     {                 	 
       *treestr++ = '(';
-      treestr = Tree2StringREC(treestr, tr, p->next->back, printBranchLengths, printNames, printLikelihood, rellTree, 
-			       finalPrint, perGene, branchLabelSupport, printSHSupport);
+      treestr = Tree2StringREC(treestr, tr, p->next->back, printBranchLengths, printNames);
       *treestr++ = ',';
-      treestr = Tree2StringREC(treestr, tr, p->next->next->back, printBranchLengths, printNames, printLikelihood, rellTree, 
-			       finalPrint, perGene, branchLabelSupport, printSHSupport);
+      treestr = Tree2StringREC(treestr, tr, p->next->next->back, printBranchLengths, printNames);
       if(p == tr->start->back) 
 	{
 	  *treestr++ = ',';
-	  treestr = Tree2StringREC(treestr, tr, p->back, printBranchLengths, printNames, printLikelihood, rellTree, 
-				   finalPrint, perGene, branchLabelSupport, printSHSupport);
+	  treestr = Tree2StringREC(treestr, tr, p->back, printBranchLengths, printNames);
 	}
       *treestr++ = ')';                    
     }
 
   if(p == tr->start->back) 
     {	      	 
-      if(printBranchLengths && NOT rellTree)
+      if(printBranchLengths)
 	sprintf(treestr, ":0.0;\n");
       else
 	sprintf(treestr, ";\n");	 	  	
     }
   else 
     {                   
-      if(rellTree || branchLabelSupport || printSHSupport)
-	{	 	 
-	  if(( NOT isTip(p->number, tr->mxtips)) && 
-	     ( NOT isTip(p->back->number, tr->mxtips)))
-	    {			      
-	      assert(p->bInf != (branchInfo *)NULL);
-	      
-	      if(rellTree)
-		sprintf(treestr, "%d:%8.20f", p->bInf->support, p->z[0]);
-	      if(branchLabelSupport)
-		sprintf(treestr, ":%8.20f[%d]", p->z[0], p->bInf->support);
-	      if(printSHSupport)
-		sprintf(treestr, ":%8.20f[%d]", getBranchLength(tr, perGene, p), p->bInf->support);
-	      
-	    }
-	  else		
-	    {
-	      if(rellTree || branchLabelSupport)
-		sprintf(treestr, ":%8.20f", p->z[0]);	
-	      if(printSHSupport)
-		sprintf(treestr, ":%8.20f", getBranchLength(tr, perGene, p));
-	    }
-	}
-      else
-	{
-	  if(printBranchLengths)	    
-	    /* sprintf(treestr, ":%8.20f", getBranchLength(tr, perGene, p));	      	    */
-	    sprintf(treestr, ":%8.20f", p->z[0]);
-	  else	    
-	    sprintf(treestr, "%s", "\0");	    
-	}      
+      if(printBranchLengths)	    
+	sprintf(treestr, ":%8.20f", p->z);
+      else	    
+	sprintf(treestr, "%s", "\0");	    
     }
   
   while (*treestr) treestr++;
@@ -758,24 +861,6 @@ static char *Tree2StringREC(char *treestr, All *tr, nodeptr p, boolean printBran
 }
 
 
-static double getBranchLength(All *tr, int perGene, nodeptr p)
-{
-  double 
-    z = 0.0,
-    x = 0.0;
-
-  assert(perGene != NO_BRANCHES);
-  assert(tr->fracchange != -1.0);
-  z = p->z[0];
-  if (z < zmin) 
-    z = zmin;      	 
-  
-  x = -log(z) * tr->fracchange;           
-
-  return x;			/* here! */
-}
-
-
 static nodeptr uprootTree (All *tr, nodeptr p, boolean readBranchLengths, boolean readConstraint)
 {
   nodeptr  q, r, s, start;
@@ -814,15 +899,9 @@ static nodeptr uprootTree (All *tr, nodeptr p, boolean readBranchLengths, boolea
   assert(p->back == (nodeptr)NULL);
     
   if(readBranchLengths)
-    {
-      double b[NUM_BRANCHES];
-      int i;
-      for(i = 0; i < tr->numBranches; i++)
-	b[i] = (r->z[i] + q->z[i]);
-      hookup (q, r, b, tr->numBranches);
-    }
+    hookup (q, r, r->z + q->z);
   else    
-    hookupDefault(q, r, tr->numBranches);    
+    hookupDefault(q, r);    
 
   if(readConstraint && tr->grouped)
     {    
@@ -846,9 +925,9 @@ static nodeptr uprootTree (All *tr, nodeptr p, boolean readBranchLengths, boolea
       if(readConstraint && tr->grouped)	
 	tr->constraintVector[p->number] = tr->constraintVector[q->number];       
       
-      hookup(p,             q->back, q->z, tr->numBranches);   /* move connections to p */
-      hookup(p->next,       r->back, r->z, tr->numBranches);
-      hookup(p->next->next, s->back, s->z, tr->numBranches);           
+      hookup(p,             q->back, q->z);   /* move connections to p */
+      hookup(p->next,       r->back, r->z);
+      hookup(p->next->next, s->back, s->z);           
       
       q->back = q->next->back = q->next->next->back = (nodeptr) NULL;
     }
@@ -865,14 +944,9 @@ static nodeptr uprootTree (All *tr, nodeptr p, boolean readBranchLengths, boolea
 }
 
 
-char *Tree2String(char *treestr, All *tr, nodeptr p, 
-		  boolean printBranchLengths, boolean printNames, 
-		  boolean printLikelihood, boolean rellTree, 
-		  boolean finalPrint, int perGene, 
-		  boolean branchLabelSupport, boolean printSHSupport)
+char *Tree2String(char *treestr, All *tr, nodeptr p, boolean printBranchLengths, boolean printNames)
 { 
-  Tree2StringREC(treestr, tr, p, printBranchLengths, printNames, printLikelihood, rellTree, 
-		 finalPrint, perGene, branchLabelSupport, printSHSupport);      
+  Tree2StringREC(treestr, tr, p, printBranchLengths, printNames);
   
   while (*treestr) treestr++;
   
@@ -886,14 +960,14 @@ boolean whitechar (int ch)
 }
 
 
-static void  treeEchoContext (FILE *fp1, FILE *fp2, int n)
+static void  treeEchoContext (TreeReader *reader, FILE *fp2, int n)
 { /* treeEchoContext */
   int      ch;
   boolean  waswhite;
   
   waswhite = TRUE;
   
-  while (n > 0 && ((ch = getc(fp1)) != EOF)) {
+  while (n > 0 && ((ch = READER_GETC(reader)) != EOF)) {
     if (whitechar(ch)) {
       ch = waswhite ? '\0' : ' ';
       waswhite = TRUE;
@@ -907,14 +981,14 @@ static void  treeEchoContext (FILE *fp1, FILE *fp2, int n)
 }
 
 
-int treeFinishCom (FILE *fp, char **strp)
+int treeFinishCom (TreeReader *reader, char **strp)
 {
   int  ch;
   
-  while ((ch = getc(fp)) != EOF && ch != ']') {
+  while ((ch = READER_GETC(reader)) != EOF && ch != ']') {
     if (strp != NULL) *(*strp)++ = ch;    /* save character  */
     if (ch == '[') {                      /* nested comment; find its end */
-      if ((ch = treeFinishCom(fp, strp)) == EOF)  break;
+      if ((ch = treeFinishCom(reader, strp)) == EOF)  break;
       if (strp != NULL) *(*strp)++ = ch;  /* save closing ]  */
     }
   }
@@ -924,14 +998,14 @@ int treeFinishCom (FILE *fp, char **strp)
 }
 
 
-static int treeGetCh (FILE *fp) 
+static int treeGetCh (TreeReader *reader) 
 {
   int  ch;
 
-  while ((ch = getc(fp)) != EOF) {
+  while ((ch = READER_GETC(reader)) != EOF) {
     if (whitechar(ch)) ;
     else if (ch == '[') {                   /* comment; find its end */
-      if ((ch = treeFinishCom(fp, (char **) NULL)) == EOF)  break;
+      if ((ch = treeFinishCom(reader, (char **) NULL)) == EOF)  break;
     }
     else  break;
   }
@@ -940,11 +1014,11 @@ static int treeGetCh (FILE *fp)
 }
 
 
-static boolean treeNeedCh (FILE *fp, int c1, char *where)
+static boolean treeNeedCh (TreeReader *reader, int c1, char *where)
 {
   int  c2;
   
-  if ((c2 = treeGetCh(fp)) == c1)  return TRUE;
+  if ((c2 = treeGetCh(reader)) == c1)  return TRUE;
   
   printf("ERROR: Expecting '%c' %s tree; found:", c1, where);
   if (c2 == EOF) 
@@ -953,8 +1027,8 @@ static boolean treeNeedCh (FILE *fp, int c1, char *where)
     }
   else 
     {      	
-      ungetc(c2, fp);
-      treeEchoContext(fp, stdout, 40);
+      READER_UNGETC(c2, reader);
+      treeEchoContext(reader, stdout, 40);
     }
   putchar('\n');
 
@@ -965,12 +1039,12 @@ static boolean treeNeedCh (FILE *fp, int c1, char *where)
 }
 
 
-static boolean addElementLen (FILE *fp, All *tr, nodeptr p, boolean readBranchLengths, boolean readNodeLabels, int *lcount)
+static boolean addElementLen (TreeReader *reader, All *tr, nodeptr p, boolean readBranchLengths, boolean readNodeLabels, int *lcount)
 {   
   nodeptr  q;
   int      n, ch, fres;
   
-  if ((ch = treeGetCh(fp)) == '(') 
+  if ((ch = treeGetCh(reader)) == '(') 
     { 
       n = (tr->nextnode)++;
       if (n > 2*(tr->mxtips) - 2) 
@@ -990,37 +1064,34 @@ static boolean addElementLen (FILE *fp, All *tr, nodeptr p, boolean readBranchLe
       
       q = tr->nodep[n];
 
-      if (NOT addElementLen(fp, tr, q->next, readBranchLengths, readNodeLabels, lcount))        return FALSE;
-      if (NOT treeNeedCh(fp, ',', "in"))             return FALSE;
-      if (NOT addElementLen(fp, tr, q->next->next, readBranchLengths, readNodeLabels, lcount))  return FALSE;
-      if (NOT treeNeedCh(fp, ')', "in"))             return FALSE;
+      if (NOT addElementLen(reader, tr, q->next, readBranchLengths, readNodeLabels, lcount))        return FALSE;
+      if (NOT treeNeedCh(reader, ',', "in"))             return FALSE;
+      if (NOT addElementLen(reader, tr, q->next->next, readBranchLengths, readNodeLabels, lcount))  return FALSE;
+      if (NOT treeNeedCh(reader, ')', "in"))             return FALSE;
       
       if(readNodeLabels)
 	{
 	  char label[64];
 	  int support;
 
-	  if(treeGetLabel (fp, label, 10))
+	  if(treeGetLabel (reader, label, 10))
 	    {	
 	      int val = sscanf(label, "%d", &support);      
 	      assert(val == 1);
 	      if(val != 1 )
 		PR("error\n");
 
-	      /*printf("LABEL %s Number %d\n", label, support);*/
-	      p->support = q->support = support;
-	      /*printf("%d %d %d %d\n", p->support, q->support, p->number, q->number);*/
 	      assert(p->number > tr->mxtips && q->number > tr->mxtips);
 	      *lcount = *lcount + 1;
 	    }
 	}
       else	
-	(void) treeFlushLabel(fp);
+	(void) treeFlushLabel(reader);
     }
   else 
     {   
-      ungetc(ch, fp);
-      if ((n = treeFindTipName(fp, tr)) <= 0)          return FALSE;
+      READER_UNGETC(ch, reader);
+      if ((n = treeFindTipName(reader, tr)) <= 0)          return FALSE;
       q = tr->nodep[n];
       if (tr->start->number > n)  tr->start = q;
       (tr->ntips)++;
@@ -1029,19 +1100,17 @@ static boolean addElementLen (FILE *fp, All *tr, nodeptr p, boolean readBranchLe
   if(readBranchLengths)
     {
       double branch;
-      if (NOT treeNeedCh(fp, ':', "in"))                 return FALSE;
-      if (NOT treeProcessLength(fp, &branch))            return FALSE;
+      if (NOT treeNeedCh(reader, ':', "in"))                 return FALSE;
+      if (NOT treeProcessLength(reader, &branch))            return FALSE;
       
-      /* printf("Branch %8.20f %d\n", branch, tr->numBranches); */
-      hookup(p, q, &branch, tr->numBranches);
-      /* PR(">>> %d\n", tr->numBranches); */
+      hookup(p, q, branch);
     }
   else
     {
-      fres = treeFlushLen(fp);
+      fres = treeFlushLen(reader);
       if(NOT fres) return FALSE;
       
-      hookupDefault(p, q, tr->numBranches);
+      hookupDefault(p, q);
     }
   return TRUE;          
 }
@@ -1049,21 +1118,18 @@ static boolean addElementLen (FILE *fp, All *tr, nodeptr p, boolean readBranchLe
 
 int getTreeStringLength(char *fileName)
 {
-  int
-    i = 0;
-  char
-    cc;
-  FILE
-    *f = myfopen(fileName,"r"); 
+  TreeReader 
+    *reader = openTreeReader(fileName);
+  int 
+    length = getLineLengthOfReader(reader);
 
-  while((cc=getc(f))!='\n')  i++;
-  fclose(f);
+  closeTreeReader(reader);
 
-  return i; 
+  return length; 
 }
 
 
-int treeReadLen (FILE *fp, All *tr, 
+int treeReadLen (TreeReader *reader, All *tr, 
 		 boolean readBranches, boolean readNodeLabels, 
 		 boolean topologyOnly, boolean completeTree)
 {
@@ -1076,11 +1142,7 @@ int treeReadLen (FILE *fp, All *tr,
     lcount = 0; 
 
   for (i = 1; i <= tr->mxtips; i++) 
-    {
-      tr->nodep[i]->back = (nodeptr) NULL; 
-      if(topologyOnly)
-	tr->nodep[i]->support = -1;
-    }
+    tr->nodep[i]->back = (nodeptr) NULL; 
 
   for(i = tr->mxtips + 1; i < 2 * tr->mxtips; i++)
     {
@@ -1090,13 +1152,6 @@ int treeReadLen (FILE *fp, All *tr,
       tr->nodep[i]->number = i;
       tr->nodep[i]->next->number = i;
       tr->nodep[i]->next->next->number = i;
-
-      if(topologyOnly)
-	{
-	  tr->nodep[i]->support = -2;
-	  tr->nodep[i]->next->support = -2;
-	  tr->nodep[i]->next->next->support = -2;
-	}
     }
 
   if(topologyOnly)
@@ -1106,55 +1161,52 @@ int treeReadLen (FILE *fp, All *tr,
 
   tr->ntips       = 0;
   tr->nextnode    = tr->mxtips + 1;      
- 
-  for(i = 0; i < tr->numBranches; i++)
-    tr->partitionSmoothed[i] = FALSE;
   
   tr->rooted      = FALSE;     
 
   p = tr->nodep[(tr->nextnode)++]; 
   
-  while((ch = treeGetCh(fp)) != '(');
+  while((ch = treeGetCh(reader)) != '(');
   
   if(NOT topologyOnly)
     assert(readBranches == FALSE && readNodeLabels == FALSE);
   
        
-  if (NOT addElementLen(fp, tr, p, readBranches, readNodeLabels, &lcount))                 
+  if (NOT addElementLen(reader, tr, p, readBranches, readNodeLabels, &lcount))                 
     assert(0);
-  if (NOT treeNeedCh(fp, ',', "in"))                
+  if (NOT treeNeedCh(reader, ',', "in"))                
     assert(0);
-  if (NOT addElementLen(fp, tr, p->next, readBranches, readNodeLabels, &lcount))
+  if (NOT addElementLen(reader, tr, p->next, readBranches, readNodeLabels, &lcount))
     assert(0);
   if (NOT tr->rooted) 
     {
-      if ((ch = treeGetCh(fp)) == ',') 
+      if ((ch = treeGetCh(reader)) == ',') 
 	{ 
-	  if (NOT addElementLen(fp, tr, p->next->next, readBranches, readNodeLabels, &lcount))
+	  if (NOT addElementLen(reader, tr, p->next->next, readBranches, readNodeLabels, &lcount))
 	    assert(0);	    
 	}
       else 
 	{                                    /*  A rooted format */
 	  tr->rooted = TRUE;
-	  if (ch != EOF)  (void) ungetc(ch, fp);
+	  READER_UNGETC(ch, reader);
 	}	
     }
   else 
     {      
       p->next->next->back = (nodeptr) NULL;
     }
-  if (NOT treeNeedCh(fp, ')', "in"))                
+  if (NOT treeNeedCh(reader, ')', "in"))                
     assert(0);
 
   if(topologyOnly)
     assert(NOT(tr->rooted && readNodeLabels));
 
-  (void) treeFlushLabel(fp);
+  (void) treeFlushLabel(reader);
   
-  if (NOT treeFlushLen(fp))                         
+  if (NOT treeFlushLen(reader))                         
     assert(0);
  
-  if (NOT treeNeedCh(fp, ';', "at end of"))       
+  if (NOT treeNeedCh(reader, ';', "at end of"))       
     assert(0);
   
   if (tr->rooted) 
@@ -1209,8 +1261,8 @@ entry *initEntry(void)
 {
   entry *e = (entry*)CALLOC(1,sizeof(entry));
 
-  e->bitVector     = (unsigned int*)NULL;
-  e->treeVector    = (unsigned int*)NULL;
+  e->bitVector     = (BitVector*)NULL;
+  e->treeVector    = (BitVector*)NULL;
   e->supportVector = (int*)NULL;
   e->bipNumber  = 0;
   e->bipNumber2 = 0;
@@ -1222,7 +1274,7 @@ entry *initEntry(void)
 }
 
 
-static void insertHashAll(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber,  unsigned int position)
+static void insertHashAll(BitVector *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber,  unsigned int position)
 {    
   if(h->table[position] != NULL)
     {
@@ -1251,12 +1303,12 @@ static void insertHashAll(unsigned int *bitVector, hashtable *h, unsigned int ve
 
       e = initEntry(); 
   
-      e->bitVector  = (unsigned int*)CALLOC(vectorLength, sizeof(unsigned int));
-      /* e->bitVector = (unsigned int*)malloc_aligned(vectorLength * sizeof(unsigned int)); */
-      memset(e->bitVector, 0, vectorLength * sizeof(unsigned int));
+      e->bitVector  = (BitVector*)CALLOC(vectorLength, sizeof(BitVector));
+      /* e->bitVector = (BitVector*)malloc_aligned(vectorLength * sizeof(BitVector)); */
+      memset(e->bitVector, 0, vectorLength * sizeof(BitVector));
 
 
-      memcpy(e->bitVector, bitVector, sizeof(unsigned int) * vectorLength);
+      memcpy(e->bitVector, bitVector, sizeof(BitVector) * vectorLength);
 
       if(treeNumber == 0)	
 	e->bipNumber  = 1;       	
@@ -1270,11 +1322,11 @@ static void insertHashAll(unsigned int *bitVector, hashtable *h, unsigned int ve
     {
       entry *e = initEntry(); 
   
-      e->bitVector  = (unsigned int*)CALLOC(vectorLength, sizeof(unsigned int));
-      /* e->bitVector = (unsigned int*)malloc_aligned(vectorLength * sizeof(unsigned int)); */
-      memset(e->bitVector, 0, vectorLength * sizeof(unsigned int));
+      e->bitVector  = (BitVector*)CALLOC(vectorLength, sizeof(BitVector));
+      /* e->bitVector = (BitVector*)malloc_aligned(vectorLength * sizeof(BitVector)); */
+      memset(e->bitVector, 0, vectorLength * sizeof(BitVector));
 
-      memcpy(e->bitVector, bitVector, sizeof(unsigned int) * vectorLength);
+      memcpy(e->bitVector, bitVector, sizeof(BitVector) * vectorLength);
 
       if(treeNumber == 0)	
 	e->bipNumber  = 1;	  	
@@ -1288,57 +1340,7 @@ static void insertHashAll(unsigned int *bitVector, hashtable *h, unsigned int ve
 }
 
 
-static void insertHash(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, int bipNumber, unsigned int position)
-{
-  entry *e = initEntry();
-
-  e->bipNumber = bipNumber; 
-  /*e->bitVector = (unsigned int*)CALLOC(vectorLength, sizeof(unsigned int)); */
-
-  e->bitVector = (unsigned int*)CALLOC(vectorLength , sizeof(unsigned int));
-  memset(e->bitVector, 0, vectorLength * sizeof(unsigned int));
- 
-  memcpy(e->bitVector, bitVector, sizeof(unsigned int) * vectorLength);
-  
-  if(h->table[position] != NULL)
-    {
-      e->next = h->table[position];
-      h->table[position] = e;           
-    }
-  else
-    h->table[position] = e;
-
-  h->entryCount =  h->entryCount + 1;
-}
-
-
-static int countHash(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, unsigned int position)
-{ 
-  if(h->table[position] == NULL)         
-    return -1;
-  {
-    entry *e = h->table[position];     
-
-    do
-      {	 
-	unsigned int i;
-
-	for(i = 0; i < vectorLength; i++)
-	  if(bitVector[i] != e->bitVector[i])
-	    goto NEXT;
-	   
-	return (e->bipNumber);	 
-      NEXT:
-	e = e->next;
-      }
-    while(e != (entry*)NULL); 
-     
-    return -1;   
-  }
-}
-
-
-static void insertHashBootstop(unsigned int *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber, int treeVectorLength, unsigned int position)
+static void insertHashBootstop(BitVector *bitVector, hashtable *h, unsigned int vectorLength, int treeNumber, int treeVectorLength, unsigned int position)
 {    
   if(h->table[position] != NULL)
     {
@@ -1366,15 +1368,15 @@ static void insertHashBootstop(unsigned int *bitVector, hashtable *h, unsigned i
 
       e->bipNumber = h->entryCount;
        
-      /*e->bitVector  = (unsigned int*)CALLOC(vectorLength, sizeof(unsigned int));*/
-      e->bitVector = (unsigned int*)CALLOC(vectorLength, sizeof(unsigned int));
-      memset(e->bitVector, 0, vectorLength * sizeof(unsigned int));
+      /*e->bitVector  = (BitVector*)CALLOC(vectorLength, sizeof(BitVector));*/
+      e->bitVector = (BitVector*)CALLOC(vectorLength, sizeof(BitVector));
+      memset(e->bitVector, 0, vectorLength * sizeof(BitVector));
 
 
-      e->treeVector = (unsigned int*)CALLOC(treeVectorLength, sizeof(unsigned int));
+      e->treeVector = (BitVector*)CALLOC(treeVectorLength, sizeof(BitVector));
       
       e->treeVector[treeNumber / MASK_LENGTH] |= mask32[treeNumber % MASK_LENGTH];
-      memcpy(e->bitVector, bitVector, sizeof(unsigned int) * vectorLength);
+      memcpy(e->bitVector, bitVector, sizeof(BitVector) * vectorLength);
      
       e->next = h->table[position];
       h->table[position] = e;          
@@ -1385,13 +1387,13 @@ static void insertHashBootstop(unsigned int *bitVector, hashtable *h, unsigned i
 
       e->bipNumber = h->entryCount;
 
-      e->bitVector = (unsigned int*)CALLOC(vectorLength , sizeof(unsigned int));
-      memset(e->bitVector, 0, vectorLength * sizeof(unsigned int));
+      e->bitVector = (BitVector*)CALLOC(vectorLength , sizeof(BitVector));
+      memset(e->bitVector, 0, vectorLength * sizeof(BitVector));
 
-      e->treeVector = (unsigned int*)CALLOC(treeVectorLength, sizeof(unsigned int));
+      e->treeVector = (BitVector*)CALLOC(treeVectorLength, sizeof(BitVector));
 
       e->treeVector[treeNumber / MASK_LENGTH] |= mask32[treeNumber % MASK_LENGTH];
-      memcpy(e->bitVector, bitVector, sizeof(unsigned int) * vectorLength);     
+      memcpy(e->bitVector, bitVector, sizeof(BitVector) * vectorLength);     
 
       h->table[position] = e;
     }
@@ -1400,49 +1402,49 @@ static void insertHashBootstop(unsigned int *bitVector, hashtable *h, unsigned i
 }
 
 
-FILE *getNumberOfTrees(All *tr, char *fileName)
+TreeReader *getNumberOfTrees(All *tr, char *fileName)
 {
-  FILE 
-    *f = myfopen(fileName, "r");
+  TreeReader 
+    *reader = openTreeReader(fileName);
 
   int 
-    trees = 0,
-    ch;
-
-  while((ch = fgetc(f)) != EOF)
-    if(ch == ';')
-      trees++;
+    trees = countTreesInReader(reader);
 
   assert(trees > 0);
 
   tr->numberOfTrees = trees;
 
-  rewind(f);
-
-  return f;
+  return reader;
 }
 
 
 /* INTERFACE TO OUTSIDE WOLRD */
-void readBestTree(All *tr, FILE *file)
+boolean hasMoreTrees(TreeReader *reader)
+{
+  int 
+    ch = treeGetCh(reader);
+
+  READER_UNGETC(ch, reader);
+
+  return ch != EOF; 
+}
+
+
+void readBestTree(All *tr, TreeReader *reader)
 {
-  treeReadLen(file, tr, TRUE, FALSE, TRUE,  TRUE);
+  treeReadLen(reader, tr, TRUE, FALSE, TRUE,  TRUE);
 }
 
 
-void readBootstrapTree(All *tr, FILE *file)
+void readBootstrapTree(All *tr, TreeReader *reader)
 {
-  treeReadLen(file, tr, FALSE, FALSE, TRUE, TRUE);
+  treeReadLen(reader, tr, FALSE, FALSE, TRUE, TRUE);
 }
 
 
 char *writeTreeToString(All *tr, boolean printBranchLengths)
 {
-  Tree2String(tr->tree_string, tr, tr->start->back, /*  */
-	      printBranchLengths, TRUE, 
-	      FALSE, FALSE, 
-	      TRUE, 0,
-	      FALSE, FALSE);
+  Tree2String(tr->tree_string, tr, tr->start->back, printBranchLengths, TRUE);
   return tr->tree_string;
 }
 
@@ -39,20 +39,25 @@
 
 #include "common.h"
 #include "legacy.h"
+#include "TreeReader.h"
 
-extern unsigned int *mask32;
 
 boolean isTip(int number, int maxTips);
 char *writeTreeToString(All *tr, boolean printBranchLengths);
 void readTree(char *fileName);
 boolean setupTree (All *tr, char *bootstrapTrees);
-void readBestTree(All *tr, FILE *file);  
-void readBootstrapTree(All *tr, FILE *file);
-void hookupDefault (nodeptr p, nodeptr q, int numBranches);
-void hookupAdd (nodeptr p, nodeptr q, int numBranches);
+boolean setupTreeFromReader(All *tr, TreeReader *reader);
+boolean setupTreeFromNames(All *tr, char **names, uint64_t *tipHashes, int numberOfTaxa);
+All *copyTreeSkeleton(All *tr);
+void freeTreeSkeleton(All *tr);
+boolean hasMoreTrees(TreeReader *reader);
+void readBestTree(All *tr, TreeReader *reader);  
+void readBootstrapTree(All *tr, TreeReader *reader);
+void hookupDefault (nodeptr p, nodeptr q);
+void hookupAdd (nodeptr p, nodeptr q);
 nodeptr findAnyTip(nodeptr p, int numsp);
 int treeFindTipByLabelString(char  *str, All *tr);
 int getTreeStringLength(char *fileName);
-FILE *getNumberOfTrees(All *tr, char *fileName);
+TreeReader *getNumberOfTrees(All *tr, char *fileName);
 void freeTree(All *tr);
 #endif
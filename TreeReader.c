@@ -0,0 +1,294 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "TreeReader.h"
+
+#define STREAM_BUFFER_SIZE (1 << 20)
+
+
+static boolean fillBuffer(TreeReader *reader)
+{
+  size_t
+    keep = reader->hasMark ? reader->mark : reader->position; 
+  ssize_t
+    numRead;
+
+  if( NOT reader->isStream || reader->atEnd)
+    return FALSE; 
+
+  /* discard what has been consumed already */
+  memmove(reader->buffer, reader->buffer + keep, reader->length - keep);
+  reader->length -= keep; 
+  reader->position -= keep; 
+  if(reader->hasMark)
+    reader->mark -= keep; 
+
+  if(reader->length == reader->capacity)
+    {
+      reader->capacity *= 2; 
+      reader->buffer = realloc(reader->buffer, reader->capacity * sizeof(char));
+      assert(reader->buffer);
+    }
+
+  do 
+    numRead = read(reader->fd, reader->buffer + reader->length, reader->capacity - reader->length); 
+  while(numRead == -1 && errno == EINTR);
+
+  if(numRead <= 0)
+    {
+      reader->atEnd = TRUE; 
+      return FALSE; 
+    }
+
+  reader->length += numRead; 
+  return TRUE; 
+}
+
+
+static TreeReader *openReader(char *fileName, boolean streamIfNotMappable)
+{
+  TreeReader
+    *reader = CALLOC(1, sizeof(TreeReader));
+  int 
+    fd = open(fileName, O_RDONLY);
+  struct stat 
+    fileInfo; 
+
+  reader->fileName = fileName; 
+  reader->fd = -1; 
+
+  if(fd == -1)
+    {
+      if(processID == 0)
+	printf("The file %s you want to open for reading does not exist, exiting ...\n", fileName);
+      exit(-1);
+    }
+
+#ifndef WIN32
+  if(fstat(fd, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode) && fileInfo.st_size > 0)
+    {
+      void 
+	*mapped = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if(mapped != MAP_FAILED)
+	{
+	  madvise(mapped, fileInfo.st_size, MADV_SEQUENTIAL);
+	  reader->buffer = mapped; 
+	  reader->length = reader->capacity = fileInfo.st_size; 
+	  reader->isMapped = TRUE; 
+	  close(fd);
+	  return reader; 
+	}
+    }
+#endif
+
+  reader->capacity = STREAM_BUFFER_SIZE; 
+  reader->buffer = CALLOC(reader->capacity, sizeof(char));
+  reader->fd = fd; 
+  reader->isStream = TRUE; 
+
+  if( NOT streamIfNotMappable)
+    {
+      /* read the entire file, such that the reader can be rewound */
+      reader->hasMark = TRUE; 
+      while(fillBuffer(reader))
+	;
+      reader->hasMark = FALSE; 
+      reader->isStream = FALSE; 
+      reader->fd = -1; 
+      close(fd);
+    }
+
+  return reader; 
+}
+
+
+TreeReader *openTreeReader(char *fileName)
+{
+  return openReader(fileName, FALSE);
+}
+
+
+TreeReader *openTreeStream(char *fileName)
+{
+  return openReader(fileName, TRUE);
+}
+
+
+void rewindTreeReader(TreeReader *reader)
+{
+  if(reader->isStream && reader->position != 0)
+    {
+      printf("ERROR: trees from %s are read from a stream and can only be read once.\n", reader->fileName);
+      exit(-1);
+    }
+  reader->position = 0; 
+}
+
+
+void closeTreeReader(TreeReader *reader)
+{
+#ifndef WIN32
+  if(reader->isMapped)
+    munmap(reader->buffer, reader->length);
+  else
+#endif
+    free(reader->buffer);
+
+  if(reader->fd != -1)
+    close(reader->fd);
+
+  free(reader);
+}
+
+
+int readerUnderflow(TreeReader *reader)
+{
+  if(reader->position < reader->length || fillBuffer(reader))
+    return (unsigned char)reader->buffer[reader->position++];
+  else 
+    return EOF; 
+}
+
+
+/* 
+   returns a pointer to the next occurrence of c, all bytes from the
+   current position up to there are in the buffer afterwards
+*/
+char *readerFindAhead(TreeReader *reader, char c)
+{
+  boolean 
+    hadMark = reader->hasMark; 
+  size_t 
+    searched = reader->position; 
+  char
+    *result;
+
+  if( NOT hadMark)
+    READER_SET_MARK(reader);
+
+  while( NOT (result = memchr(reader->buffer + searched, c, reader->length - searched)))
+    {
+      size_t 
+	searchedBytes = reader->length - reader->mark; 
+      if( NOT fillBuffer(reader))
+	break; 
+      searched = reader->mark + searchedBytes; 
+    }
+  
+  if( NOT hadMark)
+    READER_CLEAR_MARK(reader);
+
+  return result; 
+}
+
+
+int countTreesInReader(TreeReader *reader)
+{
+  char 
+    *iter = reader->buffer,
+    *end = reader->buffer + reader->length; 
+
+  int 
+    trees = 0; 
+
+  assert( NOT reader->isStream); 
+  
+  while(iter < end && (iter = memchr(iter, ';', end - iter)))
+    {
+      trees++;
+      iter++;
+    }
+
+  return trees;
+}
+
+
+int getLineLengthOfReader(TreeReader *reader)
+{
+  char 
+    *newline = memchr(reader->buffer, '\n', reader->length);
+
+  assert( NOT reader->isStream); 
+
+  return newline ? (int)(newline - reader->buffer) : (int)reader->length;  
+}
+
+
+/* 
+   splits the trees held in the buffer of reader into numberOfParts
+   consecutive views of similar size that end at tree boundaries (some
+   of them may be empty). The views share the buffer of reader and
+   must not be closed.
+*/
+void splitTreeReader(TreeReader *reader, TreeReader *parts, int numberOfParts)
+{
+  size_t 
+    start = 0; 
+  int 
+    i; 
+
+  assert( NOT reader->isStream);
+
+  FOR_0_LIMIT(i,numberOfParts)
+    {
+      size_t
+	end = reader->length; 
+
+      if(i < numberOfParts - 1)
+	{
+	  size_t 
+	    target = (reader->length / numberOfParts) * (i + 1); 
+	  char 
+	    *separator; 
+
+	  if(target < start)
+	    target = start; 
+
+	  separator = memchr(reader->buffer + target, ';', reader->length - target);
+	  if(separator)
+	    end = separator - reader->buffer + 1; 
+	}
+
+      memset(parts + i, 0, sizeof(TreeReader));
+      parts[i].buffer = reader->buffer + start; 
+      parts[i].length = parts[i].capacity = end - start; 
+      parts[i].atEnd = TRUE; 
+      parts[i].fd = -1; 
+      parts[i].fileName = reader->fileName; 
+
+      start = end; 
+    }
+}
@@ -0,0 +1,79 @@
+/*  RogueNaRok is an algorithm for the identification of rogue taxa in a set of phylogenetic trees. 
+ *
+ *  Moreover, the program collection comes with efficient implementations of 
+ *   * the unrooted leaf stability by Thorley and Wilkinson
+ *   * the taxonomic instability index by Maddinson and Maddison
+ *   * a maximum agreement subtree implementation (MAST) for unrooted trees 
+ *   * a tool for pruning taxa from a tree collection. 
+ * 
+ *  Copyright October 2011 by Andre J. Aberer
+ * 
+ *  Tree I/O and parallel framework are derived from RAxML by Alexandros Stamatakis.
+ *
+ *  This program is free software; you may redistribute it and/or
+ *  modify its under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  For any other inquiries send an Email to Andre J. Aberer
+ *  andre.aberer at googlemail.com
+ * 
+ *  When publishing work that is based on the results from RogueNaRok, please cite:
+ *  Andre J. Aberer, Denis Krompaß, Alexandros Stamatakis. RogueNaRok: an Efficient and Exact Algorithm for Rogue Taxon Identification. (unpublished) 2011. 
+ * 
+ */
+
+
+#ifndef TREE_READER_H
+#define TREE_READER_H
+
+#include "common.h"
+
+/* 
+   A tree file is mapped into memory once and parsed directly from the
+   mapped bytes. Where mmap is not available (or the input is not a
+   regular file), the file is either read into a buffer in one go
+   (openTreeReader) or, if it only has to be read once from front to
+   back, streamed through a buffer that is refilled on demand
+   (openTreeStream). The latter also works for pipes.
+
+   While a mark is set, a refill keeps all bytes from the mark onwards
+   in the buffer, such that labels and numbers can be parsed in place.
+*/
+typedef struct
+{
+  char *buffer; 
+  size_t length; 
+  size_t capacity; 
+  size_t position; 
+  size_t mark; 
+  boolean hasMark; 
+  boolean isMapped;
+  boolean isStream; 
+  boolean atEnd; 
+  int fd; 
+  char *fileName; 
+} TreeReader; 
+
+#define READER_GETC(reader) (((reader)->position < (reader)->length) ? (unsigned char)(reader)->buffer[(reader)->position++] : readerUnderflow(reader))
+#define READER_UNGETC(ch, reader) (((ch) != EOF) ? (void)((reader)->position--) : (void)0)
+#define READER_SET_MARK(reader) ((reader)->mark = (reader)->position, (reader)->hasMark = TRUE)
+#define READER_CLEAR_MARK(reader) ((reader)->hasMark = FALSE)
+#define READER_MARKED_BYTES(reader) ((reader)->buffer + (reader)->mark)
+
+TreeReader *openTreeReader(char *fileName);
+TreeReader *openTreeStream(char *fileName);
+void rewindTreeReader(TreeReader *reader);
+void closeTreeReader(TreeReader *reader);
+int readerUnderflow(TreeReader *reader);
+char *readerFindAhead(TreeReader *reader, char c);
+int countTreesInReader(TreeReader *reader);
+int getLineLengthOfReader(TreeReader *reader);
+void splitTreeReader(TreeReader *reader, TreeReader *parts, int numberOfParts);
+
+#endif
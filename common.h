@@ -64,17 +64,17 @@ typedef char boolean;
 #define FOR_N_LIMIT(iter,n,limit) for(iter=(n); iter < (limit); iter++)
 #define PR printBothOpen
 #define SWAP(a, b) (((a) ^= (b)), ((b) ^= (a)), ((a) ^= (b)))
-#define USE_UPPER_TRIANGLE_LSI(matrix,a,b,c) (matrix[a][b][(c)-(b)])
-#define USE_UPPER_TRIANGLE_TII(matrix,x,y) (matrix[(x)][(y-x)]) /* assumes that x < y */
 #define MIN(a,b) (((a) > (b)) ? (b) : (a))
 #define MAX(a,b) (((a) < (b)) ? (b) : (a))
 
-#define GET_FROM_UPPER_TRIANGLE(matrix,a,b,c) ((b<c) ? matrix[a][b][(c)-(b)] : matrix[a][c][(b)-(c)])
-
 int processID;
 void  printVersionInfo(boolean toInfoFile);
 int wrapStrToL(char *string);
+#ifdef __GNUC__
+void printBothOpen(const char* format, ... ) __attribute__((format(printf, 1, 2)));
+#else
 void printBothOpen(const char* format, ... );
+#endif
 double wrapStrToDouble(char *string);
 char *lowerTheString(char *string);
 FILE *getOutputFileFromString(char *fileName);
@@ -71,14 +71,11 @@ void freeHashTable(hashtable *h)
   free(h->table);
 }
 
-hashtable *initHashTable(unsigned int n)
+unsigned int getHashTableSize(unsigned int n)
 {
   static const  unsigned int initTable[] = {64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576, 2097152, 4194304, 8388608, 16777216, 33554432, 67108864, 134217728, 268435456, 536870912, 1073741824, 2147483648U};
   
-  hashtable *h = (hashtable*)CALLOC(1,sizeof(hashtable));
-  
   unsigned int
-    tableSize,
     i,
 
 #ifndef NDEBUG
@@ -97,7 +94,16 @@ hashtable *initHashTable(unsigned int n)
   
   assert(i < primeTableLength);
 
-  tableSize = initTable[i];
+  return initTable[i];
+}
+
+
+hashtable *initHashTable(unsigned int n)
+{
+  hashtable *h = (hashtable*)CALLOC(1,sizeof(hashtable));
+  
+  unsigned int
+    tableSize = getHashTableSize(n);
 
   /* printf("Hash table init with size %u\n", tableSize); */
 
@@ -109,7 +115,7 @@ hashtable *initHashTable(unsigned int n)
 }
 
 
-BitVector **initBitVector(All *tr, BitVector *vectorLength)
+BitVector **initBitVector(All *tr, unsigned int *vectorLength)
 {
   BitVector **bitVectors = (BitVector **)CALLOC(2 * tr->mxtips, sizeof(BitVector*));
   int i;
@@ -131,23 +137,3 @@ BitVector **initBitVector(All *tr, BitVector *vectorLength)
   return bitVectors;
 }
 
-
-ProfileElem *addProfileElem(entry *helem, int vectorLength, int treeVectorLength, int numberOfTrees) 
-{
-  ProfileElem *result = CALLOC(1,sizeof(ProfileElem));
-  result->isInMLTree = FALSE; 
-  result->bitVector = CALLOC(vectorLength, sizeof(BitVector));
-  result->treeVector = CALLOC(treeVectorLength, sizeof(BitVector));
-  result->bitVector = memcpy(result->bitVector, helem->bitVector, vectorLength * sizeof(BitVector));
-  result->treeVector = memcpy(result->treeVector, helem->treeVector, treeVectorLength * sizeof(BitVector));
-
-  if(NTH_BIT_IS_SET(result->treeVector, numberOfTrees))
-    {
-      result->isInMLTree = TRUE;
-      UNFLIP_NTH_BIT(result->treeVector, numberOfTrees);
-    }
-  
-  result->treeVectorSupport = genericBitCount(result->treeVector, treeVectorLength);
-
-  return result; 
-}
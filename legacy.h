@@ -36,13 +36,12 @@
 #include "List.h"
 #include "Array.h"
 #include "ProfileElem.h"
-
-#define NUM_BRANCHES   128
+#include "SplitHash.h"
 
 typedef struct ent
 {
-  unsigned int *bitVector;
-  unsigned int *treeVector;
+  BitVector *bitVector;
+  BitVector *treeVector;
   unsigned int amountTips;
   int *supportVector;
   unsigned int bipNumber;
@@ -51,28 +50,14 @@ typedef struct ent
   struct ent *next;
 } entry;
 
-typedef struct
-{
-  unsigned int *vector; 
-  int support;   
-  struct noderec *oP;
-  struct noderec *oQ;
-} branchInfo;
-
 typedef  struct noderec
 {
-  unsigned int    isPresent[NUM_BRANCHES / MASK_LENGTH];
-  struct noderec  *backs[NUM_BRANCHES];
-  char            xs[NUM_BRANCHES];
-  branchInfo      *bInf;
-  double           z[NUM_BRANCHES];
   struct noderec  *next;
   struct noderec  *back;
-  unsigned int   hash;
-  int              support;
+  double           z;
+  uint64_t         hash;	/* low 32 bits: position in the legacy hash table */
   int              number;
   char             x;
-  double **insertionLWs;
 } node, *nodeptr;
 
 typedef struct stringEnt
@@ -98,8 +83,6 @@ typedef struct _All
   nodeptr *nodep;
   int ntips;
   int nextnode; 
-  int numBranches;
-  boolean partitionSmoothed[NUM_BRANCHES];
   boolean rooted;
   stringHashtable *nameHash;
   boolean grouped;
@@ -123,21 +106,19 @@ typedef struct
 #define NO_BRANCHES      -1
 
 #define BIPARTITIONS_ALL       0
-#define GET_BIPARTITIONS_BEST  1
-#define DRAW_BIPARTITIONS_BEST 2
 #define BIPARTITIONS_BOOTSTOP  3
 #define BIPARTITIONS_RF  4
 #define defaultz       0.9         /* value of z assigned as starting point */
 #define nmlngth        1024         /* number of characters in species name */
-#define VECTOR_LENGTH (NUM_BRANCHES / MASK_LENGTH)
 
-void bitVectorInitravSpecial(unsigned int **bitVectors, nodeptr p, int numsp, unsigned int vectorLength, hashtable *h, int treeNumber, int function, branchInfo *bInf, int *countBranches, int treeVectorLength, boolean traverseOnly, boolean computeWRF);
+void bitVectorInitravSpecial(BitVector **bitVectors, nodeptr p, int numsp, unsigned int vectorLength, hashtable *h, int treeNumber, int function, int *countBranches, int treeVectorLength, boolean traverseOnly, boolean computeWRF);
+void bitVectorInitravSplits(BitVector **bitVectors, nodeptr p, int numsp, unsigned int vectorLength, SplitHash *h, int treeNumber, int *countBranches);
+unsigned int getHashTableSize(unsigned int n);
 hashtable *initHashTable(unsigned int n);
 void freeHashTable(hashtable *h);
-ProfileElem *addProfileElem(entry *helem, int vectorLength, int treeVectorLength, int numberOfTrees) ;
 
 
 BitVector *neglectThoseTaxa(All *tr, char *toDrop);
 void pruneTaxon(All *tr, unsigned int k, boolean considerBranchLengths);
-BitVector **initBitVector(All *tr, BitVector *vectorLength);
+BitVector **initBitVector(All *tr, unsigned int *vectorLength);
 #endif
@@ -60,9 +60,9 @@ void pruneTaxon(All *tr, unsigned int k, boolean considerBranchLengths)
     q2 = q->next->next->back;
   
   if(considerBranchLengths)
-    hookupAdd(q1,q2,tr->numBranches); 
+    hookupAdd(q1,q2); 
   else
-    hookupDefault(q1,q2,tr->numBranches);
+    hookupDefault(q1,q2);
   
   tr->start = findAnyTip(q1, tr->mxtips);
   
@@ -103,20 +103,130 @@ BitVector *neglectThoseTaxa(All *tr, char *toDrop)
 }
 
 
-Array *getOriginalBipArray(All *tr, FILE *bestTree, FILE *treeFile) 
+/* 
+   The number of trees is not known in advance (the trees may come from
+   a pipe), thus the tree vectors of all bipartitions are doubled in
+   length, whenever they get too short.
+*/
+static void growTreeVectors(SplitHash *h, int numberOfTrees)
 {
-  Array *result = CALLOC(1, sizeof(Array));
+  if(GET_BITVECTOR_LENGTH(numberOfTrees) > h->treeVectorLength)
+    growSplitTreeVectors(h, 2 * h->treeVectorLength);
+}
+
+
+/* 
+   prepares the parallel extraction of bipartitions: the trees are
+   split into numberOfChunks parts that each get their own tree and
+   split hash. Returns NULL, if the trees are not held in memory
+   entirely (i.e., they are read from a stream).
+*/
+TreeChunk *splitIntoTreeChunks(All *tr, TreeReader *treeFile, int numberOfChunks)
+{
+  TreeChunk 
+    *result; 
+  TreeReader 
+    *views; 
+  int 
+    i,
+    commonStartNumber; 
+
+  if(treeFile->isStream)
+    return (TreeChunk*)NULL;
+
+  /* all chunks have to traverse the trees from the same start as the sequential code */
+  rewindTreeReader(treeFile);
+  if( NOT hasMoreTrees(treeFile))
+    return (TreeChunk*)NULL;
+  readBootstrapTree(tr, treeFile);
+  commonStartNumber = tr->start->number; 
+  rewindTreeReader(treeFile);
+
+  result = CALLOC(numberOfChunks, sizeof(TreeChunk));
+  views = CALLOC(numberOfChunks, sizeof(TreeReader));
+  splitTreeReader(treeFile, views, numberOfChunks);
+
+  FOR_0_LIMIT(i,numberOfChunks)
+    {
+      result[i].reader = views[i];
+      result[i].tr = copyTreeSkeleton(tr);
+      result[i].splits = createSplitHash(GET_BITVECTOR_LENGTH(tr->mxtips), 1, tr->mxtips * FC_INIT);
+      result[i].commonStartNumber = commonStartNumber;
+    }
+
+  free(views);
+  return result; 
+}
+
+
+/* extracts the bipartitions of all trees in a chunk, trees are numbered locally */
+void extractBipartitionsOfChunk(TreeChunk *chunk)
+{
+  All 
+    *tr = chunk->tr; 
+  int
+    i, 
+    bCount;
+  unsigned int 
+    vectorLength = 0;
+  BitVector
+    **setBitVectors = initBitVector(tr, &vectorLength);
+  nodeptr 
+    commonStart = tr->nodep[chunk->commonStartNumber];
+
+  for(i = 0; hasMoreTrees(&(chunk->reader)); ++i)
+    {
+      growTreeVectors(chunk->splits, i + 1);
+
+      readBootstrapTree(tr, &(chunk->reader));
+      bCount = 0; 
+      bitVectorInitravSplits(setBitVectors, commonStart->back, tr->mxtips, vectorLength, chunk->splits, i, &bCount);
+    }
+
+  chunk->numberOfTrees = i; 
+
+  freeBitVectors(setBitVectors, 2 * tr->mxtips);
+  free(setBitVectors);
+}
+
 
+void freeTreeChunks(TreeChunk *chunks, int numberOfChunks)
+{
   int 
-    i,j,bCount = 0,
-    treeVectorLength = GET_BITVECTOR_LENGTH((tr->numberOfTrees+1));
+    i; 
+
+  FOR_0_LIMIT(i,numberOfChunks)
+    {
+      freeSplitHash(chunks[i].splits);
+      freeTreeSkeleton(chunks[i].tr);
+    }
+
+  free(chunks);
+}
+
+
+/* 
+   reads all trees in a single pass and sets tr->numberOfTrees. If
+   chunks are given, their bipartitions (see
+   extractBipartitionsOfChunk) are merged instead of reading the trees
+   again.
+*/
+Array *getOriginalBipArray(All *tr, TreeReader *bestTree, TreeReader *treeFile, TreeChunk *chunks, int numberOfChunks) 
+{
+  Array 
+    *result;
+  int 
+    i,j,bCount = 0;
   unsigned int 
-    vectorLength = 0,
+    vectorLength = 0;
+  BitVector
     **setBitVectors = initBitVector(tr, &vectorLength);
-  hashtable
-    *setHtable =  initHashTable(tr->mxtips * FC_INIT * 10);
+  SplitHash
+    *splits = createSplitHash(vectorLength, 1, tr->mxtips * FC_INIT); 
   nodeptr 
     commonStart = NULL;  
+  ProfileElemAttr
+    *attr; 
 
   BitVector 
     lastByte = 0;  
@@ -130,53 +240,60 @@ Array *getOriginalBipArray(All *tr, FILE *bestTree, FILE *treeFile)
   for(i = 0; i < tr->mxtips; ++i)  
     randForTaxa[i] = rand();
 
-  rewind(treeFile);
+  rewindTreeReader(treeFile);
   
   if(bestTree)
-    rewind(bestTree);
+    rewindTreeReader(bestTree);
 
   /* get bipartitions of bootstrap set */
-  for( i = 1; i <= tr->numberOfTrees; ++i)
-    {      
-      readBootstrapTree(tr, treeFile);     
-      
-      if( NOT commonStart)
-	commonStart = tr->start;
-      bCount = 0; 
-      bitVectorInitravSpecial(setBitVectors, commonStart->back, tr->mxtips, vectorLength, setHtable, (i - 1), BIPARTITIONS_BOOTSTOP, (branchInfo *)NULL, &bCount, treeVectorLength, FALSE, FALSE);
+  if(chunks)
+    {
+      i = 0; 
+      FOR_0_LIMIT(j,numberOfChunks)
+	i += chunks[j].numberOfTrees; 
+      growSplitTreeVectors(splits, GET_BITVECTOR_LENGTH(i + 1));
+
+      for(i = 0, j = 0; j < numberOfChunks; ++j)
+	{
+	  mergeSplitHash(splits, chunks[j].splits, i);
+	  i += chunks[j].numberOfTrees; 
+	}
+      commonStart = tr->nodep[chunks[0].commonStartNumber];
     }
+  else 
+    for( i = 0; hasMoreTrees(treeFile); ++i)
+      {      
+	growTreeVectors(splits, i + 1);
+
+	readBootstrapTree(tr, treeFile);     
+      
+	if( NOT commonStart)
+	  commonStart = tr->start;
+	bCount = 0; 
+	bitVectorInitravSplits(setBitVectors, commonStart->back, tr->mxtips, vectorLength, splits, i, &bCount);
+      }
+
+  tr->numberOfTrees = i; 
+  assert(tr->numberOfTrees > 0);
+
+  growTreeVectors(splits, tr->numberOfTrees + 1);
   
   if(bestTree)
     {
       readBestTree(tr,bestTree);      
       
       bCount = 0;
-      bitVectorInitravSpecial(setBitVectors, commonStart->back, tr->mxtips, vectorLength, setHtable, tr->numberOfTrees, BIPARTITIONS_BOOTSTOP, (branchInfo *)NULL, &bCount, treeVectorLength, FALSE, FALSE);
+      bitVectorInitravSplits(setBitVectors, commonStart->back, tr->mxtips, vectorLength, splits, tr->numberOfTrees, &bCount);
       assert(bCount == tr->mxtips - 3);
     }
-  
-  result->commonAttributes = CALLOC(1,sizeof(ProfileElemAttr));
-  ((ProfileElemAttr*)result->commonAttributes)->bitVectorLength = vectorLength;
-  ((ProfileElemAttr*)result->commonAttributes)->treeVectorLength = treeVectorLength;
-  ((ProfileElemAttr*)result->commonAttributes)->lastByte = lastByte;
-  ((ProfileElemAttr*)result->commonAttributes)->randForTaxa = randForTaxa;
-  result->length = setHtable->entryCount;
-  result->arrayTable = CALLOC(result->length, sizeof(ProfileElem*));
-  
-  j = 0; 
-  for(i = 0; i < setHtable->tableSize; ++i)
-    {
-      entry
-	*elem = setHtable->table[i];
-      
-      while(elem)
-	{
-	  ((ProfileElem**)result->arrayTable)[j] = addProfileElem(elem, vectorLength, treeVectorLength, tr->numberOfTrees);
-	  j++;
-	  elem = elem->next;
-	}      
-    }
-  assert(j == setHtable->entryCount);
+
+  /* the profile is ordered as the hash table used to be */
+  result = splitHashToProfile(splits, tr->numberOfTrees, getHashTableSize(tr->mxtips * FC_INIT * 10));
+
+  attr = result->commonAttributes; 
+  attr->lastByte = lastByte;
+  attr->randForTaxa = randForTaxa;
+  attr->commonStartNumber = commonStart->number;
   
   int cnt= 0; 
   for(i = 0; i < result->length; ++i)
@@ -185,10 +302,8 @@ Array *getOriginalBipArray(All *tr, FILE *bestTree, FILE *treeFile)
   if(bestTree)
     assert(cnt == tr->mxtips - 3);
 
-  freeHashTable(setHtable);
   freeBitVectors(setBitVectors, 2 * tr->mxtips);
   free(setBitVectors);
-  free(setHtable);
   free(randForTaxa);
 
   /* TEST */
@@ -37,9 +37,22 @@
 #include "Tree.h"
 #include "ProfileElem.h"
 
+/* a consecutive part of the bootstrap trees that is read independently */
+typedef struct
+{
+  TreeReader reader; 
+  All *tr; 
+  SplitHash *splits; 
+  int numberOfTrees; 
+  int commonStartNumber; 
+} TreeChunk; 
+
 IndexList *parseToDrop(All *tr, FILE *toDrop);
 void pruneTaxon(All *tr, unsigned int k, boolean considerBranchLengths) ;
 BitVector *neglectThoseTaxa(All *tr, char *toDrop);
-Array *getOriginalBipArray(All *tr, FILE *bestTree, FILE *treeFile) ;
+Array *getOriginalBipArray(All *tr, TreeReader *bestTree, TreeReader *treeFile, TreeChunk *chunks, int numberOfChunks) ;
+TreeChunk *splitIntoTreeChunks(All *tr, TreeReader *treeFile, int numberOfChunks);
+void extractBipartitionsOfChunk(TreeChunk *chunk);
+void freeTreeChunks(TreeChunk *chunks, int numberOfChunks);
 
 #endif
@@ -30,18 +30,37 @@
 
 #ifdef PARALLEL
 #include <stdio.h>
+#include <limits.h>
 #include <pthread.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 #include "common.h"
 #include "ProfileElem.h"
 #include "Dropset.h"
+#include "Arena.h"
+#include "EventLog.h"
 #include "parallel.h"
-
-
-void findCandidatesForBip(HashTable *mergingHash, ProfileElem *elemA, boolean firstMerge, Array *bipartitionsById, Array *bipartitionProfile, int* indexByNumberBits); 
-void combineEventsForOneDropset(Array *allDropsets, Dropset *refDropset, Array *bipartitionsById);
+#include "Scheduler.h"
+
+
+void findCandidatesForBip(HashTable *mergingHash, ProfileElem *elemA, boolean firstMerge, Array *bipartitionsById, Array *bipartitionProfile, int* indexByNumberBits, int tid); 
+void insertLoggedEvents(HashTable *mergingHash, int partition);
+boolean unifyOneBipartition(ProfileElem *elem, int remainingTaxa);
+boolean cleanup_updateOneSplit(ProfileElem *elem, BitVector *mergingBipartitions, BitVector *newCandidates, Dropset *dropset);
+void cleanup_eventsOfDropset(Dropset *dropset, BitVector *mergingBipartitions);
+void prepareDropsetForSelection(Array *allDropsets, int position, Array *bipartitionsById);
+char cleanup_rehashActionOfDropset(Dropset *dropset, Dropset *bestDropset);
+boolean dropsetIsBetter(Dropset *dropsetA, Dropset *dropsetB);
+void combineEventsForOneDropset(HashTable *mergingHash, Dropset *refDropset, Array *bipartitionsById, Arena *arena, Arena *scratch);
 int getSupportOfMRETree(Array *bipartitionsById,  Dropset *dropset);
 void evaluateDropset(HashTable *mergingHash, Dropset *dropset,Array *bipartitionsById, List *consensusBipsCanVanish );
 extern int cumScore; 
+extern Arena **roundArenas; 
+extern Arena **scratchArenas; 
+extern EventLogSet *eventLogs; 
 
 #ifndef PORTABLE_PTHREADS
 void pinToCore(int tid)
@@ -62,9 +81,88 @@ void pinToCore(int tid)
 #endif
 
 
+#define SPIN_ITERATIONS 4096
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_RELAX() __builtin_ia32_pause()
+#else 
+#define CPU_RELAX() 
+#endif
+#define ATOMIC_LOAD(x) __atomic_load_n((x), __ATOMIC_SEQ_CST)
+#define ATOMIC_STORE(x,v) __atomic_store_n((x), (v), __ATOMIC_SEQ_CST)
+
+/* incremented by the master, whenever there is a new job */
+static int jobGeneration; 
+static int threadJob; 
+static int threadsDone; 
+static int sleepingWorkers; 
+static int masterSleeping; 
+
+static pthread_t *threads = NULL; 
+static threadData *threadArguments = NULL; 
+
+#ifdef __linux__
+static void sleepOn(int *address, int value)
+{
+  syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void wakeAll(int *address)
+{
+  syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#else
+static pthread_mutex_t sleepMutex = PTHREAD_MUTEX_INITIALIZER; 
+static pthread_cond_t sleepCondition = PTHREAD_COND_INITIALIZER; 
+
+static void sleepOn(int *address, int value)
+{
+  pthread_mutex_lock(&sleepMutex);
+  while(ATOMIC_LOAD(address) == value)
+    pthread_cond_wait(&sleepCondition, &sleepMutex);
+  pthread_mutex_unlock(&sleepMutex);
+}
+
+static void wakeAll(int *address)
+{
+  pthread_mutex_lock(&sleepMutex);
+  pthread_cond_broadcast(&sleepCondition);
+  pthread_mutex_unlock(&sleepMutex);
+}
+#endif
+
+
+/* 
+   spins for a while until *address changes, then goes to sleep. The
+   sleeper is registered in sleepers, such that the waker can skip
+   the system call, if nobody sleeps. Returns the new value.
+*/
+static int waitWhileEqual(int *address, int value, int *sleepers)
+{
+  int 
+    i, 
+    current; 
+
+  FOR_0_LIMIT(i,SPIN_ITERATIONS)
+    {
+      if((current = ATOMIC_LOAD(address)) != value)
+	return current; 
+      CPU_RELAX();
+    }
+
+  while((current = ATOMIC_LOAD(address)) == value)
+    {
+      __atomic_add_fetch(sleepers, 1, __ATOMIC_SEQ_CST);
+      sleepOn(address, value);
+      __atomic_sub_fetch(sleepers, 1, __ATOMIC_SEQ_CST);
+    }
+
+  return current; 
+}
+
+
 void execFunction(parallelArguments *pArgs, int tid, int n)
 {
-  int currentJob = threadJob >> 16;
+  int currentJob = ATOMIC_LOAD(&threadJob);
 
   switch(currentJob)
     {
@@ -76,96 +174,119 @@ void execFunction(parallelArguments *pArgs, int tid, int n)
 	Array *bipartitionProfile = pArgs->bipartitionProfile; 
 	int *indexByNumberBits = pArgs->indexByNumberBits; 	
 	boolean firstMerge = pArgs->firstMerge ; 
-	
+	int begin, end, jobId; 
 
-	boolean done = FALSE ;
-	while (NOT done ) 
+	while(getJobRange(tid, &begin, &end))
 	  {
-	    int jobId = bipartitionProfile->length; 
-	    ProfileElem *jobElem = NULL ; 
-	    pthread_mutex_lock(&mutex);
-	    do
-	      {	
-		jobId = bipartitionProfile->length - numberOfJobs; 
-		numberOfJobs--; 				
-	      }
-	    while(numberOfJobs > 0 && NOT NTH_BIT_IS_SET(candidateBips, jobId));
-	    done = (numberOfJobs <= 0);
-	    pthread_mutex_unlock(&mutex);
-	    
-	    if( bipartitionProfile->length > jobId &&  (jobElem = GET_PROFILE_ELEM(bipartitionsById, jobId)) ) 
+	    startLogSegment(eventLogs, tid, begin);
+	    for(jobId = begin; jobId < end; ++jobId)
 	      {
-		assert(jobElem);
-		findCandidatesForBip(mergingHash, jobElem, firstMerge , bipartitionsById, bipartitionProfile, indexByNumberBits);
+		ProfileElem *jobElem = NULL ; 
+		if(NTH_BIT_IS_SET(candidateBips, jobId) && (jobElem = GET_PROFILE_ELEM(bipartitionsById, jobId)) ) 
+		  findCandidatesForBip(mergingHash, jobElem, firstMerge , bipartitionsById, bipartitionProfile, indexByNumberBits, tid);
 	      }
-	  }	  
+	  }
 	break;
       }
+    case THREAD_INSERT_EVENTS:
+      /* every thread owns one partition of the hash slots */
+      insertLoggedEvents(globalPArgs->mergingHash, tid);
+      break;
     case THREAD_COMBINE_EVENTS:
       {
 	Array *allDropsets = globalPArgs->allDropsets; 
 	Array *bipartitionsById = globalPArgs->bipartitionsById; 
-	int jobId = allDropsets->length; 
+	HashTable *mergingHash = globalPArgs->mergingHash; 
+	int begin, end, jobId; 
 
-	boolean done = FALSE ;
-	while (NOT done ) 
-	  {
-	    pthread_mutex_lock(&mutex);
-	    jobId = allDropsets->length - numberOfJobs; 
-	    numberOfJobs--; 
-	    done = (numberOfJobs <= 0);
-	    pthread_mutex_unlock(&mutex);
-
-	    if( allDropsets->length > jobId )
-	      combineEventsForOneDropset(allDropsets, GET_DROPSET_ELEM(allDropsets,jobId), bipartitionsById);
-	  }	  
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    combineEventsForOneDropset(mergingHash, GET_DROPSET_ELEM(allDropsets,jobId), bipartitionsById, roundArenas[tid], scratchArenas[tid]);
 	break;
       }
     case THREAD_MRE:
       {
 	Array *allDropsets = globalPArgs->allDropsets,
 	  *bipartitionsById = globalPArgs->bipartitionsById ;
-	int jobId = allDropsets->length; 	
-	
-	boolean done = FALSE ;
-	while (NOT done ) 
-	  {
-	    pthread_mutex_lock(&mutex);
-	    jobId = allDropsets->length - numberOfJobs; 
-	    numberOfJobs--; 
-	    done = (numberOfJobs <= 0);
-	    pthread_mutex_unlock(&mutex);
+	int begin, end, jobId; 
+	Dropset *best = NULL; 
+
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    {
+	      Dropset *dropset = GET_DROPSET_ELEM(allDropsets,jobId);
+	      int newSup  = getSupportOfMRETree(bipartitionsById, dropset);
+	      dropset->improvement = newSup - cumScore;  
+	      if(dropsetIsBetter(dropset, best))
+		best = dropset; 
+	    } 
+	globalPArgs->bestPerThread[tid] = best; 
+	break;
+      }
+    case THREAD_EVALUATE_EVENTS:
+      {
+	int begin, end, jobId; 
+
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    {         
+	      Dropset *dropset =  GET_DROPSET_ELEM(globalPArgs->allDropsets, jobId);    
+	      evaluateDropset(globalPArgs->mergingHash, dropset, globalPArgs->bipartitionsById, globalPArgs->consensusBipsCanVanish); 
+	    }
+	break;
+      }
+    case THREAD_UNIFY:
+      {
+	Array *bipartitionProfile = globalPArgs->bipartitionProfile; 
+	int begin, end, jobId; 
 
-	    if( allDropsets->length > jobId )	      
-	      {
-		Dropset *dropset = GET_DROPSET_ELEM(allDropsets,jobId);
-		int newSup  = getSupportOfMRETree(bipartitionsById, dropset);
-		dropset->improvement = newSup - cumScore;  
-	      } 
-	  }
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    globalPArgs->splitFlags[jobId] = unifyOneBipartition(GET_PROFILE_ELEM(bipartitionProfile, jobId), globalPArgs->remainingTaxa);
+	break;
+      }
+    case THREAD_UPDATE_SPLITS:
+      {
+	Array *bipartitionProfile = globalPArgs->bipartitionProfile; 
+	int begin, end, jobId; 
 
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    globalPArgs->splitFlags[jobId] = cleanup_updateOneSplit(GET_PROFILE_ELEM(bipartitionProfile, jobId), 
+								    globalPArgs->mergingBipartitions, globalPArgs->newCandidates, globalPArgs->bestDropset);
 	break;
       }
-    case THREAD_EVALUATE_EVENTS:
+    case THREAD_CLEANUP_EVENTS:
       {
-       boolean done = FALSE; 
-       int jobId = globalPArgs->allDropsets->length; 
-       while (NOT done ) 
-         {
-           pthread_mutex_lock(&mutex);
-           jobId = globalPArgs->allDropsets->length - numberOfJobs; 
-           numberOfJobs--; 
-           done = (numberOfJobs <= 0);
-           pthread_mutex_unlock(&mutex);
-
-           if(globalPArgs->allDropsets->length > jobId)
-             {         
-               Dropset *dropset =  GET_DROPSET_ELEM(globalPArgs->allDropsets, jobId);    
-               evaluateDropset(globalPArgs->mergingHash, dropset, globalPArgs->bipartitionsById, globalPArgs->consensusBipsCanVanish); 
-             }
-         } 
-       break;
+	int begin, end, jobId; 
+
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    cleanup_eventsOfDropset(GET_DROPSET_ELEM(globalPArgs->allDropsets, jobId), globalPArgs->mergingBipartitions);
+	break;
+      }
+    case THREAD_PREPARE_SELECTION:
+      {
+	int begin, end, jobId; 
+
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    prepareDropsetForSelection(globalPArgs->allDropsets, jobId, globalPArgs->bipartitionsById);
+	break;
       }
+    case THREAD_REHASH_DROPSETS:
+      {
+	int begin, end, jobId; 
+
+	while(getJobRange(tid, &begin, &end))
+	  for(jobId = begin; jobId < end; ++jobId)
+	    globalPArgs->dropsetFlags[jobId] = cleanup_rehashActionOfDropset(GET_DROPSET_ELEM(globalPArgs->allDropsets, jobId), globalPArgs->bestDropset);
+	break;
+      }
+    case THREAD_PARSE_TREES:
+      /* there is exactly one chunk of trees per thread */
+      extractBipartitionsOfChunk(globalPArgs->treeChunks + tid);
+      break;
 
     default:
 	printf("Job %d\n", currentJob);
@@ -180,7 +301,10 @@ void *workerThreadWait(void *tData)
   parallelArguments
     *pArgs = td->pArgs;
   int
-    myCycle = 0;
+    myGeneration = 0,
+    jobType;
+  double
+    startTime; 
 
   const int 
     n = numberOfThreads,
@@ -192,14 +316,20 @@ void *workerThreadWait(void *tData)
  
   printf("This is worker thread number: %d\n", tid);
 
-  while(1)
+  while(TRUE)
     {
-      while (myCycle == threadJob) 
-	;
-      myCycle = threadJob;
+      myGeneration = waitWhileEqual(&jobGeneration, myGeneration, &sleepingWorkers); 
+      jobType = ATOMIC_LOAD(&threadJob); 
+      if(jobType == THREAD_EXIT)
+	break; 
+
+      startTime = gettime(); 
       execFunction(pArgs, tid, n);   
-      barrierBuffer[tid] = 1; 
-      
+      recordBusyTime(tid, gettime() - startTime); 
+
+      if(__atomic_add_fetch(&threadsDone, 1, __ATOMIC_SEQ_CST) == n - 1 
+	 && ATOMIC_LOAD(&masterSleeping))
+	wakeAll(&threadsDone);
     }
 
   return (void*)NULL;
@@ -208,14 +338,13 @@ void *workerThreadWait(void *tData)
 
 void startThreads()
 {
-
-  pthread_t *threads;
-  pthread_attr_t attr;
   int rc, t;
-  threadData *tData;
 
-  jobCycle        = 0;
-  threadJob       = 0;
+  threadJob = 0;
+  jobGeneration = 0; 
+  threadsDone = 0; 
+  sleepingWorkers = 0; 
+  masterSleeping = 0; 
 
 #ifndef PORTABLE_PTHREADS
   pinToCore(0);
@@ -223,22 +352,15 @@ void startThreads()
 
   printf("\nThis is the master thread\n");
 
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-
-  pthread_mutex_init(&mutex , (pthread_mutexattr_t *)NULL);
+  initializeScheduler(numberOfThreads);
   threads = (pthread_t *)CALLOC(numberOfThreads , sizeof(pthread_t));
-  tData = (threadData *)CALLOC(numberOfThreads , sizeof(threadData));  
-  barrierBuffer = (volatile char *)CALLOC(numberOfThreads, sizeof(volatile char));
-  
-  for(t = 0; t < numberOfThreads; t++)
-    barrierBuffer[t] = 0;
+  threadArguments = (threadData *)CALLOC(numberOfThreads , sizeof(threadData));  
  
   for(t = 1; t < numberOfThreads; t++)
     {
-      tData[t].pArgs  = globalPArgs;
-      tData[t].threadNumber = t;
-      rc = pthread_create(&threads[t], &attr, workerThreadWait, (void *)(&tData[t]));
+      threadArguments[t].pArgs  = globalPArgs;
+      threadArguments[t].threadNumber = t;
+      rc = pthread_create(&threads[t], NULL, workerThreadWait, (void *)(&threadArguments[t]));
       if(rc)
 	{
 	  printf("ERROR; return code from pthread_create() is %d\n", rc);
@@ -248,29 +370,54 @@ void startThreads()
 }
 
 
+/* wakes up the workers and lets them execute the job */ 
+static void releaseWorkers(int jobType)
+{
+  ATOMIC_STORE(&threadsDone, 0); 
+  ATOMIC_STORE(&threadJob, jobType); 
+  __atomic_add_fetch(&jobGeneration, 1, __ATOMIC_SEQ_CST); 
+  if(ATOMIC_LOAD(&sleepingWorkers) > 0)
+    wakeAll(&jobGeneration);
+}
+
+
 void masterBarrier(int jobType, parallelArguments *pArgs)
 {
   const int 
     n = numberOfThreads;
-  
   int 
-    i, 
-    sum;
+    done = 0;
+  double 
+    startTime = gettime(); 
 
-  jobCycle = NOT jobCycle;
-  threadJob = (jobType << 16) + jobCycle;
+  releaseWorkers(jobType);
 
   execFunction(pArgs, 0, n);
- 
-  do
-    {
-      for(i = 1, sum = 1; i < n; i++)
-	sum += barrierBuffer[i];
-    }
-  while(sum < n);  
+  recordBusyTime(0, gettime() - startTime); 
+
+  while((done = ATOMIC_LOAD(&threadsDone)) < n - 1)
+    waitWhileEqual(&threadsDone, done, &masterSleeping); 
+
+  finishPhase(jobType);
+}
+
+
+/* terminates and joins all workers */
+void stopThreads()
+{
+  int 
+    t; 
+
+  releaseWorkers(THREAD_EXIT); 
+
+  for(t = 1; t < numberOfThreads; t++)
+    pthread_join(threads[t], NULL);
 
-  for(i = 1; i < n; i++)
-    barrierBuffer[i] = 0;
+  free(threads);
+  free(threadArguments);
+  threads = NULL; 
+  threadArguments = NULL; 
+  freeScheduler(); 
 }
 #else
 #endif
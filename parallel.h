@@ -31,19 +31,24 @@
 #ifndef PARALLEL_H
 #define PARALLEL_H
 #include "HashTable.h"
+#include "newFunctions.h"
+#include "Dropset.h"
 
 
 extern volatile int numberOfThreads; 
-extern volatile int numberOfJobs;
-extern volatile int jobCycle;
-extern volatile int threadJob;
-extern volatile char *barrierBuffer;
-extern  pthread_mutex_t mutex;
 
 #define THREAD_GET_EVENTS 1 
 #define THREAD_COMBINE_EVENTS 2 
 #define THREAD_MRE 3 
 #define THREAD_EVALUATE_EVENTS 4
+#define THREAD_PARSE_TREES 5
+#define THREAD_INSERT_EVENTS 6
+#define THREAD_UNIFY 7
+#define THREAD_UPDATE_SPLITS 8
+#define THREAD_CLEANUP_EVENTS 9
+#define THREAD_PREPARE_SELECTION 10
+#define THREAD_REHASH_DROPSETS 11
+#define THREAD_EXIT 12
 
 typedef struct _parArgs 
 {
@@ -55,6 +60,14 @@ typedef struct _parArgs
   boolean firstMerge; 
   Array *allDropsets;   
   List *consensusBipsCanVanish;
+  TreeChunk *treeChunks; 
+  int remainingTaxa; 
+  char *splitFlags;		/* one per element of the profile */
+  char *dropsetFlags;		/* one per element of allDropsets */
+  BitVector *mergingBipartitions; 
+  BitVector *newCandidates; 
+  Dropset *bestDropset; 
+  Dropset **bestPerThread; 
 } parallelArguments ; 
 
 
@@ -69,6 +82,7 @@ typedef struct
 
 void masterBarrier(int jobType, parallelArguments *pArgs);
 void startThreads();
+void stopThreads();
 void *workerThreadWait(void *tData);
 void execFunction(parallelArguments *pArgs, int tid, int n);
 
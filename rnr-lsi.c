@@ -37,6 +37,8 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
 
 #include "common.h"
 #include "sharedVariables.h"
@@ -54,12 +56,8 @@
 #define NTH_BIT_IS_SET(bitVector,n) (bitVector[(n) / MASK_LENGTH] & mask32[(n) % MASK_LENGTH])
 
 #define NUMBER_TO_PRUNE(x) ((x) / 2)
-#define SHORT_UNSIGNED_MAX 65535
 
 
-typedef unsigned short int smallNumber;
-extern void freeIndexList(IndexList *list);
-
 typedef struct _scorePerTaxon
 {
   int taxonId;
@@ -72,7 +70,48 @@ typedef struct _scorePerTaxon
   double taxonInstability;
 } ScorePerTaxon;
 
-void printQuadruples(All *tr, smallNumber ***quadruples)
+/* 
+   the quadruples of the focal taxon: for every taxon a and every pair
+   b < c, the number of trees, in which the focal taxon and a are
+   separated from b and c. All counters live in one flat array (taxon
+   major, upper triangle of pairs), whose counter width depends on the
+   number of trees.
+*/
+typedef struct
+{
+  int mxtips; 
+  int bytesPerCounter; 
+  size_t pairsPerTaxon; 
+  void *counts; 
+} QuadrupleTable; 
+
+/* assumes that b < c */
+#define PAIR_INDEX(n,b,c) ((size_t)(b) * (2 * (n) - (b) - 1) / 2 + (c) - (b) - 1)
+#define QUADRUPLE_INDEX(table,a,b,c) ((size_t)(a) * (table)->pairsPerTaxon + PAIR_INDEX((table)->mxtips,b,c))
+
+
+static unsigned int getQuadruple(QuadrupleTable *quadruples, int a, int b, int c)
+{
+  size_t 
+    index; 
+
+  if(b > c)
+    SWAP(b,c);
+  index = QUADRUPLE_INDEX(quadruples, a, b, c); 
+
+  switch(quadruples->bytesPerCounter)
+    {
+    case 1: 
+      return ((uint8_t*)quadruples->counts)[index]; 
+    case 2: 
+      return ((uint16_t*)quadruples->counts)[index]; 
+    default: 
+      return ((uint32_t*)quadruples->counts)[index]; 
+    }
+}
+
+
+void printQuadruples(All *tr, QuadrupleTable *quadruples)
 {
   int
     i,j,k;
@@ -81,111 +120,226 @@ void printQuadruples(All *tr, smallNumber ***quadruples)
     {
       for(j = 0; j < tr->mxtips; ++j)
 	{
-	  for(k = 0; k < tr->mxtips; ++k)
+	  for(k = j + 1; k < tr->mxtips; ++k)
 	    {
-	      if(quadruples[i][j][k])
-		printf("%s|%s,%s\t%d\n", tr->nameList[i+1], tr->nameList[j+1], tr->nameList[k+1], quadruples[i][j][k]);
+	      if(getQuadruple(quadruples,i,j,k))
+		printf("%s|%s,%s\t%u\n", tr->nameList[i+1], tr->nameList[j+1], tr->nameList[k+1], getQuadruple(quadruples,i,j,k));
 	    }
 	}
     }
 }
 
 
-IndexList *extractQuadruplesRecursively(All *tr, nodeptr node, smallNumber ***quadruples, BitVector *neglectThose, boolean isStart) 
+/* 
+   every tree is parsed only once and kept as the array of the parents
+   of its nodes, when rooted at the first taxon
+*/
+typedef struct
 {
-  IndexList 
-    *leftList, *rightList, *iterA, *iterB, *iterC;
+  int numberOfNodes;		/* node numbers start with 1 */
+  int numberOfTrees; 
+  int *parents;			/* numberOfNodes + 1 per tree */
+} ParsedTrees; 
 
-  if( NOT isTip(node->number, tr->mxtips) || isStart)
-    {
-      nodeptr 
-	leftNode = (isStart) ? node->back->next->back : node->next->back, 
-	rightNode = (isStart) ? node->back->next->next->back : node->next->next->back;
+/* the unrooted tree, that is currently evaluated */
+typedef struct 
+{
+  int *neighbours;		/* 3 per node */
+  int *degree; 
+  int *leaves; 			/* the leaves below a node form a range */
+  int numberOfLeaves; 
+} TreeScratch; 
 
-      leftList = extractQuadruplesRecursively(tr, leftNode,  quadruples, neglectThose, FALSE);
-      rightList = extractQuadruplesRecursively(tr, rightNode, quadruples, neglectThose,FALSE);
-    }
-  else 
+
+static void storeParentsRecursively(nodeptr p, int *parents, int mxtips)
+{
+  parents[p->number] = p->back->number; 
+  
+  if( NOT isTip(p->number, mxtips))
     {
-      IndexList
-	*elem = CALLOC(1,sizeof(IndexList)); 
-      elem->index = node->number;
-      elem->next = NULL;
-      return elem;
+      storeParentsRecursively(p->next->back, parents, mxtips);
+      storeParentsRecursively(p->next->next->back, parents, mxtips);
     }
+}
 
-  /* insert the information */
-  for(iterA = leftList; iterA; iterA = iterA->next)
-    {
-      for(iterB = rightList; iterB; iterB = iterB->next)
-	{
-	  for(iterC = iterB->next; iterC; iterC = iterC->next)
-	    {
-	      int 
-		indexB = iterB->index,
-		indexC = iterC->index;
 
-	      if(indexB > indexC)
-		SWAP(indexB,indexC);
+ParsedTrees *parseAllTrees(All *tr, TreeReader *bootstrapFile)
+{
+  ParsedTrees
+    *result = CALLOC(1,sizeof(ParsedTrees)); 
+  int
+    j; 
 
-	      USE_UPPER_TRIANGLE_LSI(quadruples, (iterA->index-1), (indexB-1), (indexC-1))++;
-	    }
-	}
-    }
+  result->numberOfNodes = 2 * tr->mxtips - 2; 
+  result->numberOfTrees = tr->numberOfTrees; 
+  result->parents = CALLOC((size_t)tr->numberOfTrees * (result->numberOfNodes + 1), sizeof(int)); 
 
-  for(iterA = rightList; iterA; iterA = iterA->next)
+  rewindTreeReader(bootstrapFile);
+  FOR_0_LIMIT(j,tr->numberOfTrees)
     {
-      for(iterB = leftList; iterB; iterB = iterB->next)
-	{
-	  for(iterC = iterB->next; iterC; iterC = iterC->next)
-	    {
-	      int
-		indexB = iterB->index,
-		indexC = iterC->index;
-	      
-	      if(indexB > indexC)
-		SWAP(indexB,indexC);
-	      
-	      USE_UPPER_TRIANGLE_LSI(quadruples, (iterA->index-1), (indexB-1), (indexC-1))++;
-	    }
-	}
+      int 
+	*parents = result->parents + (size_t)j * (result->numberOfNodes + 1); 
+      
+      readBootstrapTree(tr,bootstrapFile);
+      assert(tr->nextnode - 1 <= result->numberOfNodes);
+      storeParentsRecursively(tr->nodep[1]->back, parents, tr->mxtips);
+      parents[1] = 0; 
     }
 
-  for(iterA = leftList; iterA; iterA = iterA->next)
-    if( NOT iterA->next)
+  return result; 
+}
+
+
+void freeParsedTrees(ParsedTrees *trees)
+{
+  free(trees->parents);
+  free(trees);
+}
+
+
+static void restoreTree(TreeScratch *scratch, int *parents, int numberOfNodes)
+{
+  int 
+    v; 
+
+  memset(scratch->degree, 0, (numberOfNodes + 1) * sizeof(int));
+  for(v = 1; v <= numberOfNodes; ++v)
+    if(parents[v])
       {
-	iterA->next = rightList; 
-	break;
+	int 
+	  u = parents[v]; 
+	scratch->neighbours[3 * v + scratch->degree[v]++] = u; 
+	scratch->neighbours[3 * u + scratch->degree[u]++] = v; 
       }
+  scratch->numberOfLeaves = 0; 
+}
+
 
-  return leftList;
+/* 
+   a node splits the leaves below it into left and right. For every
+   leaf a on one side and every pair b,c on the other side, the focal
+   taxon and a are separated from b and c.
+*/
+#define COUNT_QUADRUPLES_OF_SIDE(TYPE)					\
+  {									\
+    TYPE								\
+      *counts = (TYPE*)quadruples->counts;				\
+									\
+    for(a = aBegin; a < aEnd; ++a)					\
+      {									\
+	TYPE								\
+	  *countsOfA = counts + (size_t)leaves[a] * quadruples->pairsPerTaxon; \
+									\
+	for(b = pairBegin; b < pairEnd; ++b)				\
+	  for(c = b + 1; c < pairEnd; ++c)				\
+	    {								\
+	      int							\
+		indexB = leaves[b],					\
+		indexC = leaves[c];					\
+									\
+	      if(indexB > indexC)					\
+		SWAP(indexB,indexC);					\
+									\
+	      countsOfA[PAIR_INDEX(n, indexB, indexC)]++;		\
+	    }								\
+      }									\
+  }
+
+static void countQuadruplesOfSide(QuadrupleTable *quadruples, int *leaves, int aBegin, int aEnd, int pairBegin, int pairEnd)
+{
+  int 
+    a, b, c,
+    n = quadruples->mxtips; 
+
+  switch(quadruples->bytesPerCounter)
+    {
+    case 1: 
+      COUNT_QUADRUPLES_OF_SIDE(uint8_t); 
+      break; 
+    case 2: 
+      COUNT_QUADRUPLES_OF_SIDE(uint16_t); 
+      break; 
+    default: 
+      COUNT_QUADRUPLES_OF_SIDE(uint32_t); 
+    }
 }
 
-void freeQuads(All *tr, smallNumber ***quads)
+
+static void countQuadruplesOfNode(QuadrupleTable *quadruples, int *leaves, int begin, int middle, int end)
 {
-  int i,j;
-  for(i = 0; i < tr->mxtips; ++i)
+  countQuadruplesOfSide(quadruples, leaves, begin, middle, middle, end);
+  countQuadruplesOfSide(quadruples, leaves, middle, end, begin, middle);
+}
+
+
+/* 
+   visits the subtree of node, when coming from node from. Excluded
+   taxa are skipped, which yields the same counts as pruning them.
+*/
+static void extractQuadruplesRecursively(TreeScratch *scratch, int node, int from, QuadrupleTable *quadruples, BitVector *neglectThose, int mxtips)
+{
+  int 
+    i,
+    begin, 
+    middle, 
+    numberOfChildren = 0,
+    children[2]; 
+
+  if(isTip(node, mxtips))
     {
-      for(j = 0; j < tr->mxtips; ++j)
-	free(quads[i][j]);
-      free(quads[i]);
+      if(NTH_BIT_IS_SET(neglectThose, node - 1))
+	scratch->leaves[scratch->numberOfLeaves++] = node - 1; 
+      return; 
     }
+
+  FOR_0_LIMIT(i,scratch->degree[node])
+    if(scratch->neighbours[3 * node + i] != from)
+      children[numberOfChildren++] = scratch->neighbours[3 * node + i]; 
+  assert(numberOfChildren == 2);
+
+  begin = scratch->numberOfLeaves; 
+  extractQuadruplesRecursively(scratch, children[0], node, quadruples, neglectThose, mxtips);
+  middle = scratch->numberOfLeaves; 
+  extractQuadruplesRecursively(scratch, children[1], node, quadruples, neglectThose, mxtips);
+
+  countQuadruplesOfNode(quadruples, scratch->leaves, begin, middle, scratch->numberOfLeaves);
+}
+
+
+void freeQuads(QuadrupleTable *quads)
+{
+  free(quads->counts);
   free(quads);
 }
 
 
-smallNumber ***initQuads(All *tr) 
+void clearQuads(QuadrupleTable *quads)
 {
-  int i, j; 
-  smallNumber ***result =  CALLOC(tr->mxtips, sizeof(smallNumber**)); 
+  memset(quads->counts, 0, (size_t)quads->mxtips * quads->pairsPerTaxon * quads->bytesPerCounter);
+}
 
 
-  for(i = 0; i < tr->mxtips; ++i)
+/* a counter never exceeds the number of trees */
+QuadrupleTable *initQuads(All *tr) 
+{
+  QuadrupleTable
+    *result = CALLOC(1, sizeof(QuadrupleTable));
+
+  result->mxtips = tr->mxtips; 
+  result->pairsPerTaxon = (size_t)tr->mxtips * (tr->mxtips - 1) / 2; 
+  if(tr->numberOfTrees <= UINT8_MAX)
+    result->bytesPerCounter = 1; 
+  else if(tr->numberOfTrees <= UINT16_MAX)
+    result->bytesPerCounter = 2; 
+  else 
+    result->bytesPerCounter = 4; 
+
+  result->counts = CALLOC((size_t)tr->mxtips * result->pairsPerTaxon, result->bytesPerCounter);
+  if( NOT result->counts)
     {
-      result[i] = CALLOC(tr->mxtips, sizeof(smallNumber*));
-      for(j = 0 ; j < tr->mxtips; ++j)
-	result[i][j] = CALLOC(tr->mxtips - j, sizeof(smallNumber));
-    } 
+      printf("ERROR: could not allocate %zu bytes for the quadruples.\n", (size_t)tr->mxtips * result->pairsPerTaxon * result->bytesPerCounter);
+      exit(-1);
+    }
   
   return result;
 }
@@ -197,143 +351,232 @@ int intcmp(const void *a, const void *b)
 }
 
 
-void calculateLeafStability(All *tr, char *bootstrapFileName, char *excludeFileName)
-{  
-  FILE 
-    *outf = getOutputFileFromString("leafStabilityIndices"),
-    *bootstrapFile =  getNumberOfTrees(tr,bootstrapFileName);
- 
+typedef struct
+{
+  All *tr;
+  ParsedTrees *trees;
+  BitVector *neglectThose;
+  int nextTaxon;
+  boolean *isComputed;
+  double *lsDif;
+  double *lsEnt;
+  double *lsMax;
+} LeafStabilityJob;
+
+
+void computeLeafStabilityOfTaxon(LeafStabilityJob *job, int i, QuadrupleTable *quadruples, TreeScratch *scratch)
+{
+  All
+    *tr = job->tr;
+  ParsedTrees
+    *trees = job->trees;
   BitVector
-    *neglectThose = neglectThoseTaxa(tr, excludeFileName);
+    *neglectThose = job->neglectThose;
 
-  int 
-    i, j, k, l;
+  int
+    j, k, l;
+
+  double
+    lsDif = 0.0, 
+    lsEnt = 0.0,
+    lsMax = 0.0;
 
-  if(tr->numberOfTrees >= SHORT_UNSIGNED_MAX)
+  clearQuads(quadruples);
+  FOR_0_LIMIT(j,trees->numberOfTrees)
     {
-      PR("Sorry, %s is not  capable of handling more than %d trees. You may want to adjust the code, if you have sufficient memory at disposal.\n");
-      exit(-1);
+      restoreTree(scratch, trees->parents + (size_t)j * (trees->numberOfNodes + 1), trees->numberOfNodes);
+      assert(scratch->degree[i+1] == 1);
+      extractQuadruplesRecursively(scratch, scratch->neighbours[3 * (i+1)], i+1, quadruples, neglectThose, tr->mxtips);
     }
-
-  fprintf(outf,"taxon\tlsDif\tlsEnt\tlsMax\n");
-  PR("taxon\tlsDif\tlsEnt\tlsMax\n");
-
-  /* calculate leaf stability for n-th taxon */
-  for(i = 0; i < tr->mxtips; i++) 
-    { 
-      if( NOT NTH_BIT_IS_SET(neglectThose,i))
-	{
-	  PR("%s\tNA\tNA\tNA\n", tr->nameList[i+1]);
-	  fprintf(outf,"%s\tNA\tNA\tNA\n", tr->nameList[i+1]);
-	  continue;
-	}
-
-      smallNumber
-	***quadruples = initQuads(tr);
-
-      double
-	lsDif = 0.0, 
-	lsEnt = 0.0,
-	lsMax = 0.0;
-
-      rewind(bootstrapFile);
-      
-      for(j = 1; j <= tr->numberOfTrees; ++j)
-	{
-	  int k; 
-	  readBootstrapTree(tr,bootstrapFile);
-	  FOR_0_LIMIT(k,tr->mxtips)
-	    if( NOT NTH_BIT_IS_SET(neglectThose, k))
-	      pruneTaxon(tr,k+1, FALSE);
-	  extractQuadruplesRecursively(tr, tr->nodep[i+1], quadruples, neglectThose, TRUE);
-	}
  
-      /* calculate leaf stability of this leaf */
-      int
-	sum = 0;
-      double 
-	cnt = 0.0;
-      for(j = 0; j  < tr->mxtips; ++j)
+  /* calculate leaf stability of this leaf */
+  int
+    sum = 0;
+  double 
+    cnt = 0.0;
+  for(j = 0; j  < tr->mxtips; ++j)
+    {
+      if(NOT NTH_BIT_IS_SET(neglectThose, j))
+	continue;
+	  
+      for(k = j+1; k < tr->mxtips; ++k) 
 	{
-	  if(NOT NTH_BIT_IS_SET(neglectThose, j))
+	  if(NOT NTH_BIT_IS_SET(neglectThose, k))
 	    continue;
-	  
-	  for(k = j+1; k < tr->mxtips; ++k) 
+
+	  for(l = k+1; l < tr->mxtips; ++l) 
 	    {
-	      if(NOT NTH_BIT_IS_SET(neglectThose, k))
+	      if(NOT NTH_BIT_IS_SET(neglectThose, l))
 		continue;
 
-	      for(l = k+1; l < tr->mxtips; ++l) 
-		{
-		  if(NOT NTH_BIT_IS_SET(neglectThose, l))
-		    continue;
+	      int rels[3] = { 
 
-		  int rels[3] = { 
-
-		    GET_FROM_UPPER_TRIANGLE(quadruples,j,k,l),
-		    GET_FROM_UPPER_TRIANGLE(quadruples,k,j,l),
-		    GET_FROM_UPPER_TRIANGLE(quadruples,l,j,k)
-		  };
+		getQuadruple(quadruples,j,k,l),
+		getQuadruple(quadruples,k,j,l),
+		getQuadruple(quadruples,l,j,k)
+	      };
 		  
-		  sum = rels[0] + rels[1] + rels[2];
+	      sum = rels[0] + rels[1] + rels[2];
 
-		  qsort(rels, 3, sizeof(int), intcmp);
+	      qsort(rels, 3, sizeof(int), intcmp);
 
-		  assert( sum == 0  || sum == tr->numberOfTrees);		  
-		  assert(rels[0] >= 0 && rels[1] >= 0 && rels[0] >= rels[1]);
-		  assert(   (NTH_BIT_IS_SET(neglectThose, j) &&  NTH_BIT_IS_SET(neglectThose, k) && NTH_BIT_IS_SET(neglectThose, l) && NTH_BIT_IS_SET(neglectThose, i)) );
+	      assert( sum == 0  || sum == tr->numberOfTrees);		  
+	      assert(rels[0] >= 0 && rels[1] >= 0 && rels[0] >= rels[1]);
+	      assert(   (NTH_BIT_IS_SET(neglectThose, j) &&  NTH_BIT_IS_SET(neglectThose, k) && NTH_BIT_IS_SET(neglectThose, l) && NTH_BIT_IS_SET(neglectThose, i)) );
 
-		  if(sum)
-		    {		  
-		      lsDif += (double)(rels[0] - rels[1]) / (double)tr->numberOfTrees;
-		      lsMax += (double) rels[0]    / (double)  tr->numberOfTrees ;
-		      /* PR(">> %f\n", ((double) rels[0]    / (double)  tr->numberOfTrees )); */
+	      if(sum)
+		{		  
+		  lsDif += (double)(rels[0] - rels[1]) / (double)tr->numberOfTrees;
+		  lsMax += (double) rels[0]    / (double)  tr->numberOfTrees ;
+		  /* PR(">> %f\n", ((double) rels[0]    / (double)  tr->numberOfTrees )); */
 		      
-		      double tmp = (double)rels[0] / (double)tr->numberOfTrees;
+		  double tmp = (double)rels[0] / (double)tr->numberOfTrees;
+		  lsEnt -= tmp * log(tmp);
+		  if(rels[1] > 0)
+		    {
+		      double tmp = (double) rels[1]  / (double) tr->numberOfTrees;
+		      lsEnt -= tmp * log(tmp);
+		    }
+		  if(rels[2] > 0)
+		    {
+		      double tmp = (double) rels[2] / (double) tr->numberOfTrees;
 		      lsEnt -= tmp * log(tmp);
-		      if(rels[1] > 0)
-			{
-			  double tmp = (double) rels[1]  / (double) tr->numberOfTrees;
-			  lsEnt -= tmp * log(tmp);
-			}
-		      if(rels[2] > 0)
-			{
-			  double tmp = (double) rels[2] / (double) tr->numberOfTrees;
-			  lsEnt -= tmp * log(tmp);
-			}
-		      cnt++;
 		    }
+		  cnt++;
 		}
 	    }
 	}
-      lsDif /= cnt;
+    }
+  lsDif /= cnt;
       
-      /* normalize between 0 and 1 */
-      lsEnt /= cnt;
-      lsEnt /= 3. * log(1./3.)  * 1./3.;
-      lsEnt = lsEnt + 1;
+  /* normalize between 0 and 1 */
+  lsEnt /= cnt;
+  lsEnt /= 3. * log(1./3.)  * 1./3.;
+  lsEnt = lsEnt + 1;
       
-      /* also normalize */
-      lsMax /= cnt  ;
-      lsMax = (lsMax - (1. / 3.)) * 3. / 2. ;
+  /* also normalize */
+  lsMax /= cnt  ;
+  lsMax = (lsMax - (1. / 3.)) * 3. / 2. ;
+
+  job->lsDif[i] = lsDif;
+  job->lsEnt[i] = lsEnt;
+  job->lsMax[i] = lsMax;
+  job->isComputed[i] = TRUE;
+}
+
+
+/* 
+   Every thread owns a private quadruple cube and tree scratch
+   space. Focal taxa are handed out one at a time, results are stored
+   per taxon and printed in order by the master thread.
+*/ 
+void *leafStabilityWorker(void *arg)
+{
+  LeafStabilityJob
+    *job = (LeafStabilityJob*)arg;
+  All
+    *tr = job->tr;
+  TreeScratch
+    scratch; 
+  QuadrupleTable
+    *quadruples = initQuads(tr);
+  int
+    i;
+
+  scratch.neighbours = CALLOC(3 * (job->trees->numberOfNodes + 1), sizeof(int));
+  scratch.degree = CALLOC(job->trees->numberOfNodes + 1, sizeof(int));
+  scratch.leaves = CALLOC(tr->mxtips, sizeof(int));
+
+  while((i = __sync_fetch_and_add(&(job->nextTaxon), 1)) < tr->mxtips)
+    if(NTH_BIT_IS_SET(job->neglectThose, i))
+      computeLeafStabilityOfTaxon(job, i, quadruples, &scratch);
+
+  freeQuads(quadruples);
+  free(scratch.neighbours);
+  free(scratch.degree);
+  free(scratch.leaves);
+
+  return NULL;
+}
+
+
+void calculateLeafStability(All *tr, char *bootstrapFileName, char *excludeFileName, int numberOfThreads)
+{  
+  FILE 
+    *outf = getOutputFileFromString("leafStabilityIndices");
+
+  TreeReader
+    *bootstrapFile =  getNumberOfTrees(tr,bootstrapFileName);
+ 
+  BitVector
+    *neglectThose = neglectThoseTaxa(tr, excludeFileName);
+
+  int 
+    i;
+
+  LeafStabilityJob
+    job; 
+
+  pthread_t
+    *threads; 
+
+  job.tr = tr;
+  job.trees = parseAllTrees(tr, bootstrapFile);
+  job.neglectThose = neglectThose;
+  job.nextTaxon = 0;
+  job.isComputed = CALLOC(tr->mxtips, sizeof(boolean));
+  job.lsDif = CALLOC(tr->mxtips, sizeof(double));
+  job.lsEnt = CALLOC(tr->mxtips, sizeof(double));
+  job.lsMax = CALLOC(tr->mxtips, sizeof(double));
+
+  /* calculate leaf stability for each taxon, the master works as well */
+  threads = CALLOC(numberOfThreads, sizeof(pthread_t));
+  for(i = 1; i < numberOfThreads; ++i)
+    if(pthread_create(threads + i, NULL, leafStabilityWorker, &job))
+      {
+	printf("ERROR: could not create thread %d\n", i);
+	exit(-1);
+      }
+  leafStabilityWorker(&job);
+  for(i = 1; i < numberOfThreads; ++i)
+    pthread_join(threads[i], NULL);
+  free(threads);
+
+  fprintf(outf,"taxon\tlsDif\tlsEnt\tlsMax\n");
+  PR("taxon\tlsDif\tlsEnt\tlsMax\n");
+  FOR_0_LIMIT(i, tr->mxtips)
+    {
+      if(NOT job.isComputed[i])
+	{
+	  PR("%s\tNA\tNA\tNA\n", tr->nameList[i+1]);
+	  fprintf(outf,"%s\tNA\tNA\tNA\n", tr->nameList[i+1]);
+	  continue;
+	}
       
-      PR("%s\t%f\t%f\t%f\n", tr->nameList[i+1], lsDif, lsEnt, lsMax);
-      fprintf(outf, "%s\t%f\t%f\t%f\n", tr->nameList[i+1], lsDif, lsEnt, lsMax);
-      freeQuads(tr,quadruples);
+      PR("%s\t%f\t%f\t%f\n", tr->nameList[i+1], job.lsDif[i], job.lsEnt[i], job.lsMax[i]);
+      fprintf(outf, "%s\t%f\t%f\t%f\n", tr->nameList[i+1], job.lsDif[i], job.lsEnt[i], job.lsMax[i]);
     }
+
+  free(job.isComputed);
+  free(job.lsDif);
+  free(job.lsEnt);
+  free(job.lsMax);
+  freeParsedTrees(job.trees);
 }
 
 
 void printHelpFile()
 {
   printVersionInfo(FALSE);
-  printf("This program computes three flavors of leaf stability index for each taxon.\n\nSYNTAX: ./%s -i <bootTrees> -n <runId> [-w <workingDir>] [-h]\n", lowerTheString(programName));
+  printf("This program computes three flavors of leaf stability index for each taxon.\n\nSYNTAX: ./%s -i <bootTrees> -n <runId> [-w <workingDir>] [-T <num>] [-h]\n", lowerTheString(programName));
   printf("\n\tOBLIGATORY:\n");
   printf("-i <bootTrees>\n\tA collection of bootstrap trees.\n");
   printf("-n <runId>\n\tAn identifier for this run.\n");
   printf("\n\tOPTIONAL:\n");
   printf("-x <excludeFile>\n\tPrune the taxa in the file first (one taxon per line), before computing the lsi.\n");
   printf("-w <workDir>\n\tA working directory where output files are created.\n");
+  printf("-T <num>\n\tCompute the indices of different taxa in parallel with <num> threads. Each\n\t\
+thread needs its own quadruple table, so memory grows with <num>. DEFAULT: 1\n");
   printf("-h\n\tThis help file.\n");
 }
 
@@ -345,13 +588,14 @@ int main(int argc, char *argv[])
   programReleaseDate = PROG_RELEASE_DATE; 
 
   int
-    c;
+    c,
+    numberOfThreads = 1;
 
   char
     *excludeFile = "",
     *bootTrees = "";
 
-   while ((c = getopt (argc, argv, "hi:n:w:m:x:")) != -1)
+   while ((c = getopt (argc, argv, "hi:n:w:m:x:T:")) != -1)
     {
       switch(c)
 	{
@@ -368,6 +612,14 @@ int main(int argc, char *argv[])
 	case 'x':
 	  excludeFile = optarg;
 	  break;
+	case 'T':
+	  numberOfThreads = wrapStrToL(optarg);
+	  if(numberOfThreads < 1)
+	    {
+	      printf("Please specify a positive number of threads via -T.\n");
+	      exit(-1);
+	    }
+	  break;
 	case 'h':
 	default: 
 	  {
@@ -392,7 +644,6 @@ int main(int argc, char *argv[])
       exit(-1);
     }
 
-  compute_bits_in_16bits();
   initializeMask();
 
   All 
@@ -406,7 +657,7 @@ int main(int argc, char *argv[])
 
   tr->bitVectorLength = GET_BITVECTOR_LENGTH(tr->mxtips);
 
-  calculateLeafStability(tr, bootTrees, excludeFile); 
+  calculateLeafStability(tr, bootTrees, excludeFile, numberOfThreads); 
 
   return 0;
 }
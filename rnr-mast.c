@@ -187,7 +187,7 @@ void freeTriplesStructure(All *tr, BitVector ***triples)
 }
 
 
-BitVector*** getIntersectionOfRootedTriples(FILE *bootstrapFile, All *tr, int startingNodeIndex, BitVector *neglectThose)
+BitVector*** getIntersectionOfRootedTriples(TreeReader *bootstrapFile, All *tr, int startingNodeIndex, BitVector *neglectThose)
 {
   int 
     i,j,k,treeNum=0, 
@@ -200,7 +200,7 @@ BitVector*** getIntersectionOfRootedTriples(FILE *bootstrapFile, All *tr, int st
   for(i = 0; i < 2 * tr->mxtips - 1; ++i)
     bitVectors[i] = malloc(bitVectorLength * sizeof(BitVector)); 
 
-  rewind(bootstrapFile);
+  rewindTreeReader(bootstrapFile);
   
   while(treeNum++ < tr->numberOfTrees)
     {
@@ -270,9 +270,8 @@ IndexList* findBestXinAxB(All *tr, int A, int B, AgreementMatrix **agreementMatr
   while(i < tr->mxtips)
     {    
 #ifdef FAST_BV_COMPARISON
-      if( ((i & 31) == 0) && NOT currentBv[i]) /* NOTE portability issue!!! */
+      if( ((i % MASK_LENGTH) == 0) && NOT currentBv[i / MASK_LENGTH]) /* skip empty words */
       	{
-	  /* assert((i % 32) == i & (MASK_LENGTH - 1)); */
       	  i += MASK_LENGTH;
       	  continue;
       	}
@@ -292,9 +291,8 @@ IndexList* findBestXinAxB(All *tr, int A, int B, AgreementMatrix **agreementMatr
   while(i < tr->mxtips)
     {
 #ifdef FAST_BV_COMPARISON
-      if( ((i & 31) == 0) && NOT currentBv[i]) /* NOTE portability issue!!! */
+      if( ((i % MASK_LENGTH) == 0) && NOT currentBv[i / MASK_LENGTH]) /* skip empty words */
       	{
-	  /* assert((i % 32) == i & (MASK_LENGTH - 1)); */
       	  i += MASK_LENGTH;
       	  continue;
       	}
@@ -628,7 +626,7 @@ void printBipartition(All *tr, BitVector *bv, int contentLength)
 }
 
 
-void verifyMasts(All *tr, FILE *bootstrapFile, BitVector *taxaToKeep)
+void verifyMasts(All *tr, TreeReader *bootstrapFile, BitVector *taxaToKeep)
 {
   int
     bCount = 0,
@@ -642,7 +640,7 @@ void verifyMasts(All *tr, FILE *bootstrapFile, BitVector *taxaToKeep)
   entry *e;
   nodeptr commonStart = NULL;
   
-  rewind(bootstrapFile);  
+  rewindTreeReader(bootstrapFile);  
 
   for(i = 1; i <= tr->numberOfTrees; ++i)
     {
@@ -656,7 +654,7 @@ void verifyMasts(All *tr, FILE *bootstrapFile, BitVector *taxaToKeep)
       
       if(i == 1 )
 	commonStart = tr->start;
-      bitVectorInitravSpecial(bitVectors, commonStart->back, tr->mxtips, vectorLength, htable, (i - 1), BIPARTITIONS_BOOTSTOP, (branchInfo *)NULL, &bCount, treeVectorLength, FALSE, FALSE);
+      bitVectorInitravSpecial(bitVectors, commonStart->back, tr->mxtips, vectorLength, htable, (i - 1), BIPARTITIONS_BOOTSTOP, &bCount, treeVectorLength, FALSE, FALSE);
     }
 
   for(i = 0; i < htable->tableSize; ++i)
@@ -697,7 +695,7 @@ int countTips(nodeptr p, int numsp)
 }
 
 
-void printMastToFile(All *tr, FILE *bootstrapFile,  BitVector *mast, FILE *result)
+void printMastToFile(All *tr, TreeReader *bootstrapFile,  BitVector *mast, FILE *result)
 {
   int
     droppedTaxaNum = 0, 
@@ -706,7 +704,7 @@ void printMastToFile(All *tr, FILE *bootstrapFile,  BitVector *mast, FILE *resul
 #endif
     i;
 
-  rewind(bootstrapFile);  
+  rewindTreeReader(bootstrapFile);  
   readBootstrapTree(tr,bootstrapFile);
     
   for(i = 1; i <= tr->mxtips; ++i)
@@ -727,7 +725,7 @@ void printMastToFile(All *tr, FILE *bootstrapFile,  BitVector *mast, FILE *resul
 }
 
 
-void printMastsToFile(All *tr, FILE *bootstrapFile, List *masts)
+void printMastsToFile(All *tr, TreeReader *bootstrapFile, List *masts)
 {
   FILE
       *result = getOutputFileFromString("MaximumAgreementSubtree");
@@ -782,7 +780,7 @@ void calculateMast(char *bootStrapFileName, All *tr, char *excludeFileName, bool
     mast = 0,
     i,j,k;
 
-  FILE 
+  TreeReader 
     *bootstrapFile = getNumberOfTrees(tr, bootStrapFileName);
 
   BitVector
@@ -852,7 +850,7 @@ void calculateMast(char *bootStrapFileName, All *tr, char *excludeFileName, bool
 
   freeList(accMasts);
   freeAmatList(tr, amastList);
-  fclose(bootstrapFile);
+  closeTreeReader(bootstrapFile);
 }
 
 
@@ -951,7 +949,6 @@ int main(int argc, char *argv[])
 
 
   /* maybe? */
-  compute_bits_in_16bits();
   initializeMask();
 
 
@@ -77,8 +77,7 @@ void pruneTaxaFromTreeset(char *bootstrapFileName, char *bestTreeFile, char *toD
 	  PR("Something went wrong during tree initialisation. Sorry.\n");
 	  exit(-1);
 	}   
-      FILE *TMP = getNumberOfTrees(tr, bootstrapFileName);
-      fclose(TMP);
+      closeTreeReader(getNumberOfTrees(tr, bootstrapFileName));
     }
 
   /* drop taxa from best-known tree */
@@ -90,8 +89,7 @@ void pruneTaxaFromTreeset(char *bootstrapFileName, char *bestTreeFile, char *toD
 	  PR("Something went wrong during tree initialisation. Sorry.\n");
 	  exit(-1);
 	}   
-      FILE *tmp = getNumberOfTrees(tr, bestTreeFile);
-      fclose(tmp);
+      closeTreeReader(getNumberOfTrees(tr, bestTreeFile));
     }
 
   IndexList
@@ -99,8 +97,9 @@ void pruneTaxaFromTreeset(char *bootstrapFileName, char *bestTreeFile, char *toD
 
   if( strcmp(bootstrapFileName, ""))
     {   
+      TreeReader
+	*bootstrapFile = getNumberOfTrees(tr, bootstrapFileName);
       FILE
-	*bootstrapFile = getNumberOfTrees(tr, bootstrapFileName),
 	*outf = getOutputFileFromString("prunedBootstraps");
       
       FOR_0_LIMIT(i,tr->numberOfTrees)
@@ -116,12 +115,14 @@ void pruneTaxaFromTreeset(char *bootstrapFileName, char *bestTreeFile, char *toD
 	}  
   
       fclose(outf);
+      closeTreeReader(bootstrapFile);
     }
 
   if( strcmp(bestTreeFile, ""))
     {
-      FILE 
-	*bestTree = myfopen(bestTreeFile, "r"),
+      TreeReader 
+	*bestTree = openTreeReader(bestTreeFile);
+      FILE
 	*outf = getOutputFileFromString("prunedBestTree");
       
       readBestTree(tr, bestTree);
@@ -131,6 +132,7 @@ void pruneTaxaFromTreeset(char *bootstrapFileName, char *bestTreeFile, char *toD
       
       char *tmp = writeTreeToString(tr, TRUE); 
       fprintf(outf, "%s", tmp);	  
+      closeTreeReader(bestTree);
     }
   
   freeIndexList(indicesToDrop);
@@ -215,13 +217,11 @@ int main(int argc, char *argv[])
       exit(-1);
     }
 
-  compute_bits_in_16bits();
   initializeMask();	
   
   setupInfoFile();
    
   All *tr = CALLOC(1,sizeof(All));
-  tr->numBranches = 1;
   pruneTaxaFromTreeset(bootTreesFileName, bestTreeFileName, excludeFileName, tr);
 
   return 0;
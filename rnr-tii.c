@@ -40,11 +40,11 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "common.h"
 #include "BitVector.h"
 #include "Tree.h"
-#include "List.h"
 #include "sharedVariables.h"
 
 #define PROG_NAME  "RnR-tii"
@@ -56,181 +56,554 @@ typedef unsigned short int nodeDistance_t;
 
 double tiiZ = 2.; 
 
-typedef struct _distanceElem 
+/* assumes that a < b */
+#define PAIR_INDEX(n,a,b) ((size_t)(a) * (2 * (n) - (a) - 1) / 2 + (b) - (a) - 1)
+
+
+/* 
+   scratch space to compute the pairwise distances of the tips of a
+   tree, reused for all trees. The tips below a node form a range in
+   tips, depths holds their distance to the node above.
+*/
+typedef struct
+{
+  int *tips; 
+  nodeDistance_t *depths; 
+  struct 
+  {
+    nodeptr p; 
+    int begin; 
+    int middle; 
+    int childrenDone; 
+  } *stack; 
+} DistanceScratch; 
+
+
+DistanceScratch *createDistanceScratch(int mxtips)
+{
+  DistanceScratch
+    *result = CALLOC(1, sizeof(DistanceScratch)); 
+
+  result->tips = CALLOC(mxtips, sizeof(int));
+  result->depths = CALLOC(mxtips, sizeof(nodeDistance_t));
+  result->stack = CALLOC(mxtips, sizeof(*(result->stack)));
+
+  return result; 
+}
+
+
+void freeDistanceScratch(DistanceScratch *scratch)
 {
-  nodeptr node;
-  nodeDistance_t distance; 
-} DistanceElem;
+  free(scratch->tips);
+  free(scratch->depths);
+  free(scratch->stack);
+  free(scratch);
+}
+
+
+/* 
+   computes the number of branches between all pairs of tips by an
+   iterative post order traversal, starting from the tip start. When
+   both subtrees of a node are done, every tip on the left is paired
+   with every tip on the right.
+*/
+void gatherDistances(All *tr, nodeptr start, nodeDistance_t *distances, DistanceScratch *scratch) 
+{
+  int 
+    a, b,
+    top = 0,
+    numberOfTips = 0; 
+
+  scratch->stack[0].p = start->back; 
+  scratch->stack[0].begin = 0; 
+  scratch->stack[0].childrenDone = 0; 
+
+  while(top >= 0)
+    {
+      nodeptr 
+	child; 
+
+      if(scratch->stack[top].childrenDone == 2)
+	{
+	  int 
+	    begin = scratch->stack[top].begin,
+	    middle = scratch->stack[top].middle; 
+
+	  for(a = begin; a < middle; ++a)
+	    for(b = middle; b < numberOfTips; ++b)
+	      {
+		int 
+		  x = scratch->tips[a],
+		  y = scratch->tips[b]; 
+
+		if(y < x)
+		  SWAP(x,y);
+
+		assert(x != y);
+		distances[PAIR_INDEX(tr->mxtips,x,y)] = scratch->depths[a] + scratch->depths[b];
+	      }
+
+	  for(a = begin; a < numberOfTips; ++a)
+	    scratch->depths[a]++; 
+
+	  --top; 
+	  continue; 
+	}
+
+      if(scratch->stack[top].childrenDone == 0)
+	child = scratch->stack[top].p->next->back; 
+      else 
+	{
+	  child = scratch->stack[top].p->next->next->back; 
+	  scratch->stack[top].middle = numberOfTips; 
+	}
+      scratch->stack[top].childrenDone++; 
+
+      if(isTip(child->number, tr->mxtips))
+	{
+	  scratch->tips[numberOfTips] = child->number - 1; 
+	  scratch->depths[numberOfTips] = 1; 
+	  numberOfTips++; 
+	}
+      else 
+	{
+	  ++top; 
+	  assert(top < tr->mxtips);
+	  scratch->stack[top].p = child; 
+	  scratch->stack[top].begin = numberOfTips; 
+	  scratch->stack[top].childrenDone = 0; 
+	}
+    }
+
+  /* the distances to the start */
+  a = start->number - 1; 
+  FOR_0_LIMIT(b, numberOfTips)
+    {
+      int 
+	x = a,
+	y = scratch->tips[b]; 
+
+      if(y < x)
+	SWAP(x,y);
+
+      assert(x != y);
+      distances[PAIR_INDEX(tr->mxtips,x,y)] = scratch->depths[b];
+    }
+}
 
 
-List *gatherDistances(All *tr, nodeptr node, nodeDistance_t **resultBranchDistances, boolean isStart) 
+/* 
+   the distances of every pair of taxa a < b over all trees. A pair
+   either has a histogram (the number of trees in which a and b are d
+   nodes apart, d = 0..mxtips-1) or the distance of a and b in every
+   tree, whichever needs less memory. Entries are as narrow as their
+   largest value permits. The table is allocated once and shared by all
+   threads, only one tree per thread needs to be in memory at a time.
+*/
+typedef struct
+{
+  int mxtips; 
+  int numberOfTrees; 
+  size_t numberOfPairs; 
+  boolean hasHistograms; 
+  int entriesPerPair; 		/* mxtips bins or numberOfTrees distances */
+  int bytesPerEntry; 
+  int maxDistance; 		/* largest distance seen */
+  boolean isShared; 		/* histograms are incremented atomically */
+  void *entries; 
+} DistanceTable; 
+
+
+static int getBytesPerEntry(unsigned int maxValue)
 {
-  List
-    *distancesFromLeft,
-    *distancesFromRight,
-    *iterA, *iterB,
-    *end = NULL;
+  if(maxValue <= UINT8_MAX)
+    return 1; 
+  else if(maxValue <= UINT16_MAX)
+    return 2; 
+  else 
+    return 4; 
+}
+
 
-  if( NOT isTip(node->number, tr->mxtips))
+DistanceTable *createDistanceTable(int mxtips, int numberOfTrees, boolean isShared)
+{
+  DistanceTable
+    *result = CALLOC(1, sizeof(DistanceTable)); 
+  int 
+    bytesPerBin = getBytesPerEntry(numberOfTrees),
+    bytesPerDistance = getBytesPerEntry(mxtips - 1); 
+
+  result->mxtips = mxtips; 
+  result->numberOfTrees = numberOfTrees; 
+  result->numberOfPairs = (size_t)mxtips * (mxtips - 1) / 2; 
+  result->hasHistograms = (size_t)mxtips * bytesPerBin <= (size_t)numberOfTrees * bytesPerDistance; 
+  result->entriesPerPair = result->hasHistograms ? mxtips : numberOfTrees; 
+  result->bytesPerEntry = result->hasHistograms ? bytesPerBin : bytesPerDistance; 
+  result->maxDistance = 0; 
+  result->isShared = isShared; 
+  result->entries = CALLOC(result->numberOfPairs * result->entriesPerPair, result->bytesPerEntry);
+  if( NOT result->entries)
     {
-      /* go down to the tips (DFS) */
-      distancesFromLeft = gatherDistances(tr, node->next->back, resultBranchDistances, FALSE);
-      distancesFromRight = gatherDistances(tr, node->next->next->back, resultBranchDistances, FALSE);
+      printf("ERROR: could not allocate the distances of %d taxa in %d trees.\n", mxtips, numberOfTrees);
+      exit(-1);
     }
-  else if(isStart)
+
+  return result; 
+}
+
+
+void freeDistanceTable(DistanceTable *table)
+{
+  free(table->entries);
+  free(table);
+}
+
+
+#define ADD_DISTANCE(TYPE)						\
+  {									\
+    TYPE								\
+      *entries = (TYPE*)table->entries + pair * table->entriesPerPair; \
+									\
+    if( NOT table->hasHistograms)					\
+      entries[treeNumber] = (TYPE)distance;				\
+    else if(table->isShared)						\
+      __atomic_fetch_add(entries + distance, 1, __ATOMIC_RELAXED);	\
+    else								\
+      entries[distance]++;						\
+  }
+
+static void addDistance(DistanceTable *table, size_t pair, int distance, int treeNumber)
+{
+  switch(table->bytesPerEntry)
     {
-      distancesFromLeft = gatherDistances(tr, node->back->next->back, resultBranchDistances, FALSE);
-      distancesFromRight = gatherDistances(tr, node->back->next->next->back, resultBranchDistances, FALSE);
+    case 1: 
+      ADD_DISTANCE(uint8_t); 
+      break; 
+    case 2: 
+      ADD_DISTANCE(uint16_t); 
+      break; 
+    default: 
+      ADD_DISTANCE(uint32_t); 
     }
-  else
+}
+
+
+static unsigned int getEntry(DistanceTable *table, size_t index)
+{
+  switch(table->bytesPerEntry)
     {
-      /* recursion ends */
-      List *distanceList = CALLOC(1,sizeof(List));
-      distanceList->value = CALLOC(1,sizeof(DistanceElem));
-      ((DistanceElem*)distanceList->value)->node = node; 
-      ((DistanceElem*)distanceList->value)->distance =  1 ; 
-      return distanceList;
+    case 1: 
+      return ((uint8_t*)table->entries)[index]; 
+    case 2: 
+      return ((uint16_t*)table->entries)[index]; 
+    default: 
+      return ((uint32_t*)table->entries)[index]; 
     }
+}
+
+
+/* returns the largest distance of the tree */
+int addTreeToDistanceTable(DistanceTable *table, nodeDistance_t *distances, BitVector *remainingTaxa, int treeNumber)
+{
+  int 
+    j, k,
+    maxDistance = 0; 
 
-  /* compute distances of branches from the right to branches from the left side  */
-  iterA = distancesFromLeft;
-  FOR_LIST(iterA)
+  FOR_0_LIMIT(j,table->mxtips)
     {
-      for(iterB = distancesFromRight; iterB; iterB = iterB->next)
+      size_t
+	firstPair = PAIR_INDEX(table->mxtips, j, j+1); 
+
+      if( NOT NTH_BIT_IS_SET(remainingTaxa, j))
+	continue; 
+
+      for(k = j+1; k < table->mxtips; ++k)
 	{
-	  int
-	    a = ((DistanceElem*)iterA->value)->node->number - 1,
-	    b = ((DistanceElem*)iterB->value)->node->number - 1;
+	  int 
+	    distance = distances[firstPair + k - j - 1]; 
 
-	  if(b < a)
-	    SWAP(a,b);
+	  if( NOT NTH_BIT_IS_SET(remainingTaxa, k))
+	    continue; 
 
-	  assert(a != b );
-	  USE_UPPER_TRIANGLE_TII(resultBranchDistances,a,b) = ((DistanceElem*)iterA->value)->distance  + ((DistanceElem*)iterB->value)->distance;
+	  assert(distance > 0 && distance < table->mxtips);
+	  maxDistance = MAX(maxDistance, distance);
+	  addDistance(table, firstPair + k - j - 1, distance, treeNumber);
 	}
-      
-      if( NOT iterA->next)
-	end = iterA;
     }
 
-  assert(end);
-  end->next = distancesFromRight;
+  return maxDistance; 
+}
 
-  /* adding own value */
-  for(iterA = distancesFromLeft; iterA; iterA = iterA->next)
-    ((DistanceElem*)iterA->value)->distance += 1;
 
-  if(isStart)
+/* the histogram of the distances of a pair, must be zero for distances up to maxDistance */
+static void getHistogramOfPair(DistanceTable *table, size_t pair, unsigned int *histogram)
+{
+  size_t 
+    first = pair * table->entriesPerPair; 
+  int 
+    i; 
+
+  if(table->hasHistograms)
     {
-      int a = node->number - 1;
-      for(iterA = distancesFromLeft; iterA; iterA = iterA->next)
+      for(i = 1; i <= table->maxDistance; ++i)
+	histogram[i] = getEntry(table, first + i); 
+    }
+  else 
+    {
+      FOR_0_LIMIT(i, table->numberOfTrees)
+	histogram[getEntry(table, first + i)]++; 
+    }
+}
+
+
+/* 
+   pow(sum, tiiZ) for all sums of two distances. NOTE: could also be
+   another exponent, but the mesquite guys use this one (emphasises
+   close relationship)
+*/
+double *createPowTable(int maxDistance)
+{
+  int 
+    sum; 
+  double 
+    *result = CALLOC(2 * maxDistance + 1, sizeof(double)); 
+
+  FOR_0_LIMIT(sum, 2 * maxDistance + 1)
+    result[sum] = pow((double)sum, tiiZ);
+
+  return result; 
+}
+
+
+/* 
+   the instability of a pair over all pairs of trees. Pairs of trees
+   with equal distances do not contribute, so it suffices to combine
+   the distinct distances.
+*/
+double getPairInstability(unsigned int *histogram, int maxDistance, double *powTable, int *distinctDistances)
+{
+  int
+    d, 
+    k, l,
+    numberOfDistinct = 0;
+  double 
+    result = 0.0; 
+
+  for(d = 1; d <= maxDistance; ++d)
+    if(histogram[d])
+      distinctDistances[numberOfDistinct++] = d; 
+
+  FOR_0_LIMIT(k, numberOfDistinct)
+    {
+      int 
+	d1 = distinctDistances[k]; 
+
+      for(l = k+1; l < numberOfDistinct; ++l)
 	{
-	  int b = ((DistanceElem*)iterA->value)->node->number -1;
-	  if(b < a)
-	    SWAP(a,b);
-	  assert(b != a);
-	  USE_UPPER_TRIANGLE_TII(resultBranchDistances,a,b) = ((DistanceElem*)iterA->value)->distance;
+	  int 
+	    d2 = distinctDistances[l]; 
+	  
+	  result += (double)histogram[d1] * (double)histogram[d2] * (double)(d2 - d1) / powTable[d1 + d2];
 	}
+    }
+
+  return result; 
+}
+
 
-      /* for(i = 0; i < tr->mxtips; ++i) */
-      /* 	for(j = i+1; j < tr->mxtips; ++j) */
-      /* 	  printf("%d\t%d\t%d\n", i,j,USE_UPPER_TRIANGLE(resultBranchDistances,i,j)); */
+/* a consecutive part of the trees, whose distances are collected by one thread */
+typedef struct
+{
+  TreeReader reader; 
+  All *tr; 
+  BitVector *remainingTaxa; 
+  DistanceTable *distanceTable; 
+  int firstTree; 
+  int maxDistance; 
+} DistanceChunk; 
+
+
+void *collectDistancesOfChunk(void *arg)
+{
+  DistanceChunk
+    *chunk = (DistanceChunk*)arg; 
+  All
+    *tr = chunk->tr; 
+  int 
+    j,
+    maxDistance,
+    treeNumber = chunk->firstTree; 
+  nodeDistance_t 
+    *distances = CALLOC((size_t)tr->mxtips * (tr->mxtips - 1) / 2, sizeof(nodeDistance_t));
+  DistanceScratch
+    *scratch = createDistanceScratch(tr->mxtips); 
+
+  while(hasMoreTrees(&(chunk->reader)))
+    {
+      readBootstrapTree(tr, &(chunk->reader));
+      
+      FOR_0_LIMIT(j,tr->mxtips)
+	if( NOT NTH_BIT_IS_SET(chunk->remainingTaxa, j))
+	  pruneTaxon(tr,j+1, FALSE);
+
+      gatherDistances(tr, tr->nodep[1], distances, scratch);
+      maxDistance = addTreeToDistanceTable(chunk->distanceTable, distances, chunk->remainingTaxa, treeNumber++);
+      chunk->maxDistance = MAX(chunk->maxDistance, maxDistance);
     }
 
-  return distancesFromLeft;
+  freeDistanceScratch(scratch);
+  free(distances);
+
+  return NULL; 
 }
 
 
-double getOneTaxonomicInstability(All *tr, int i, nodeDistance_t ***distances, unsigned int *remainingTaxa)
+/* the pairs of taxa are handed out row by row */
+typedef struct
 {
+  DistanceTable *distanceTable; 
+  BitVector *remainingTaxa; 
+  double *powTable; 
+  double *pairInstab; 
+  int nextTaxon; 
+} InstabilityJob; 
+
+
+void *computePairInstabilities(void *arg)
+{
+  InstabilityJob
+    *job = (InstabilityJob*)arg; 
+  DistanceTable
+    *table = job->distanceTable; 
   int 
-    j,k,l;
-  double
-    taxInstab = 0.0;
+    i, j,
+    *distinctDistances = CALLOC(table->maxDistance + 1, sizeof(int));
+  unsigned int 
+    *histogram = CALLOC(table->maxDistance + 1, sizeof(unsigned int)); 
 
-  FOR_0_LIMIT(j,tr->mxtips)
+  while((i = __sync_fetch_and_add(&(job->nextTaxon), 1)) < table->mxtips)
     {
-      if(j == i || NOT  NTH_BIT_IS_SET(remainingTaxa, j))
-	continue;
-	  
-      FOR_0_LIMIT(k, tr->numberOfTrees)
+      if( NOT NTH_BIT_IS_SET(job->remainingTaxa,i))
+	continue; 
+
+      for(j = i+1; j < table->mxtips; ++j)
 	{
-	  for(l = k+1; l < tr->numberOfTrees; ++l)
-	    {
-	      double
-		d1 = (i < j) ? (double)(USE_UPPER_TRIANGLE_TII(distances[k], i, j)) : (double)(USE_UPPER_TRIANGLE_TII(distances[k], j, i)),
-		d2 = (i < j) ? (double)(USE_UPPER_TRIANGLE_TII(distances[l], i, j)) : (double)(USE_UPPER_TRIANGLE_TII(distances[l], j, i)),
-		diff = (d1 > d2) ? (d1 - d2) : (d2 - d1), 
-		sum = d1 + d2;
-		  
-	      assert( d1 > 0 && d2 > 0);
-	      
-	      taxInstab += diff / pow(sum, tiiZ); /* NOTE: could also be another exponent, but the mesquite 
-						  guys use this one (emphasises close relationship)  */
-	    }
+	  size_t 
+	    pair = PAIR_INDEX(table->mxtips,i,j); 
+
+	  if( NOT NTH_BIT_IS_SET(job->remainingTaxa,j))
+	    continue; 
+
+	  getHistogramOfPair(table, pair, histogram);
+	  job->pairInstab[pair] = getPairInstability(histogram, table->maxDistance, job->powTable, distinctDistances); 
+	  memset(histogram, 0, (table->maxDistance + 1) * sizeof(unsigned int));
 	}
     }
-  
-  return taxInstab;
+
+  free(histogram);
+  free(distinctDistances);
+
+  return NULL; 
 }
 
 
-void getTaxonomicInstability(All *tr, char *treesFileName, char *excludeFile)
+/* 
+   runs function on numberOfThreads threads (the calling thread is
+   thread 0). Thread t gets arguments + t * stride, a stride of 0
+   shares the arguments.
+*/
+static void runThreads(void *(*function)(void*), void *arguments, size_t stride, int numberOfThreads)
+{
+  pthread_t
+    *threads = CALLOC(numberOfThreads, sizeof(pthread_t)); 
+  int 
+    t; 
+
+  for(t = 1; t < numberOfThreads; ++t)
+    if(pthread_create(threads + t, NULL, function, (char*)arguments + t * stride))
+      {
+	printf("ERROR: could not create thread %d\n", t);
+	exit(-1);
+      }
+  function(arguments);
+  for(t = 1; t < numberOfThreads; ++t)
+    pthread_join(threads[t], NULL);
+
+  free(threads);
+}
+
+
+void getTaxonomicInstability(All *tr, char *treesFileName, char *excludeFile, int numberOfThreads)
 {
   FILE
-    *outf = getOutputFileFromString("taxonomicInstabilityIndex"),
-    *treesFile = getNumberOfTrees(tr, treesFileName);
+    *outf = getOutputFileFromString("taxonomicInstabilityIndex");
+
+  TreeReader
+    *treesFile = getNumberOfTrees(tr, treesFileName),
+    *views;
 
   BitVector
     *neglectThose = neglectThoseTaxa(tr, excludeFile);
   
   int 
-    i,j,k;
-  nodeDistance_t 
-    ***distances = CALLOC(tr->numberOfTrees, sizeof(nodeDistance_t**));
-
-  List
-    *iter;
-
-  rewind(treesFile);
-  
-  FOR_0_LIMIT(i,tr->numberOfTrees)
+    i,j,t;
+  DistanceChunk
+    *chunks = CALLOC(numberOfThreads, sizeof(DistanceChunk)); 
+  DistanceTable
+    *distanceTable; 
+  InstabilityJob
+    job; 
+  double
+    *taxInstab = CALLOC(tr->mxtips, sizeof(double));
+
+  /* calculate distances, every thread parses its own part of the trees */
+  distanceTable = createDistanceTable(tr->mxtips, tr->numberOfTrees, numberOfThreads > 1); 
+  views = CALLOC(numberOfThreads, sizeof(TreeReader));
+  rewindTreeReader(treesFile);
+  splitTreeReader(treesFile, views, numberOfThreads);
+  FOR_0_LIMIT(t, numberOfThreads)
     {
-      distances[i] = CALLOC(tr->mxtips,  sizeof(nodeDistance_t*));
-      for(j = 0; j < tr->mxtips; ++j)
-	distances[i][j] = CALLOC(tr->mxtips - j, sizeof(nodeDistance_t));
+      chunks[t].reader = views[t]; 
+      chunks[t].tr = (t == 0) ? tr : copyTreeSkeleton(tr); 
+      chunks[t].remainingTaxa = neglectThose; 
+      chunks[t].distanceTable = distanceTable; 
+      chunks[t].firstTree = (t == 0) ? 0 : chunks[t-1].firstTree + countTreesInReader(views + t - 1); 
     }
-  
-  /* calculate distances */
-  FOR_0_LIMIT(i,tr->numberOfTrees)    
-    {
-      readBootstrapTree(tr, treesFile);
-      
-      FOR_0_LIMIT(j,tr->mxtips)
-	if( NOT NTH_BIT_IS_SET(neglectThose, j))
-	  pruneTaxon(tr,j+1, FALSE);
+  free(views);
 
-      /* assert that we get the right labels */
-      iter = gatherDistances(tr, tr->nodep[1], distances[i], TRUE);
-      freeList(iter);
-      
-      FOR_0_LIMIT(j,tr->mxtips)	
-	for(k = j+1; k < tr->mxtips; ++k)
-	  {
-	    if( NOT USE_UPPER_TRIANGLE_TII(distances[i],j,k))
-	      printf("%s\t%s\t%d\t%d\n", tr->nameList[j+1], tr->nameList[k+1], j,k);
-	    assert(USE_UPPER_TRIANGLE_TII(distances[i],j,k));
-	  }
+  runThreads(collectDistancesOfChunk, chunks, sizeof(DistanceChunk), numberOfThreads);
+
+  FOR_0_LIMIT(t, numberOfThreads)
+    {
+      distanceTable->maxDistance = MAX(distanceTable->maxDistance, chunks[t].maxDistance); 
+      if(t > 0)
+	freeTreeSkeleton(chunks[t].tr);
     }
+  free(chunks);
 
   /* calculate taxonomic instability */
+  job.distanceTable = distanceTable; 
+  job.remainingTaxa = neglectThose; 
+  job.powTable = createPowTable(distanceTable->maxDistance);
+  job.pairInstab = CALLOC(distanceTable->numberOfPairs, sizeof(double));
+  job.nextTaxon = 0; 
+  runThreads(computePairInstabilities, &job, 0, numberOfThreads);
+
+  /* reduce in a fixed order, such that the result does not depend on the number of threads */
+  FOR_0_LIMIT(i,tr->mxtips)
+    for(j = i+1; j < tr->mxtips; ++j)
+      if(NTH_BIT_IS_SET(neglectThose,i) && NTH_BIT_IS_SET(neglectThose,j))
+	{
+	  taxInstab[i] += job.pairInstab[PAIR_INDEX(tr->mxtips,i,j)]; 
+	  taxInstab[j] += job.pairInstab[PAIR_INDEX(tr->mxtips,i,j)]; 
+	}
+
   FOR_0_LIMIT(i,tr->mxtips)
     {
       if(NTH_BIT_IS_SET(neglectThose,i))
 	{
-	  double tii = getOneTaxonomicInstability(tr, i, distances, neglectThose);
-	  PR("%s\t%f\n", tr->nameList[i+1], tii);
-	  fprintf(outf, "%s\t%f\n", tr->nameList[i+1], tii);
+	  PR("%s\t%f\n", tr->nameList[i+1], taxInstab[i]);
+	  fprintf(outf, "%s\t%f\n", tr->nameList[i+1], taxInstab[i]);
 	}
       else
 	{
@@ -238,14 +611,21 @@ void getTaxonomicInstability(All *tr, char *treesFileName, char *excludeFile)
 	  fprintf(outf, "%s\tNA\n", tr->nameList[i+1]);
 	}
     }  
+
+  free(job.powTable);
+  free(job.pairInstab);
+  free(taxInstab);
+  free(neglectThose);
+  freeDistanceTable(distanceTable);
   fclose(outf);
+  closeTreeReader(treesFile);
 }
 
 
 void printHelpFile()
 { 
   printVersionInfo(FALSE);
-  printf("This program computes the taxonomic instability index.\n\nSYNTAX: ./%s -i <bootTrees> -n <runId> [-w <workingDir>] [-h] [-x <excludeFile>]\n", lowerTheString(programName));
+  printf("This program computes the taxonomic instability index.\n\nSYNTAX: ./%s -i <bootTrees> -n <runId> [-w <workingDir>] [-h] [-x <excludeFile>] [-T <num>]\n", lowerTheString(programName));
   printf("\nOBLIGATORY:\n");
   printf("-i <bootTrees>\n\tA collection of bootstrap trees.\n");
   printf("-n <runId>\n\tAn identifier for this run.\n");
@@ -253,6 +633,7 @@ void printHelpFile()
   printf("-z <z>\n\tThe exponent used in the TII formula. Use small values to emphasize close relationships and vice versa. DEFAULT: 2\n");
   printf("-w <workDir>\n\tA working directory where output files are created.\n");
   printf("-x <excludeFile>\n\tExclude the taxa in this file (one taxon per line) prior to computing the TII.\n");
+  printf("-T <num>\n\tParse the trees and compute the TII with <num> threads. DEFAULT: 1\n");
   printf("-h\n\tThis help file.\n");
 }
 
@@ -264,13 +645,14 @@ int main(int argc, char *argv[])
   programReleaseDate = PROG_RELEASE_DATE; 
 
   int
-    c;
+    c,
+    numberOfThreads = 1;
 
   char
     *excludeFile = "",
     *bootTrees = "";
 
-   while ((c = getopt (argc, argv, "hi:n:x:w:z:")) != -1)
+   while ((c = getopt (argc, argv, "hi:n:x:w:z:T:")) != -1)
     {
       switch(c)
 	{
@@ -289,6 +671,14 @@ int main(int argc, char *argv[])
 	case 'z':
 	  tiiZ = wrapStrToL(optarg); 
 	  break;
+	case 'T':
+	  numberOfThreads = wrapStrToL(optarg);
+	  if(numberOfThreads < 1)
+	    {
+	      printf("Please specify a positive number of threads via -T.\n");
+	      exit(-1);
+	    }
+	  break;
 	case 'h':
 	default:	
 	  {
@@ -312,7 +702,6 @@ int main(int argc, char *argv[])
       exit(-1);
     }
 
-  compute_bits_in_16bits();
   initializeMask();
 
   All 
@@ -324,7 +713,9 @@ int main(int argc, char *argv[])
       exit(-1);
     }     
 
-  getTaxonomicInstability(tr, bootTrees, excludeFile);
+  tr->bitVectorLength = GET_BITVECTOR_LENGTH(tr->mxtips);
+
+  getTaxonomicInstability(tr, bootTrees, excludeFile, numberOfThreads);
 
   return 0;
 }